@@ -179,21 +179,24 @@ static pico_status_t acphInitialize(register picodata_ProcessingUnit this, picoo
     acph->cbufBufSize = PICOACPH_MAXSIZE_CBUF;
     acph->cbufLen = 0;
 
-    /* init headx, cbuf */
-    for (i = 0; i < PICOACPH_MAXNR_HEADX; i++){
-        acph->headx[i].head.type = 0;
-        acph->headx[i].head.info1 = 0;
-        acph->headx[i].head.info2 = 0;
-        acph->headx[i].head.len = 0;
-        acph->headx[i].cind = 0;
-        acph->headx[i].boundstrength = 0;
-        acph->headx[i].boundtype = 0;
-    }
-    for (i = 0; i < PICOACPH_MAXSIZE_CBUF; i++) {
-        acph->cbuf[i] = 0;
+    /* init headx, cbuf; not needed between utterances because only the
+       entries below headxLen and cbufLen are ever read */
+    if (resetMode != PICO_RESET_UTTERANCE) {
+        for (i = 0; i < PICOACPH_MAXNR_HEADX; i++){
+            acph->headx[i].head.type = 0;
+            acph->headx[i].head.info1 = 0;
+            acph->headx[i].head.info2 = 0;
+            acph->headx[i].head.len = 0;
+            acph->headx[i].cind = 0;
+            acph->headx[i].boundstrength = 0;
+            acph->headx[i].boundtype = 0;
+        }
+        for (i = 0; i < PICOACPH_MAXSIZE_CBUF; i++) {
+            acph->cbuf[i] = 0;
+        }
     }
 
-    if (resetMode == PICO_RESET_SOFT) {
+    if (resetMode != PICO_RESET_FULL) {
         /*following initializations needed only at startup or after a full reset*/
         return PICO_OK;
     }
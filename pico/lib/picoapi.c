@@ -106,7 +106,7 @@ pico_Status pico_initialize_priv(
                 if ((sysEM != NULL) && (sys->common != NULL) && (sys->rm != NULL)) {
                     sys->common->em = sysEM;
                     sys->common->mm = sysMM;
-                    sys->engine = NULL;
+                    picoos_mem_set(sys->engine, 0, sizeof(sys->engine));
 
                     picorsrc_createDefaultResource(sys->rm /*,&defaultResource */);
 
@@ -163,6 +163,7 @@ PICO_FUNC pico_terminate(
         )
 {
     pico_Status status = PICO_OK;
+    picoos_int32 i;
 
     if ((system == NULL) || !is_valid_system_handle(*system)) {
         status = PICO_ERR_INVALID_HANDLE;
@@ -170,7 +171,9 @@ PICO_FUNC pico_terminate(
         pico_System sys = *system;
 
         /* close engine(s) */
-        picoctrl_disposeEngine(sys->common->mm, sys->rm, &sys->engine);
+        for (i = 0; i < PICO_MAX_NUM_ENGINES; i++) {
+            picoctrl_disposeEngine(sys->common->mm, sys->rm, &sys->engine[i]);
+        }
 
         /* close all resources */
         picorsrc_disposeResourceManager(sys->common->mm, &sys->rm);
@@ -512,6 +515,7 @@ PICO_FUNC pico_newEngine(
         )
 {
     pico_Status status = PICO_OK;
+    picoos_int32 i;
 
     PICODBG_DEBUG(("creating engine for voice '%s'", (picoos_char *) voiceName));
 
@@ -525,17 +529,22 @@ PICO_FUNC pico_newEngine(
         status = PICO_ERR_NULLPTR_ACCESS;
     } else {
         picoos_emReset(system->common->em);
-        if (system->engine == NULL) {
+        /* engines of one system share its resources; find a free slot */
+        i = 0;
+        while ((i < PICO_MAX_NUM_ENGINES) && (system->engine[i] != NULL)) {
+            i++;
+        }
+        if (i < PICO_MAX_NUM_ENGINES) {
             *outEngine = (pico_Engine) picoctrl_newEngine(system->common->mm, system->rm, voiceName);
             if (*outEngine != NULL) {
-                system->engine = (picoctrl_Engine) *outEngine;
+                system->engine[i] = (picoctrl_Engine) *outEngine;
             } else {
                 status = picoos_emRaiseException(system->common->em, PICO_EXC_OUT_OF_MEM,
                             (picoos_char *) "out of memory creating new engine", NULL);
             }
         } else {
             status = picoos_emRaiseException(system->common->em, PICO_EXC_MAX_NUM_EXCEED,
-                        NULL, (picoos_char *) "no more than %i engines", 1);
+                        NULL, (picoos_char *) "no more than %i engines", PICO_MAX_NUM_ENGINES);
         }
     }
 
@@ -557,6 +566,7 @@ PICO_FUNC pico_disposeEngine(
         )
 {
     pico_Status status = PICO_OK;
+    picoos_int32 i;
 
     if (!is_valid_system_handle(system)) {
         status = PICO_ERR_INVALID_HANDLE;
@@ -566,8 +576,12 @@ PICO_FUNC pico_disposeEngine(
         status = PICO_ERR_INVALID_HANDLE;
     } else {
         picoos_emReset(system->common->em);
+        for (i = 0; i < PICO_MAX_NUM_ENGINES; i++) {
+            if (system->engine[i] == (picoctrl_Engine) *inoutEngine) {
+                system->engine[i] = NULL;
+            }
+        }
         picoctrl_disposeEngine(system->common->mm, system->rm, (picoctrl_Engine *) inoutEngine);
-        system->engine = NULL;
         status = picoos_emGetExceptionCode(system->common->em);
     }
 
@@ -660,7 +674,8 @@ PICO_FUNC pico_getData(
 /**
  * pico_resetEngine : Resets the engine
  * @param    engine : pointer to a Pico engine handle
- * @param resetMode : reset mode; one of PICO_RESET_FULL or PICO_RESET_SOFT
+ * @param resetMode : reset mode; one of PICO_RESET_FULL, PICO_RESET_SOFT or
+ *                    PICO_RESET_UTTERANCE
  * @return  PICO_OK : successful
  * @return     PICO_ERR_INVALID_HANDLE, PICO_ERR_NULLPTR_ACCESS : errors
  * @callgraph
@@ -677,7 +692,9 @@ PICO_FUNC pico_resetEngine(
     } else {
         picoctrl_engResetExceptionManager((picoctrl_Engine) engine);
 
-        resetMode = (PICO_RESET_SOFT == resetMode) ? PICO_RESET_SOFT : PICO_RESET_FULL;
+        if ((PICO_RESET_SOFT != resetMode) && (PICO_RESET_UTTERANCE != resetMode)) {
+            resetMode = PICO_RESET_FULL;
+        }
 
         status = picoctrl_engReset((picoctrl_Engine) engine, (picoos_int32)resetMode);
     }
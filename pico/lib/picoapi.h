@@ -345,8 +345,10 @@ PICO_FUNC pico_releaseVoiceDefinition(
 
 /**
    Creates and initializes a new Pico engine instance and returns its
-   handle in 'outEngine'. Only one instance per system is currently
-   possible.
+   handle in 'outEngine'. Up to PICO_MAX_NUM_ENGINES instances, each
+   with its own voice, can be created per system; they share the
+   resources loaded into the system, so switching between voices only
+   means switching between engines.
 */
 PICO_FUNC pico_newEngine(
         pico_System system,
@@ -422,6 +424,10 @@ PICO_FUNC pico_getData(
    particular text input and signal data output buffers.
    'resetMode' is one of 'PICO_RESET_SOFT', to be used to flush the engine,
    or 'PICO_RESET_FULL', to reset the engine after an engine error.
+   'PICO_RESET_UTTERANCE' flushes the engine like 'PICO_RESET_SOFT' but
+   only clears the processing state the current utterance has used, so
+   it is cheap enough to be called at every utterance boundary or when
+   the user interrupts the output.
 */
 PICO_FUNC pico_resetEngine(
         pico_Engine engine,
@@ -51,7 +51,7 @@ typedef struct pico_system {
     picoos_uint32 magic;        /* magic number used to validate handles */
     picoos_Common common;
     picorsrc_ResourceManager rm;
-    picoctrl_Engine engine;
+    picoctrl_Engine engine[PICO_MAX_NUM_ENGINES];
 } pico_system_t;
 
 
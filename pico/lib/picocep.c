@@ -70,7 +70,6 @@ extern "C" {
 }
 #endif
 
-#define PICOCEP_MAXWINLEN 10000  /* maximum number of frames that can be smoothed, i.e. maximum sentence length */
 #define PICOCEP_MSGSTR_SIZE 32
 #define PICOCEP_IN_BUFF_SIZE PICODATA_BUFSIZE_DEFAULT
 
@@ -243,7 +242,7 @@ typedef struct cep_subobj
 
 static void initSmoothing(cep_subobj_t * cep);
 
-static picoos_int32 getFromPdf(picokpdf_PdfMUL pdf, picoos_uint32 vecstart,
+static picoos_int32 getFromPdf(picokpdf_PdfMUL pdf, picoos_uint16 vecind,
         picoos_uint8 cepnum, picocep_WantMeanOrIvar_t wantMeanOrIvar,
         picocep_WantStaticOrDelta_t wantStaticOrDeltax);
 
@@ -962,11 +961,10 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
 {
     picoos_uint16 Id[2], Idd[3];
     /*picoos_uint32      vecstart, k;*/
-    picoos_uint32 vecstart;
+    picoos_uint16 vecind;
     picoos_int32 *x = NULL, *xsq = NULL;
     picoos_int32 mean, ivar;
     picoos_uint16 i, j, numd = 0, numdd = 0;
-    picoos_uint8 vecsize = pdf->vecsize;
     picoos_int32 prev_WUm, prev_diag0, prev_diag1, prev_diag1_1, prev_diag2;
 
     prev_WUm = prev_diag0 = prev_diag1 = prev_diag1_1 = prev_diag2 = 0;
@@ -1011,23 +1009,23 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
             cep->diag0[i] = prev_diag0;
             cep->WUm[i] = prev_WUm;
         } else {
-            vecstart = indices[b + i] * vecsize;
-            ivar = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTIVAR,
+            vecind = indices[b + i];
+            ivar = getFromPdf(pdf, vecind, cepnum, PICOCEP_WANTIVAR,
                     PICOCEP_WANTSTATIC);
             prev_diag0 = cep->diag0[i] = ivar << 2; /* multiply ivar by 4 (4 used to be first entry of xsq) */
-            mean = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTMEAN,
+            mean = getFromPdf(pdf, vecind, cepnum, PICOCEP_WANTMEAN,
                     PICOCEP_WANTSTATIC);
             prev_WUm = cep->WUm[i] = mean << 1; /* multiply mean by 2 (2 used to be first entry of x) */
         }
 
         /* process delta means and delta inverse variances */
         for (j = 0; j < numd; j++) {
-            vecstart = indices[b + Id[j]] * vecsize;
-            ivar = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTIVAR,
+            vecind = indices[b + Id[j]];
+            ivar = getFromPdf(pdf, vecind, cepnum, PICOCEP_WANTIVAR,
                     PICOCEP_WANTDELTA);
             cep->diag0[i] += xsq[j] * ivar;
 
-            mean = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTMEAN,
+            mean = getFromPdf(pdf, vecind, cepnum, PICOCEP_WANTMEAN,
                     PICOCEP_WANTDELTA);
             if (mean != 0) {
                 cep->WUm[i] += x[j] * mean;
@@ -1036,12 +1034,12 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
 
         /* process delta delta means and delta delta inverse variances */
         for (j = 0; j < numdd; j++) {
-            vecstart = indices[b + Idd[j]] * vecsize;
-            ivar = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTIVAR,
+            vecind = indices[b + Idd[j]];
+            ivar = getFromPdf(pdf, vecind, cepnum, PICOCEP_WANTIVAR,
                     PICOCEP_WANTDELTA2);
             cep->diag0[i] += xsq[numd + j] * ivar;
 
-            mean = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTMEAN,
+            mean = getFromPdf(pdf, vecind, cepnum, PICOCEP_WANTMEAN,
                     PICOCEP_WANTDELTA2);
             if (mean != 0) {
                 cep->WUm[i] += x[numd + j] * mean;
@@ -1057,12 +1055,12 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
                 if (i > 0 && indices[b + i + 1] == indices[b + i]) {
                     cep->diag1[i] = prev_diag1;
                 } else {
-                    vecstart = indices[b + i + 1] * vecsize;
+                    vecind = indices[b + i + 1];
                     /*
-                     diag1[i] = getFromPdf(pdf, vecstart, numvuv, ceporder, numdeltas, cepnum,
+                     diag1[i] = getFromPdf(pdf, vecind, numvuv, ceporder, numdeltas, cepnum,
                      bigpow, meanpowUm, ivarpow, PICOCEP_WANTIVAR, PICOCEP_WANTDELTA2);
                      */
-                    prev_diag1 = cep->diag1[i] = getFromPdf(pdf, vecstart,
+                    prev_diag1 = cep->diag1[i] = getFromPdf(pdf, vecind,
                             cepnum, PICOCEP_WANTIVAR, PICOCEP_WANTDELTA2);
                 }
                 /*
@@ -1077,13 +1075,13 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
                 if (i > 1 && indices[b + i] == indices[b + i - 1]) {
                     cep->diag1[i] += prev_diag1_1;
                 } else {
-                    vecstart = indices[b + i] * vecsize;
+                    vecind = indices[b + i];
                     /*
                      k = vecstart + pdf->numvuv + pdf->ceporder * 2 + pdf->numdeltas * 3 + pdf->ceporder * 2 + cepnum;
                      cep->diag1[i] += (picoos_int32)(pdf->content[k]) << pdf->bigpow; */
                     /* cepnum'th delta delta ivar */
 
-                    prev_diag1_1 = getFromPdf(pdf, vecstart, cepnum,
+                    prev_diag1_1 = getFromPdf(pdf, vecind, cepnum,
                             PICOCEP_WANTIVAR, PICOCEP_WANTDELTA2);
                     cep->diag1[i] += prev_diag1_1;
                 }
@@ -1098,16 +1096,16 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
         if (i > 0 && indices[b + i + 1] == indices[b + i]) {
             cep->diag2[i] = prev_diag2;
         } else {
-            vecstart = indices[b + i + 1] * vecsize;
+            vecind = indices[b + i + 1];
             /*
              k = vecstart + pdf->numvuv + pdf->ceporder * 2 + pdf->numdeltas * 3 + pdf->ceporder * 2 + cepnum;
              cep->diag2[i] = (picoos_int32)(pdf->content[k]) << pdf->bigpow;
              k -= pdf->ceporder;
              ivar = (picoos_int32)(pdf->content[k]) << pdf->bigpow;
              */
-            cep->diag2[i] = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTIVAR,
+            cep->diag2[i] = getFromPdf(pdf, vecind, cepnum, PICOCEP_WANTIVAR,
                     PICOCEP_WANTDELTA2);
-            ivar = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTIVAR,
+            ivar = getFromPdf(pdf, vecind, cepnum, PICOCEP_WANTIVAR,
                     PICOCEP_WANTDELTA);
             cep->diag2[i] -= (ivar + 2) / 4;
             prev_diag2 = cep->diag2[i];
@@ -1119,8 +1117,8 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
 
 /**
  * Retrieve actual values for MGC from PDF resource
- * @param    pdf :  pointer to picoos_uint8, sequence of pdf vectors, each vector of length 1+ceporder*2+numdeltas*3+ceporder*3
- * @param    vecstart : indices of pdf vectors for all frames in current sentence
+ * @param    pdf :  the mul pdf, expanded or packed (see picokpdf_expandPdfMUL)
+ * @param    vecind : index of the pdf vector
  * @param    cepnum :  cepstral dimension to be treated
  * @param    wantMeanOrIvar :  flag to select mean or variance values
  * @param    wantStaticOrDeltax :  flag to select static or delta values
@@ -1128,16 +1126,23 @@ static picoos_uint8 makeWUWandWUm(cep_subobj_t * cep, picokpdf_PdfMUL pdf,
  * @callgraph
  * @callergraph
  */
-static picoos_int32 getFromPdf(picokpdf_PdfMUL pdf, picoos_uint32 vecstart,
+static picoos_int32 getFromPdf(picokpdf_PdfMUL pdf, picoos_uint16 vecind,
         picoos_uint8 cepnum, picocep_WantMeanOrIvar_t wantMeanOrIvar,
         picocep_WantStaticOrDelta_t wantStaticOrDeltax)
 {
     picoos_uint8 s, ind;
     picoos_uint8 *p;
     picoos_uint8 ceporder, ceporder2, cc;
-    picoos_uint32 k;
+    picoos_uint32 k, vecstart;
     picoos_int32 mean = 0, ivar = 0;
 
+    if (NULL != pdf->expanded) {
+        /* expanded pdf: one plane per group and stream */
+        return PICOKPDF_EXP_ROW(pdf, ((wantMeanOrIvar == PICOCEP_WANTMEAN)
+                ? PICOKPDF_EXP_MEAN : PICOKPDF_EXP_IVAR) + wantStaticOrDeltax,
+                vecind)[cepnum];
+    }
+    vecstart = (picoos_uint32) vecind * pdf->vecsize;
     if (pdf->numdeltas == 0xFF) {
         switch (wantMeanOrIvar) {
             case PICOCEP_WANTMEAN:
@@ -1307,10 +1312,9 @@ static void getDirect(picokpdf_PdfMUL pdf, picoos_uint16 *indices,
 {
     picoos_uint16 i;
     picoos_uint32 j;
-    picoos_uint32 vecstart;
+    picoos_uint16 vecind;
     picoos_int32 mean, ivar;
     picoos_int32 prev_mean;
-    picoos_uint8 vecsize = pdf->vecsize;
     picoos_uint8 order = pdf->ceporder;
 
     j = cepnum;
@@ -1319,10 +1323,10 @@ static void getDirect(picokpdf_PdfMUL pdf, picoos_uint16 *indices,
         if (i > 0 && indices[i] == indices[i - 1]) {
             mean = prev_mean;
         } else {
-            vecstart = indices[i] * vecsize;
-            mean = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTMEAN,
+            vecind = indices[i];
+            mean = getFromPdf(pdf, vecind, cepnum, PICOCEP_WANTMEAN,
                     PICOCEP_WANTSTATIC);
-            ivar = getFromPdf(pdf, vecstart, cepnum, PICOCEP_WANTIVAR,
+            ivar = getFromPdf(pdf, vecind, cepnum, PICOCEP_WANTIVAR,
                     PICOCEP_WANTSTATIC);
             prev_mean = mean = picocep_fixptdiv(mean, ivar, pdf->bigpow);
         }
@@ -1372,6 +1376,28 @@ static picoos_uint16 get_pi_uint16(picoos_uint8 * buf, picoos_uint16 *pos)
     *pos += 2;
     return res;
 }
+/**
+ * Returns the number of frames of a phone item
+ * @param    cep :  the CEP PU sub object pointer
+ * @param    ihead : pointer to the head of the phone item
+ * @return   the sum of the frames of all states
+ * @callgraph
+ * @callergraph
+ */
+static picoos_uint32 phone_frames(cep_subobj_t * cep, picodata_itemhead_t * ihead)
+{
+    picoos_uint32 frames;
+    picoos_uint16 state, pos;
+
+    frames = 0;
+    pos = cep->inReadPos + PICODATA_ITEM_HEADSIZE;
+    for (state = 0; state < ihead->info2; state++) {
+        frames += get_pi_uint16(cep->inBuf, &pos);
+        pos += 4; /* lf0 and mgc index */
+    }
+    return frames;
+}
+
 /**
  * Looks up indices of one phone item and fills index buffers. Consumes Item
  * @param    cep :  the CEP PU sub object pointer
@@ -1608,6 +1634,17 @@ static picodata_step_result_t cepStep(register picodata_ProcessingUnit this,
                     PICODBG_DEBUG(("cep: PARSE found sentence terminator; setting activeEndPos to %i",cep->activeEndPos));
                     cep->procState = PICOCEP_STEPSTATE_PROCESS_SMOOTH;
                     break;
+                } else if ((PICODATA_ITEM_PHONE == ihead.type)
+                        && (cep->indexWritePos > 0)
+                        && (cep->indexWritePos + phone_frames(cep, &ihead) > PICOCEP_MAXWINLEN)) {
+                    /* the phone does not fit into the index buffers: smooth and
+                     * output the frames so far as if the sentence ended here and
+                     * treat the phone (not consumed yet) in a new window */
+                    cep->activeEndPos = cep->indexWritePos;
+                    cep->sentenceEnd = TRUE;
+                    PICODBG_DEBUG(("cep: PARSE found full buffer; setting activeEndPos to %i",cep->activeEndPos));
+                    cep->procState = PICOCEP_STEPSTATE_PROCESS_SMOOTH;
+                    break;
                 } else if (PICODATA_ITEM_PHONE == ihead.type) {
                     /* it is a phone */
                     PICODBG_DEBUG(("cep: PARSE treating PHONE"));
@@ -1710,6 +1747,10 @@ static picodata_step_result_t cepStep(register picodata_ProcessingUnit this,
                     /* smooth f0 */
                     pdf = cep->pdflfz;
                     for (cepnum = 0; cepnum < pdf->ceporder; cepnum++) {
+                        if (picopal_atomic_get(&this->common->cancel)) {
+                            /* give up the smoothing; the engine is reset before it steps again */
+                            return PICODATA_PU_IDLE;
+                        }
                         if (cep->activeEndPos <= 0) {
                             /* do nothing */
                         } else if (3 < N) {
@@ -1727,6 +1768,10 @@ static picodata_step_result_t cepStep(register picodata_ProcessingUnit this,
                     /* smooth mgc */
                     pdf = cep->pdfmgc;
                     for (cepnum = 0; cepnum < pdf->ceporder; cepnum++) {
+                        if (picopal_atomic_get(&this->common->cancel)) {
+                            /* give up the smoothing; the engine is reset before it steps again */
+                            return PICODATA_PU_IDLE;
+                        }
                         if (cep->activeEndPos <= 0) {
                             /* do nothing */
                         } else if (3 < N) {
@@ -40,6 +40,8 @@ extern "C" {
 }
 #endif
 
+#define PICOCEP_MAXWINLEN 10000  /* maximum number of frames that can be smoothed, i.e. maximum sentence length */
+
 /* ******************************************************************************
  *   items related to the generic interface
  ********************************************************************************/
@@ -31,6 +31,7 @@
 #include "picodbg.h"
 #include "picodata.h"
 #include "picorsrc.h"
+#include "picokpdf.h"
 
 /* processing unit definitions */
 #include "picotok.h"
@@ -78,6 +79,7 @@ typedef struct ctrl_subobj {
     picoos_uint8 curPU;
     picoos_uint8 lastItemTypeProduced;
     picodata_ProcessingUnit procUnit [PICOCTRL_MAX_PROC_UNITS];
+    picoos_uint8 procType [PICOCTRL_MAX_PROC_UNITS];
     picodata_step_result_t procStatus [PICOCTRL_MAX_PROC_UNITS];
     picodata_CharBuffer procCbOut [PICOCTRL_MAX_PROC_UNITS];
 } ctrl_subobj_t;
@@ -147,6 +149,11 @@ static picodata_step_result_t ctrlStep(register picodata_ProcessingUnit this,
     *bytesOutput = 0;
     ctrl->lastItemTypeProduced=0; /*no item produced by default*/
 
+    /* a cancelled engine does no more steps until it is reset */
+    if (picopal_atomic_get(&this->common->cancel)) {
+        return PICODATA_PU_IDLE;
+    }
+
     /* --------------------- */
     /* do step of current pu */
     /* --------------------- */
@@ -332,6 +339,7 @@ static pico_status_t ctrlAddPU(register picodata_ProcessingUnit this,
         }
     }
     ctrl->procStatus[newPU] = PICODATA_PU_IDLE;
+    ctrl->procType[newPU] = (picoos_uint8) puType;
     /*...............*/
     switch (puType) {
     case PICODATA_PUTYPE_TOK:
@@ -421,6 +429,7 @@ picodata_ProcessingUnit picoctrl_newControl(picoos_MemoryManager mm,
         picoos_Common common, picodata_CharBuffer cbIn,
         picodata_CharBuffer cbOut, picorsrc_Voice voice) {
     picoos_int16 i;
+    picoos_bool front, back;
     register ctrl_subobj_t * ctrl;
     picodata_ProcessingUnit this = picodata_newProcessingUnit(mm, common, cbIn,
             cbOut,voice);
@@ -448,16 +457,21 @@ picodata_ProcessingUnit picoctrl_newControl(picoos_MemoryManager mm,
     }
     ctrl->numProcUnits = 0;
 
-    if (
+    /* a front-end voice ends with the PAM, a back-end voice starts with the
+     * CEP (see picorsrc_setVoiceUnits) */
+    front = (PICORSRC_UNITS_BACKEND != voice->units);
+    back = (PICORSRC_UNITS_FRONTEND != voice->units);
+    if ((!front || (
             (PICO_OK == ctrlAddPU(this,PICODATA_PUTYPE_TOK, FALSE, /*last*/FALSE)) &&
             (PICO_OK == ctrlAddPU(this,PICODATA_PUTYPE_PR, FALSE, FALSE)) &&
             (PICO_OK == ctrlAddPU(this,PICODATA_PUTYPE_WA, FALSE, FALSE)) &&
             (PICO_OK == ctrlAddPU(this,PICODATA_PUTYPE_SA, FALSE, FALSE)) &&
             (PICO_OK == ctrlAddPU(this,PICODATA_PUTYPE_ACPH, FALSE, FALSE)) &&
             (PICO_OK == ctrlAddPU(this,PICODATA_PUTYPE_SPHO, FALSE, FALSE)) &&
-            (PICO_OK == ctrlAddPU(this,PICODATA_PUTYPE_PAM, FALSE, FALSE)) &&
+            (PICO_OK == ctrlAddPU(this,PICODATA_PUTYPE_PAM, FALSE, !back)))) &&
+        (!back || (
             (PICO_OK == ctrlAddPU(this,PICODATA_PUTYPE_CEP, FALSE, FALSE)) &&
-            (PICO_OK == ctrlAddPU(this,PICODATA_PUTYPE_SIG, FALSE, TRUE))
+            (PICO_OK == ctrlAddPU(this,PICODATA_PUTYPE_SIG, FALSE, TRUE))))
          ) {
 
         /* we don't call ctrlInitialize here because ctrlAddPU does initialize the PUs allready and the only thing
@@ -502,8 +516,15 @@ typedef struct picoctrl_engine {
     picorsrc_Voice voice;
     picodata_ProcessingUnit control;
     picodata_CharBuffer cbIn, cbOut;
+    picoos_uint32 phoneFrames; /* frames of the phones fetched since the last reset */
+    picoos_bool streamHeaderDone; /* item stream header sent or received since the last reset */
+    picoos_uint16 streamLen; /* bytes of the incomplete header or item in streamBuf */
+    picoos_uint8 streamBuf[PICODATA_MAX_ITEMSIZE];
 } picoctrl_engine_t;
 
+/* duration of a PAM frame in ms (see picodata_transformDurations in picopam) */
+#define CTRL_FRAME_DUR_MS 4
+
 
 #define MAGIC_MASK 0x5069436F  /* PiCo */
 
@@ -540,12 +561,38 @@ pico_status_t picoctrl_engReset(picoctrl_Engine this, picoos_int32 resetMode)
     if (PICO_OK == status) {
         status = picodata_cbReset(this->cbOut);
     }
+    this->phoneFrames = 0;
+    this->streamHeaderDone = FALSE;
+    this->streamLen = 0;
+    picopal_atomic_set(&this->common->cancel, 0);
     if (PICO_OK != status) {
         picoos_emRaiseException(this->common->em,status,NULL,(picoos_char*) "problem resetting engine");
     }
     return status;
 }
 
+/**
+ * cancels the processing of an engine
+ * @param    this : the engine object
+ * @return    PICO_OK : cancellation requested
+ * @return    PICO_ERR_NULLPTR_ACCESS : 'this' is NULL
+ * @remarks    only sets the cancellation token of the engine, so it may be
+ *             called while another thread is stepping the engine. Long
+ *             processing steps check the token and give up their work; the
+ *             engine does no more steps and produces no more output until
+ *             it is reset.
+ * @callgraph
+ * @callergraph
+ */
+pico_status_t picoctrl_engCancel(picoctrl_Engine this)
+{
+    if (NULL == this) {
+        return PICO_ERR_NULLPTR_ACCESS;
+    }
+    picopal_atomic_set(&this->common->cancel, 1);
+    return PICO_OK;
+}
+
 /**
  * checks an engine handle
  * @param    this : the engine object
@@ -593,6 +640,9 @@ picoctrl_Engine picoctrl_newEngine(picoos_MemoryManager mm,
         this->control = NULL;
         this->cbIn = NULL;
         this->cbOut = NULL;
+        this->phoneFrames = 0;
+        this->streamHeaderDone = FALSE;
+        this->streamLen = 0;
 
         this->raw_mem = picoos_allocate(mm, PICOCTRL_DEFAULT_ENGINE_SIZE);
         if (NULL == this->raw_mem) {
@@ -617,11 +667,15 @@ picoctrl_Engine picoctrl_newEngine(picoos_MemoryManager mm,
         done = (PICO_OK == picorsrc_createVoice(rm,voiceName,&(this->voice)));
     }
     if (done)  {
-        bSize = picodata_get_default_buf_size(PICODATA_PUTYPE_TEXT);
+        bSize = picodata_get_default_buf_size(
+                (PICORSRC_UNITS_BACKEND == this->voice->units)
+                ? PICODATA_PUTYPE_PAM : PICODATA_PUTYPE_TEXT);
 
         this->cbIn = picodata_newCharBuffer(this->common->mm,
                 this->common, bSize);
-        bSize = picodata_get_default_buf_size(PICODATA_PUTYPE_SIG);
+        bSize = picodata_get_default_buf_size(
+                (PICORSRC_UNITS_FRONTEND == this->voice->units)
+                ? PICODATA_PUTYPE_PAM : PICODATA_PUTYPE_SIG);
 
         this->cbOut = picodata_newCharBuffer(this->common->mm,
                 this->common, bSize);
@@ -726,8 +780,11 @@ pico_status_t picoctrl_engFeedText(picoctrl_Engine this,
     if (NULL == this) {
         return PICO_ERR_OTHER;
     }
-    PICODBG_DEBUG(("get \"%.100s\"", text));
     *bytesPut = 0;
+    if (PICORSRC_UNITS_BACKEND == this->voice->units) {
+        return picoos_emRaiseException(this->common->em,PICO_ERR_OTHER,NULL,(picoos_char*) "back-end engine takes no text");
+    }
+    PICODBG_DEBUG(("get \"%.100s\"", text));
     while ((*bytesPut < textSize) && (PICO_OK == picodata_cbPutCh(this->cbIn, text[*bytesPut]))) {
         (*bytesPut)++;
     }
@@ -758,6 +815,15 @@ picodata_step_result_t picoctrl_engFetchOutputItemBytes(
     if (NULL == this) {
         return (picodata_step_result_t)PICO_STEP_ERROR;
     }
+    if (PICORSRC_UNITS_FRONTEND == this->voice->units) {
+        picoos_emRaiseException(this->common->em,PICO_ERR_OTHER,NULL,(picoos_char*) "front-end engine has no speech output");
+        return (picodata_step_result_t)PICO_STEP_ERROR;
+    }
+    if (picopal_atomic_get(&this->common->cancel)) {
+        /* buffered speech data is dropped */
+        *bytesReceived = 0;
+        return (picodata_step_result_t)PICO_STEP_IDLE;
+    }
     PICODBG_DEBUG(("doing one step"));
     stepResult = this->control->step(this->control,/* mode */0,&ui);
     if (PICODATA_PU_ERROR != stepResult) {
@@ -791,6 +857,350 @@ picodata_step_result_t picoctrl_engFetchOutputItemBytes(
     }
 }/*picoctrl_engFetchOutputItemBytes*/
 
+/**
+ * decodes a PHONE item of the PAM
+ * @param    this : handle of the engine
+ * @param    item : the PHONE item
+ * @param    phone : the phone record to fill (output)
+ * @callgraph
+ * @callergraph
+ */
+static void ctrlDecodePhone(picoctrl_Engine this, picoos_uint8 * item,
+        picoctrl_phone_t * phone)
+{
+    picokpdf_PdfMUL pdflfz, pdfmgc;
+    picoos_uint32 pos;
+    picoos_uint16 frames, lf0Index, mgcIndex, vecind;
+    picoos_single lf0;
+    picoos_uint8 i;
+
+    pdflfz = picokpdf_getPdfMUL(this->voice->kbArray[PICOKNOW_KBID_PDF_LFZ]);
+    pdfmgc = picokpdf_getPdfMUL(this->voice->kbArray[PICOKNOW_KBID_PDF_MGC]);
+    phone->phoneId = item[PICODATA_ITEMIND_INFO1];
+    phone->numStates = item[PICODATA_ITEMIND_INFO2];
+    if (phone->numStates > PICOCTRL_MAX_PHONE_STATES) {
+        phone->numStates = PICOCTRL_MAX_PHONE_STATES;
+    }
+    phone->startMs = this->phoneFrames * CTRL_FRAME_DUR_MS;
+    phone->durMs = 0;
+    /* frames, lf0 index and mgc index per state */
+    pos = PICODATA_ITEM_HEADSIZE;
+    for (i = 0; i < phone->numStates; i++) {
+        picoos_read_mem_pi_uint16(item, &pos, &frames);
+        picoos_read_mem_pi_uint16(item, &pos, &lf0Index);
+        picoos_read_mem_pi_uint16(item, &pos, &mgcIndex);
+        this->phoneFrames += frames;
+        phone->stateDurMs[i] = (picoos_uint32) frames * CTRL_FRAME_DUR_MS;
+        phone->durMs += phone->stateDurMs[i];
+        phone->stateF0[i] = 0;
+        /* indices are transformed as in picocep; the voicing is taken
+           from the spectrum pdf */
+        if ((NULL == pdflfz) || (NULL == pdfmgc) || (i >= pdflfz->numstates)
+                || (i >= pdfmgc->numstates) || (0 == lf0Index) || (0 == mgcIndex)) {
+            continue;
+        }
+        vecind = mgcIndex - 1 + pdfmgc->stateoffset[i];
+        if ((vecind >= pdfmgc->numframes) || !picokpdf_isVoicedMUL(pdfmgc, vecind)) {
+            continue;
+        }
+        vecind = lf0Index - 1 + pdflfz->stateoffset[i];
+        if (vecind < pdflfz->numframes) {
+            lf0 = picokpdf_getStaticMeanMUL(pdflfz, vecind, 0);
+            phone->stateF0[i] = (picoos_uint16)
+                    (picoos_quick_exp((picoos_double) lf0) + 0.5);
+        }
+    }
+}/*ctrlDecodePhone*/
+
+/**
+ * gets the phones produced by a phonetizing engine
+ * @param    this : handle of the engine
+ * @param    phones : the destination records
+ * @param    maxPhones : number of destination records
+ * @param    *numPhones : the number of records effectively filled
+ * @return    PICO_STEP_BUSY : more phones may follow
+ * @return    PICO_STEP_IDLE : all input has been processed
+ * @return    PICO_STEP_ERROR : error, or not a front-end engine
+ * @remarks    like picoctrl_engFetchOutputItemBytes, does one step of the
+ *             processing chain per call; items other than phones are skipped
+ * @callgraph
+ * @callergraph
+ */
+picodata_step_result_t picoctrl_engFetchPhones(
+        picoctrl_Engine this,
+        picoctrl_phone_t * phones,
+        picoos_uint16 maxPhones,
+        picoos_uint16 * numPhones)
+{
+    picoos_uint8 item[PICODATA_MAX_ITEMSIZE];
+    picoos_uint16 ui, blen;
+    picodata_step_result_t stepResult;
+    pico_status_t rv;
+
+    if (NULL == this) {
+        return (picodata_step_result_t)PICO_STEP_ERROR;
+    }
+    *numPhones = 0;
+    if (PICORSRC_UNITS_FRONTEND != this->voice->units) {
+        picoos_emRaiseException(this->common->em,PICO_ERR_OTHER,NULL,(picoos_char*) "not a front-end engine");
+        return (picodata_step_result_t)PICO_STEP_ERROR;
+    }
+    stepResult = this->control->step(this->control,/* mode */0,&ui);
+    if (PICODATA_PU_ERROR == stepResult) {
+        return (picodata_step_result_t)PICO_STEP_ERROR;
+    }
+    rv = PICO_OK;
+    while ((*numPhones < maxPhones) && (PICO_OK == rv)) {
+        rv = picodata_cbGetItem(this->cbOut, item, PICODATA_MAX_ITEMSIZE, &blen);
+        if ((PICO_OK == rv) && (PICODATA_ITEM_PHONE == item[PICODATA_ITEMIND_TYPE])) {
+            ctrlDecodePhone(this, item, &phones[*numPhones]);
+            (*numPhones)++;
+        }
+    }
+    if ((rv == PICO_EXC_BUF_UNDERFLOW) || (rv == PICO_EXC_BUF_OVERFLOW)) {
+        PICODBG_ERROR(("problem getting phone items"));
+        return (picodata_step_result_t)PICO_STEP_ERROR;
+    }
+    if ((PICODATA_PU_IDLE == stepResult) && (PICO_EOF == rv)) {
+        return (picodata_step_result_t)PICO_STEP_IDLE;
+    } else {
+        return (picodata_step_result_t)PICO_STEP_BUSY;
+    }
+}/*picoctrl_engFetchPhones*/
+
+/* item stream header: magic, version, length and characters of the name of
+ * the resource of the spectrum pdf (the items refer to its pdfs) */
+static const picoos_uint8 ctrlStreamMagic[] = { 'P', 'I', 'S' };
+
+#define CTRL_STREAM_MAGIC_SIZE 3
+#define CTRL_STREAM_HEADSIZE 5
+
+/**
+ * gets the name of the resource the items of a stream refer to
+ * @param    this : handle of the engine
+ * @param    name : the resource name (output)
+ * @callgraph
+ * @callergraph
+ */
+static void ctrlGetStreamResourceName(picoctrl_Engine this,
+        picorsrc_resource_name_t name)
+{
+    name[0] = NULLC;
+    picorsrc_rsrcGetName(picorsrc_getVoiceKbResource(this->voice,
+            PICOKNOW_KBID_PDF_MGC), name, PICORSRC_MAX_RSRC_NAME_SIZ);
+}/*ctrlGetStreamResourceName*/
+
+/**
+ * gets the item stream produced by a front-end engine
+ * @param    this : handle of the engine
+ * @param    buffer : the destination buffer
+ * @param    bufferSize : size of the destination buffer, at least
+ *           PICODATA_MAX_ITEMSIZE
+ * @param    *bytesReceived : the number of bytes effectively returned
+ * @return    PICO_STEP_BUSY : more items may follow
+ * @return    PICO_STEP_IDLE : all input has been processed
+ * @return    PICO_STEP_ERROR : error, or not a front-end engine
+ * @remarks    the stream starts with a header after each reset and carries
+ *             the items of the PAM unchanged; only complete items are
+ *             returned. Feed it to a back-end engine with
+ *             picoctrl_engFeedItemStream
+ * @callgraph
+ * @callergraph
+ */
+picodata_step_result_t picoctrl_engFetchItemStream(
+        picoctrl_Engine this,
+        picoos_uint8 * buffer,
+        picoos_uint16 bufferSize,
+        picoos_uint16 * bytesReceived)
+{
+    picorsrc_resource_name_t name;
+    picoos_uint16 ui, blen;
+    picodata_step_result_t stepResult;
+    pico_status_t rv;
+
+    if (NULL == this) {
+        return (picodata_step_result_t)PICO_STEP_ERROR;
+    }
+    *bytesReceived = 0;
+    if (PICORSRC_UNITS_FRONTEND != this->voice->units) {
+        picoos_emRaiseException(this->common->em,PICO_ERR_OTHER,NULL,(picoos_char*) "not a front-end engine");
+        return (picodata_step_result_t)PICO_STEP_ERROR;
+    }
+    if (bufferSize < PICODATA_MAX_ITEMSIZE) {
+        picoos_emRaiseException(this->common->em,PICO_ERR_INVALID_ARGUMENT,NULL,(picoos_char*) "item stream buffer too small");
+        return (picodata_step_result_t)PICO_STEP_ERROR;
+    }
+    stepResult = this->control->step(this->control,/* mode */0,&ui);
+    if (PICODATA_PU_ERROR == stepResult) {
+        return (picodata_step_result_t)PICO_STEP_ERROR;
+    }
+    if (!this->streamHeaderDone) {
+        ctrlGetStreamResourceName(this, name);
+        picoos_mem_copy(ctrlStreamMagic, buffer, CTRL_STREAM_MAGIC_SIZE);
+        buffer[CTRL_STREAM_MAGIC_SIZE] = PICOCTRL_STREAM_VERSION;
+        buffer[CTRL_STREAM_MAGIC_SIZE + 1] = (picoos_uint8) picoos_strlen(name);
+        picoos_mem_copy(name, buffer + CTRL_STREAM_HEADSIZE,
+                buffer[CTRL_STREAM_MAGIC_SIZE + 1]);
+        *bytesReceived = CTRL_STREAM_HEADSIZE + buffer[CTRL_STREAM_MAGIC_SIZE + 1];
+        this->streamHeaderDone = TRUE;
+    }
+    rv = PICO_OK;
+    while (PICO_OK == rv) {
+        rv = picodata_cbGetItem(this->cbOut, buffer + *bytesReceived,
+                bufferSize - *bytesReceived, &blen);
+        if (PICO_OK == rv) {
+            *bytesReceived += blen;
+        }
+    }
+    if (rv == PICO_EXC_BUF_UNDERFLOW) {
+        PICODBG_ERROR(("problem getting items"));
+        return (picodata_step_result_t)PICO_STEP_ERROR;
+    }
+    /* PICO_EXC_BUF_OVERFLOW: the buffer is full */
+    if ((PICODATA_PU_IDLE == stepResult) && (PICO_EOF == rv)) {
+        return (picodata_step_result_t)PICO_STEP_IDLE;
+    } else {
+        return (picodata_step_result_t)PICO_STEP_BUSY;
+    }
+}/*picoctrl_engFetchItemStream*/
+
+/**
+ * checks a PHONE item of an item stream against the pdfs of a back-end
+ * engine, so that the CEP only gets states and indices it can look up
+ * @param    this : handle of the engine
+ * @param    item : the PHONE item, complete
+ * @return    TRUE if the item has 6 bytes per state (frames, lf0 index and
+ *            mgc index), no more states than the pdfs, indices within the
+ *            pdfs and no more frames than the CEP can smooth
+ * @callgraph
+ * @callergraph
+ */
+static picoos_bool ctrlIsValidPhone(picoctrl_Engine this, picoos_uint8 * item)
+{
+    picokpdf_PdfMUL pdflfz, pdfmgc;
+    picoos_uint32 pos, numFrames;
+    picoos_uint16 frames, lf0Index, mgcIndex;
+    picoos_uint8 i, numStates;
+
+    pdflfz = picokpdf_getPdfMUL(this->voice->kbArray[PICOKNOW_KBID_PDF_LFZ]);
+    pdfmgc = picokpdf_getPdfMUL(this->voice->kbArray[PICOKNOW_KBID_PDF_MGC]);
+    numStates = item[PICODATA_ITEMIND_INFO2];
+    if ((NULL == pdflfz) || (NULL == pdfmgc)
+            || (item[PICODATA_ITEMIND_LEN] != 6 * numStates)
+            || (numStates > pdflfz->numstates) || (numStates > pdfmgc->numstates)) {
+        return FALSE;
+    }
+    /* indices are transformed as in picocep */
+    numFrames = 0;
+    pos = PICODATA_ITEM_HEADSIZE;
+    for (i = 0; i < numStates; i++) {
+        picoos_read_mem_pi_uint16(item, &pos, &frames);
+        picoos_read_mem_pi_uint16(item, &pos, &lf0Index);
+        picoos_read_mem_pi_uint16(item, &pos, &mgcIndex);
+        if ((0 == lf0Index) || (0 == mgcIndex)
+                || ((picoos_uint32) lf0Index - 1 + pdflfz->stateoffset[i] >= pdflfz->numframes)
+                || ((picoos_uint32) mgcIndex - 1 + pdfmgc->stateoffset[i] >= pdfmgc->numframes)) {
+            return FALSE;
+        }
+        numFrames += frames;
+    }
+    return (numFrames <= PICOCEP_MAXWINLEN);
+}/*ctrlIsValidPhone*/
+
+/**
+ * feeds an item stream into a back-end engine
+ * @param    this : handle of the engine
+ * @param    bytes : the stream bytes, in pieces of any size
+ * @param    size : number of stream bytes
+ * @param    *bytesPut : the number of bytes effectively consumed
+ * @return    PICO_OK : feeding succeeded; less than 'size' bytes are
+ *            consumed if the engine input is full
+ * @return    PICO_EXC_UNEXPECTED_FILE_TYPE : missing header, or header of
+ *            another version or for another resource
+ * @return    PICO_EXC_FILE_CORRUPT : invalid item, or a phone that does
+ *            not fit the pdfs of the engine (see ctrlIsValidPhone)
+ * @return    PICO_ERR_OTHER : not a back-end engine
+ * @remarks    an incomplete header or item is kept in the engine until the
+ *             rest arrives; items are passed to the CEP unchanged
+ * @callgraph
+ * @callergraph
+ */
+pico_status_t picoctrl_engFeedItemStream(
+        picoctrl_Engine this,
+        const picoos_uint8 * bytes,
+        picoos_uint16 size,
+        picoos_uint16 * bytesPut)
+{
+    picorsrc_resource_name_t name;
+    picoos_uint16 unitSize, n, blen;
+    picoos_bool isHeader;
+    pico_status_t status;
+
+    if (NULL == this) {
+        return PICO_ERR_NULLPTR_ACCESS;
+    }
+    *bytesPut = 0;
+    if (PICORSRC_UNITS_BACKEND != this->voice->units) {
+        return picoos_emRaiseException(this->common->em,PICO_ERR_OTHER,NULL,(picoos_char*) "not a back-end engine");
+    }
+    status = PICO_OK;
+    while (PICO_OK == status) {
+        /* size of the header or item being collected, as far as known */
+        isHeader = (this->streamLen > 0) && (ctrlStreamMagic[0] == this->streamBuf[0]);
+        if (isHeader) {
+            unitSize = CTRL_STREAM_HEADSIZE;
+            if (this->streamLen >= unitSize) {
+                unitSize += this->streamBuf[CTRL_STREAM_MAGIC_SIZE + 1];
+            }
+        } else {
+            unitSize = PICODATA_ITEM_HEADSIZE;
+            if (this->streamLen >= unitSize) {
+                unitSize += this->streamBuf[PICODATA_ITEMIND_LEN];
+            }
+        }
+        if (this->streamLen < unitSize) {
+            if (*bytesPut >= size) {
+                break;
+            }
+            n = unitSize - this->streamLen;
+            if (n > size - *bytesPut) {
+                n = size - *bytesPut;
+            }
+            picoos_mem_copy(bytes + *bytesPut, this->streamBuf + this->streamLen, n);
+            this->streamLen += n;
+            *bytesPut += n;
+        } else if (isHeader) {
+            this->streamLen = 0;
+            ctrlGetStreamResourceName(this, name);
+            this->streamHeaderDone =
+                    (0 == picoos_strncmp((picoos_char *) this->streamBuf,
+                            (picoos_char *) ctrlStreamMagic, CTRL_STREAM_MAGIC_SIZE))
+                    && (PICOCTRL_STREAM_VERSION == this->streamBuf[CTRL_STREAM_MAGIC_SIZE])
+                    && (picoos_strlen(name) == this->streamBuf[CTRL_STREAM_MAGIC_SIZE + 1])
+                    && (0 == picoos_strncmp((picoos_char *) this->streamBuf + CTRL_STREAM_HEADSIZE,
+                            name, this->streamBuf[CTRL_STREAM_MAGIC_SIZE + 1]));
+            if (!this->streamHeaderDone) {
+                status = picoos_emRaiseException(this->common->em,PICO_EXC_UNEXPECTED_FILE_TYPE,NULL,
+                        (picoos_char*) "item stream not for resource %s",name);
+            }
+        } else if (!this->streamHeaderDone) {
+            this->streamLen = 0;
+            status = picoos_emRaiseException(this->common->em,PICO_EXC_UNEXPECTED_FILE_TYPE,NULL,(picoos_char*) "item stream without header");
+        } else if (!picodata_is_valid_item(this->streamBuf, this->streamLen)
+                || ((PICODATA_ITEM_PHONE == this->streamBuf[PICODATA_ITEMIND_TYPE])
+                        && !ctrlIsValidPhone(this, this->streamBuf))) {
+            this->streamLen = 0;
+            status = picoos_emRaiseException(this->common->em,PICO_EXC_FILE_CORRUPT,NULL,(picoos_char*) "invalid item in item stream");
+        } else if (PICO_OK == picodata_cbPutItem(this->cbIn, this->streamBuf, this->streamLen, &blen)) {
+            this->streamLen = 0;
+        } else {
+            /* input full; keep the item for the next call */
+            break;
+        }
+    }
+    return status;
+}/*picoctrl_engFeedItemStream*/
+
 /**
  * returns the last scheduled PU
  * @param    this : handle of the engine
@@ -832,6 +1242,148 @@ picodata_step_result_t picoctrl_getLastProducedItemType(
     return (picodata_step_result_t) ctrl->lastItemTypeProduced;
 }/*picoctrl_getLastProducedItemType*/
 
+/**
+ * returns the memory statistics of the preprocessing PU
+ * @param    this : handle of the engine
+ * @param    maxWorkMemTop, maxDynMemSize : high-water marks of the working
+ *           and dynamic memory partitions since the last full reset (output)
+ * @param    workMemSize, dynMemSize : current sizes of the partitions (output)
+ * @return    PICO_OK : statistics returned
+ * @return    PICO_ERR_OTHER : no preprocessing PU
+ * @remarks    designed to size the preprocessing memory for a workload
+ * @callgraph
+ * @callergraph
+ */
+pico_status_t picoctrl_getPreprocMemStats(
+        picoctrl_Engine this,
+        picoos_int32 * maxWorkMemTop,
+        picoos_int32 * maxDynMemSize,
+        picoos_int32 * workMemSize,
+        picoos_int32 * dynMemSize
+        )
+{
+    ctrl_subobj_t * ctrl;
+    picoos_uint8 i;
+    if (NULL == this || NULL == this->control->subObj) {
+        return PICO_ERR_OTHER;
+    }
+    ctrl = (ctrl_subobj_t *) ((*this).control->subObj);
+    for (i = 0; i < ctrl->numProcUnits; i++) {
+        if (ctrl->procType[i] == PICODATA_PUTYPE_PR) {
+            return picopr_getMemStats(ctrl->procUnit[i], maxWorkMemTop,
+                    maxDynMemSize, workMemSize, dynMemSize);
+        }
+    }
+    return PICO_ERR_OTHER;
+}/*picoctrl_getPreprocMemStats*/
+
+/**
+ * returns the PAM PU of an engine
+ * @param    this : handle of the engine
+ * @return    the PAM PU, NULL if there is none
+ * @callgraph
+ * @callergraph
+ */
+static picodata_ProcessingUnit ctrlGetPamPU(picoctrl_Engine this)
+{
+    ctrl_subobj_t * ctrl;
+    picoos_uint8 i;
+    if (NULL == this || NULL == this->control->subObj) {
+        return NULL;
+    }
+    ctrl = (ctrl_subobj_t *) ((*this).control->subObj);
+    for (i = 0; i < ctrl->numProcUnits; i++) {
+        if (ctrl->procType[i] == PICODATA_PUTYPE_PAM) {
+            return ctrl->procUnit[i];
+        }
+    }
+    return NULL;
+}/*ctrlGetPamPU*/
+
+/**
+ * sets the number of entries of the decision tree cache of the PAM PU
+ * @param    this : handle of the engine
+ * @param    nEntries : number of cache entries, 0 disables the cache
+ * @return    PICO_OK : cache resized
+ * @return    PICO_ERR_INVALID_ARGUMENT : nEntries out of range
+ * @return    PICO_EXC_OUT_OF_MEM : not enough engine memory
+ * @return    PICO_ERR_OTHER : no PAM PU
+ * @callgraph
+ * @callergraph
+ */
+pico_status_t picoctrl_setPamTreeCacheSize(
+        picoctrl_Engine this,
+        picoos_uint32 nEntries
+        )
+{
+    picodata_ProcessingUnit pam = ctrlGetPamPU(this);
+    if (NULL == pam) {
+        return PICO_ERR_OTHER;
+    }
+    return picopam_setTreeCacheSize(pam, nEntries);
+}/*picoctrl_setPamTreeCacheSize*/
+
+/**
+ * returns the statistics of the decision tree cache of the PAM PU
+ * @param    this : handle of the engine
+ * @param    size, used : number of entries and entries in use (output)
+ * @param    hits, misses : lookups answered from the cache and by tree
+ *           traversal since the last full reset or resize (output)
+ * @return    PICO_OK : statistics returned
+ * @return    PICO_ERR_OTHER : no PAM PU
+ * @callgraph
+ * @callergraph
+ */
+pico_status_t picoctrl_getPamTreeCacheStats(
+        picoctrl_Engine this,
+        picoos_uint32 * size,
+        picoos_uint32 * used,
+        picoos_uint32 * hits,
+        picoos_uint32 * misses
+        )
+{
+    picodata_ProcessingUnit pam = ctrlGetPamPU(this);
+    if (NULL == pam) {
+        return PICO_ERR_OTHER;
+    }
+    return picopam_getTreeCacheStats(pam, size, used, hits, misses);
+}/*picoctrl_getPamTreeCacheStats*/
+
+/**
+ * sets (or removes) the tap on the output of a PU of an engine
+ * @param    this : handle of the engine
+ * @param    puType : type of the PU whose output is tapped
+ * @param    tap : called for every item the PU outputs; NULL removes the tap
+ * @param    tapData, tag : passed to tap
+ * @return    PICO_OK : tap set
+ * @return    PICO_ERR_OTHER : the engine has no PU of type puType
+ * @remarks    the tap is kept by engine resets
+ * @callgraph
+ * @callergraph
+ */
+pico_status_t picoctrl_engSetItemTap(
+        picoctrl_Engine this,
+        picodata_putype_t puType,
+        picodata_cbTapCallback tap,
+        void * tapData,
+        picoos_int16 tag
+        )
+{
+    ctrl_subobj_t * ctrl;
+    picoos_uint8 i;
+    if (NULL == this || NULL == this->control->subObj) {
+        return PICO_ERR_OTHER;
+    }
+    ctrl = (ctrl_subobj_t *) ((*this).control->subObj);
+    for (i = 0; i < ctrl->numProcUnits; i++) {
+        if (ctrl->procType[i] == (picoos_uint8) puType) {
+            picodata_cbSetTap(ctrl->procCbOut[i], tap, tapData, tag);
+            return PICO_OK;
+        }
+    }
+    return PICO_ERR_OTHER;
+}/*picoctrl_engSetItemTap*/
+
 
 #ifdef __cplusplus
 }
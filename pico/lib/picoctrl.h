@@ -44,7 +44,8 @@ extern "C" {
 /* temporarily increased for preprocessing
 #define PICOCTRL_DEFAULT_ENGINE_SIZE 200000
 */
-#define PICOCTRL_DEFAULT_ENGINE_SIZE 1000000
+/* leaves room for the preprocessing and PAM sentence buffers to grow */
+#define PICOCTRL_DEFAULT_ENGINE_SIZE 1100000
 
 typedef struct picoctrl_engine * picoctrl_Engine;
 
@@ -72,6 +73,9 @@ pico_status_t picoctrl_engReset(
         picoctrl_Engine engine,
         picoos_int32 resetMode);
 
+pico_status_t picoctrl_engCancel(
+        picoctrl_Engine engine);
+
 picoos_Common picoctrl_engGetCommon(picoctrl_Engine this);
 
 picodata_step_result_t picoctrl_engFetchOutputItemBytes(
@@ -81,6 +85,51 @@ picodata_step_result_t picoctrl_engFetchOutputItemBytes(
         picoos_int16  * bytesReceived
 );
 
+/* a phone as delivered by a front-end engine (see picorsrc_setVoiceUnits) */
+#define PICOCTRL_MAX_PHONE_STATES 10
+
+typedef struct picoctrl_phone {
+    picoos_uint8 phoneId;     /* phone id of the voice's phone table */
+    picoos_uint8 numStates;
+    picoos_uint32 startMs;    /* since the last engine reset */
+    picoos_uint32 durMs;
+    picoos_uint32 stateDurMs[PICOCTRL_MAX_PHONE_STATES];
+    picoos_uint16 stateF0[PICOCTRL_MAX_PHONE_STATES]; /* Hz, 0 if unvoiced */
+} picoctrl_phone_t;
+
+picodata_step_result_t picoctrl_engFetchPhones(
+        picoctrl_Engine engine,
+        picoctrl_phone_t * phones,
+        picoos_uint16 maxPhones,
+        picoos_uint16 * numPhones
+);
+
+/* version of the item stream between a front-end and a back-end engine;
+   to be incremented whenever the PAM output items change */
+#define PICOCTRL_STREAM_VERSION 1
+
+picodata_step_result_t picoctrl_engFetchItemStream(
+        picoctrl_Engine engine,
+        picoos_uint8 * buffer,
+        picoos_uint16 bufferSize,
+        picoos_uint16 * bytesReceived
+);
+
+pico_status_t picoctrl_engFeedItemStream(
+        picoctrl_Engine engine,
+        const picoos_uint8 * bytes,
+        picoos_uint16 size,
+        picoos_uint16 * bytesPut
+);
+
+pico_status_t picoctrl_engSetItemTap(
+        picoctrl_Engine engine,
+        picodata_putype_t puType,
+        picodata_cbTapCallback tap,
+        void * tapData,
+        picoos_int16 tag
+);
+
 void picoctrl_engResetExceptionManager(
         picoctrl_Engine this
         );
@@ -94,6 +143,27 @@ picodata_step_result_t picoctrl_getLastProducedItemType(
         picoctrl_Engine engine
         );
 
+pico_status_t picoctrl_getPreprocMemStats(
+        picoctrl_Engine engine,
+        picoos_int32 * maxWorkMemTop,
+        picoos_int32 * maxDynMemSize,
+        picoos_int32 * workMemSize,
+        picoos_int32 * dynMemSize
+        );
+
+pico_status_t picoctrl_setPamTreeCacheSize(
+        picoctrl_Engine engine,
+        picoos_uint32 nEntries
+        );
+
+pico_status_t picoctrl_getPamTreeCacheStats(
+        picoctrl_Engine engine,
+        picoos_uint32 * size,
+        picoos_uint32 * used,
+        picoos_uint32 * hits,
+        picoos_uint32 * misses
+        );
+
 #ifdef __cplusplus
 }
 #endif
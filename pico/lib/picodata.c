@@ -75,6 +75,10 @@ typedef struct picodata_char_buffer
     picodata_cbSubResetMethod subReset;
     picodata_cbSubDeallocateMethod subDeallocate;
     void * subObj;
+
+    picodata_cbTapCallback tap; /* NULL if there is no tap */
+    void * tapData;
+    picoos_int16 tapTag;
 } char_buffer_t;
 
 
@@ -125,6 +129,10 @@ picodata_CharBuffer picodata_newCharBuffer(picoos_MemoryManager mm,
     this->subDeallocate = NULL;
     this->subObj = NULL;
 
+    this->tap = NULL;
+    this->tapData = NULL;
+    this->tapTag = 0;
+
     picodata_cbReset(this);
     return this;
 }
@@ -338,8 +346,21 @@ pico_status_t picodata_cbPutItem(register picodata_CharBuffer this,
         const picoos_uint8 *buf, const picoos_uint16 blenmax,
         picoos_uint16 *blen)
 {
+    pico_status_t status;
 
-        return this->putItem(this,buf,blenmax,blen);
+    status = this->putItem(this,buf,blenmax,blen);
+    if ((NULL != this->tap) && (PICO_OK == status)) {
+        this->tap(this->tapData, this->tapTag, buf, (picoos_int16) *blen);
+    }
+    return status;
+}
+
+void picodata_cbSetTap(register picodata_CharBuffer this,
+        picodata_cbTapCallback tap, void * tapData, picoos_int16 tag)
+{
+    this->tap = tap;
+    this->tapData = tapData;
+    this->tapTag = tag;
 }
 
 /* unsafe, just for measuring purposes */
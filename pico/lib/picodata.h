@@ -328,6 +328,18 @@ pico_status_t picodata_cbPutItem(register picodata_CharBuffer this,
 /* unsafe, just for measuring purposes */
 picoos_uint8 picodata_cbGetFrontItemType(register picodata_CharBuffer this);
 
+/* tap on the items put to a CharBuffer: called by picodata_cbPutItem for
+   every item put, with the item (head and content) in the buffer of the
+   producing PU, i.e. the item is only valid during the call; tag is the
+   value given to picodata_cbSetTap */
+typedef void (* picodata_cbTapCallback) (void * tapData, picoos_int16 tag,
+        const picoos_uint8 *item, picoos_int16 itemLen);
+
+/* sets (or, if tap is NULL, removes) the tap of a CharBuffer; the tap is
+   kept by picodata_cbReset */
+void picodata_cbSetTap(register picodata_CharBuffer this,
+        picodata_cbTapCallback tap, void * tapData, picoos_int16 tag);
+
 /* ***************************************************************
  *                   items: support function                     *
  *****************************************************************/
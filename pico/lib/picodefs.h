@@ -66,6 +66,9 @@ extern "C" {
 /* maximum number of resources per voice */
 #define PICO_MAX_NUM_RSRC_PER_VOICE     16
 
+/* maximum number of engines per system */
+#define PICO_MAX_NUM_ENGINES             8
+
 /* maximum length of foreign header prepended to PICO resource files
    (header length must be a multiple of 4 bytes) */
 #define PICO_MAX_FOREIGN_HEADER_LEN     64
@@ -165,6 +168,7 @@ typedef signed int pico_Status;
 
 #define PICO_RESET_FULL                                 0
 #define PICO_RESET_SOFT                                 0x10
+#define PICO_RESET_UTTERANCE                            0x20
 
 
 /* ********************************************************************/
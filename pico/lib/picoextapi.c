@@ -44,6 +44,12 @@ extern "C" {
  * progv.progVers in picosh.c instead. */
 #define PICO_VERSION_INFO  (picoos_char *)"invalid"
 
+/* number of phones picoext_getPhones returns at most per call */
+#define PICOEXT_PHONE_FETCH_SIZE 16
+
+/* samples per frame of a phone state (4 ms at 16 kHz) */
+#define PICOEXT_FRAME_SAMPLES 64
+
 
 extern pico_Status pico_initialize_priv(
         void *memory,
@@ -82,6 +88,343 @@ PICO_FUNC picoext_getVersionInfo(
 }
 
 
+/* Voice configuration functions **********************************************/
+
+
+PICO_FUNC picoext_setVoicePdfExpansion(
+        pico_System system,
+        const pico_Char *voiceName,
+        pico_Int16 level
+        )
+{
+    pico_Status status = PICO_OK;
+
+    if (!is_valid_system_handle(system)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if (voiceName == NULL) {
+        status = PICO_ERR_NULLPTR_ACCESS;
+    } else if ((level < PICOEXT_PDF_EXPAND_NONE) || (level > PICOEXT_PDF_EXPAND_ALL)) {
+        status = PICO_ERR_INVALID_ARGUMENT;
+    } else {
+        picoos_emReset(system->common->em);
+        status = picorsrc_setVoicePdfExpansion(system->rm, (picoos_char *) voiceName,
+                (picoos_uint8) level);
+    }
+
+    return status;
+}
+
+
+PICO_FUNC picoext_setVoicePhonetize(
+        pico_System system,
+        const pico_Char *voiceName,
+        pico_Int16 phonetize
+        )
+{
+    pico_Status status = PICO_OK;
+
+    if (!is_valid_system_handle(system)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if (voiceName == NULL) {
+        status = PICO_ERR_NULLPTR_ACCESS;
+    } else {
+        picoos_emReset(system->common->em);
+        status = picorsrc_setVoiceUnits(system->rm, (picoos_char *) voiceName,
+                (picoos_uint8) ((phonetize != 0) ? PICORSRC_UNITS_FRONTEND : PICORSRC_UNITS_ALL));
+    }
+
+    return status;
+}
+
+
+PICO_FUNC picoext_setVoiceBackEnd(
+        pico_System system,
+        const pico_Char *voiceName,
+        pico_Int16 backEnd
+        )
+{
+    pico_Status status = PICO_OK;
+
+    if (!is_valid_system_handle(system)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if (voiceName == NULL) {
+        status = PICO_ERR_NULLPTR_ACCESS;
+    } else {
+        picoos_emReset(system->common->em);
+        status = picorsrc_setVoiceUnits(system->rm, (picoos_char *) voiceName,
+                (picoos_uint8) ((backEnd != 0) ? PICORSRC_UNITS_BACKEND : PICORSRC_UNITS_ALL));
+    }
+
+    return status;
+}
+
+
+PICO_FUNC picoext_setVoicePreprocMemLimit(
+        pico_System system,
+        const pico_Char *voiceName,
+        pico_Int32 workMemMax,
+        pico_Int32 dynMemMax
+        )
+{
+    pico_Status status = PICO_OK;
+
+    if (!is_valid_system_handle(system)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if (voiceName == NULL) {
+        status = PICO_ERR_NULLPTR_ACCESS;
+    } else if ((workMemMax < 0) || (dynMemMax < 0)) {
+        status = PICO_ERR_INVALID_ARGUMENT;
+    } else {
+        picoos_emReset(system->common->em);
+        status = picorsrc_setVoicePreprocMemLimit(system->rm, (picoos_char *) voiceName,
+                (picoos_uint32) workMemMax, (picoos_uint32) dynMemMax);
+    }
+
+    return status;
+}
+
+
+/* Phonetization functions *****************************************************/
+
+
+PICO_FUNC picoext_getPhones(
+        pico_Engine engine,
+        picoext_PhoneRecord *outRecords,
+        const pico_Int16 maxRecords,
+        pico_Int16 *outNumRecords
+        )
+{
+    picoctrl_phone_t phones[PICOEXT_PHONE_FETCH_SIZE];
+    picoos_uint16 numPhones, i, j;
+    pico_Status status = PICO_OK;
+
+    if (!picoctrl_isValidEngineHandle((picoctrl_Engine) engine)) {
+        status = PICO_STEP_ERROR;
+    } else if ((outRecords == NULL) || (outNumRecords == NULL)) {
+        status = PICO_STEP_ERROR;
+    } else if (maxRecords < 0) {
+        status = PICO_STEP_ERROR;
+    } else {
+        picoctrl_engResetExceptionManager((picoctrl_Engine) engine);
+        status = picoctrl_engFetchPhones((picoctrl_Engine) engine, phones,
+                (maxRecords < PICOEXT_PHONE_FETCH_SIZE) ? (picoos_uint16) maxRecords
+                : PICOEXT_PHONE_FETCH_SIZE, &numPhones);
+        if ((status != PICO_STEP_IDLE) && (status != PICO_STEP_BUSY)) {
+            status = PICO_STEP_ERROR;
+            numPhones = 0;
+        }
+        for (i = 0; i < numPhones; i++) {
+            outRecords[i].phoneId = phones[i].phoneId;
+            outRecords[i].numStates = phones[i].numStates;
+            outRecords[i].startMs = phones[i].startMs;
+            outRecords[i].durationMs = phones[i].durMs;
+            for (j = 0; j < PICOEXT_MAX_PHONE_STATES; j++) {
+                outRecords[i].stateDurationMs[j] = (j < phones[i].numStates) ? phones[i].stateDurMs[j] : 0;
+                outRecords[i].stateF0Hz[j] = (j < phones[i].numStates) ? phones[i].stateF0[j] : 0;
+            }
+        }
+        *outNumRecords = (pico_Int16) numPhones;
+    }
+
+    return status;
+}
+
+
+PICO_FUNC picoext_getItemStream(
+        pico_Engine engine,
+        void *buffer,
+        const pico_Int16 bufferSize,
+        pico_Int16 *bytesReceived
+        )
+{
+    picoos_uint16 received;
+    pico_Status status = PICO_OK;
+
+    if (!picoctrl_isValidEngineHandle((picoctrl_Engine) engine)) {
+        status = PICO_STEP_ERROR;
+    } else if ((buffer == NULL) || (bytesReceived == NULL)) {
+        status = PICO_STEP_ERROR;
+    } else if (bufferSize < PICOEXT_ITEM_STREAM_MIN_BUFSIZE) {
+        status = PICO_STEP_ERROR;
+    } else {
+        picoctrl_engResetExceptionManager((picoctrl_Engine) engine);
+        status = picoctrl_engFetchItemStream((picoctrl_Engine) engine,
+                (picoos_uint8 *) buffer, (picoos_uint16) bufferSize, &received);
+        if ((status != PICO_STEP_IDLE) && (status != PICO_STEP_BUSY)) {
+            status = PICO_STEP_ERROR;
+        }
+        *bytesReceived = (pico_Int16) received;
+    }
+
+    return status;
+}
+
+
+PICO_FUNC picoext_putItemStream(
+        pico_Engine engine,
+        const void *bytes,
+        const pico_Int16 size,
+        pico_Int16 *bytesPut
+        )
+{
+    picoos_uint16 put;
+    pico_Status status = PICO_OK;
+
+    if (!picoctrl_isValidEngineHandle((picoctrl_Engine) engine)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if ((bytes == NULL) || (bytesPut == NULL)) {
+        status = PICO_ERR_NULLPTR_ACCESS;
+    } else if (size < 0) {
+        status = PICO_ERR_INVALID_ARGUMENT;
+    } else {
+        picoctrl_engResetExceptionManager((picoctrl_Engine) engine);
+        status = picoctrl_engFeedItemStream((picoctrl_Engine) engine,
+                (const picoos_uint8 *) bytes, (picoos_uint16) size, &put);
+        *bytesPut = (pico_Int16) put;
+    }
+
+    return status;
+}
+
+
+/* Item tap functions **********************************************************/
+
+
+PICO_FUNC picoext_setItemTap(
+        pico_Engine engine,
+        const pico_Int16 unit,
+        picoext_ItemTapCallback callback,
+        void *userData
+        )
+{
+    picodata_putype_t puType;
+    pico_Status status = PICO_OK;
+
+    switch (unit) {
+        case PICOEXT_UNIT_TOK:  puType = PICODATA_PUTYPE_TOK;  break;
+        case PICOEXT_UNIT_PR:   puType = PICODATA_PUTYPE_PR;   break;
+        case PICOEXT_UNIT_WA:   puType = PICODATA_PUTYPE_WA;   break;
+        case PICOEXT_UNIT_SA:   puType = PICODATA_PUTYPE_SA;   break;
+        case PICOEXT_UNIT_ACPH: puType = PICODATA_PUTYPE_ACPH; break;
+        case PICOEXT_UNIT_SPHO: puType = PICODATA_PUTYPE_SPHO; break;
+        case PICOEXT_UNIT_PAM:  puType = PICODATA_PUTYPE_PAM;  break;
+        case PICOEXT_UNIT_CEP:  puType = PICODATA_PUTYPE_CEP;  break;
+        case PICOEXT_UNIT_SIG:  puType = PICODATA_PUTYPE_SIG;  break;
+        default:                puType = PICODATA_PUTYPE_TEXT; break;
+    }
+
+    if (!picoctrl_isValidEngineHandle((picoctrl_Engine) engine)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if ((PICODATA_PUTYPE_TEXT == puType)
+            || (PICO_OK != picoctrl_engSetItemTap((picoctrl_Engine) engine,
+                    puType, (picodata_cbTapCallback) callback, userData,
+                    (picoos_int16) unit))) {
+        status = PICO_ERR_INVALID_ARGUMENT;
+    }
+
+    return status;
+}
+
+PICO_FUNC picoext_getPhoneItemSamples(
+        const pico_Char *item,
+        const pico_Int16 itemSize,
+        pico_Int32 *outNumSamples
+        )
+{
+    picoos_uint32 pos;
+    picoos_uint16 frames, dummy;
+    picoos_uint8 i;
+    pico_Status status = PICO_OK;
+
+    if ((item == NULL) || (outNumSamples == NULL)) {
+        status = PICO_ERR_NULLPTR_ACCESS;
+    } else if ((itemSize < PICODATA_ITEM_HEADSIZE)
+            || (PICODATA_ITEM_PHONE != item[PICODATA_ITEMIND_TYPE])
+            || (itemSize < PICODATA_ITEM_HEADSIZE + item[PICODATA_ITEMIND_LEN])
+            || (item[PICODATA_ITEMIND_LEN] < 6 * item[PICODATA_ITEMIND_INFO2])) {
+        status = PICO_ERR_INVALID_ARGUMENT;
+    } else {
+        /* frames, lf0 index and mgc index per state */
+        *outNumSamples = 0;
+        pos = PICODATA_ITEM_HEADSIZE;
+        for (i = 0; i < item[PICODATA_ITEMIND_INFO2]; i++) {
+            picoos_read_mem_pi_uint16((picoos_uint8 *) item, &pos, &frames);
+            picoos_read_mem_pi_uint16((picoos_uint8 *) item, &pos, &dummy);
+            picoos_read_mem_pi_uint16((picoos_uint8 *) item, &pos, &dummy);
+            *outNumSamples += (pico_Int32) frames * PICOEXT_FRAME_SAMPLES;
+        }
+    }
+
+    return status;
+}
+
+
+/* Cancellation functions ******************************************************/
+
+
+PICO_FUNC picoext_cancelEngine(
+        pico_Engine engine
+        )
+{
+    pico_Status status = PICO_OK;
+
+    if (!picoctrl_isValidEngineHandle((picoctrl_Engine) engine)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else {
+        status = picoctrl_engCancel((picoctrl_Engine) engine);
+    }
+
+    return status;
+}
+
+
+/* Lingware conversion functions ***********************************************/
+
+
+PICO_FUNC picoext_writeInplaceResource(
+        pico_System system,
+        pico_Resource resource,
+        const pico_Char *fileName
+        )
+{
+    pico_Status status = PICO_OK;
+
+    if (!is_valid_system_handle(system)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if (fileName == NULL) {
+        status = PICO_ERR_NULLPTR_ACCESS;
+    } else if (!picoctrl_isValidResourceHandle((picorsrc_Resource) resource)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else {
+        picoos_emReset(system->common->em);
+        status = picorsrc_writeInplaceResource(system->rm, (picorsrc_Resource) resource,
+                (picoos_char *) fileName);
+    }
+
+    return status;
+}
+
+
+PICO_FUNC picoext_compileResourceFsts(
+        pico_System system,
+        pico_Resource resource
+        )
+{
+    pico_Status status = PICO_OK;
+
+    if (!is_valid_system_handle(system)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if (!picoctrl_isValidResourceHandle((picorsrc_Resource) resource)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else {
+        picoos_emReset(system->common->em);
+        status = picorsrc_compileFsts(system->rm, (picorsrc_Resource) resource);
+    }
+
+    return status;
+}
+
+
 /* Debugging/testing support functions *****************************************/
 
 
@@ -203,6 +546,78 @@ PICO_FUNC picoext_getEngineMemUsage(
     return status;
 }
 
+PICO_FUNC picoext_getPreprocMemUsage(
+        pico_Engine engine,
+        pico_Int32 *outMaxWorkMemBytes,
+        pico_Int32 *outMaxDynMemBytes,
+        pico_Int32 *outWorkMemSize,
+        pico_Int32 *outDynMemSize
+        )
+{
+    pico_Status status = PICO_OK;
+
+    if (!picoctrl_isValidEngineHandle((picoctrl_Engine) engine)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if ((outMaxWorkMemBytes == NULL) || (outMaxDynMemBytes == NULL) ||
+               (outWorkMemSize == NULL) || (outDynMemSize == NULL)) {
+        status = PICO_ERR_NULLPTR_ACCESS;
+    } else {
+        status = picoctrl_getPreprocMemStats((picoctrl_Engine) engine,
+                outMaxWorkMemBytes, outMaxDynMemBytes, outWorkMemSize, outDynMemSize);
+    }
+
+    return status;
+}
+
+PICO_FUNC picoext_setPamTreeCacheSize(
+        pico_Engine engine,
+        pico_Int32 numEntries
+        )
+{
+    pico_Status status = PICO_OK;
+
+    if (!picoctrl_isValidEngineHandle((picoctrl_Engine) engine)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if (numEntries < 0) {
+        status = PICO_ERR_INVALID_ARGUMENT;
+    } else {
+        status = picoctrl_setPamTreeCacheSize((picoctrl_Engine) engine,
+                (picoos_uint32) numEntries);
+    }
+
+    return status;
+}
+
+PICO_FUNC picoext_getPamTreeCacheUsage(
+        pico_Engine engine,
+        pico_Int32 *outNumEntries,
+        pico_Int32 *outUsedEntries,
+        pico_Int32 *outHits,
+        pico_Int32 *outMisses
+        )
+{
+    pico_Status status = PICO_OK;
+    picoos_uint32 size, used, hits, misses;
+
+    if (!picoctrl_isValidEngineHandle((picoctrl_Engine) engine)) {
+        status = PICO_ERR_INVALID_HANDLE;
+    } else if ((outNumEntries == NULL) || (outUsedEntries == NULL) ||
+               (outHits == NULL) || (outMisses == NULL)) {
+        status = PICO_ERR_NULLPTR_ACCESS;
+    } else {
+        status = picoctrl_getPamTreeCacheStats((picoctrl_Engine) engine,
+                &size, &used, &hits, &misses);
+        if (status == PICO_OK) {
+            *outNumEntries = (pico_Int32) size;
+            *outUsedEntries = (pico_Int32) used;
+            *outHits = (pico_Int32) hits;
+            *outMisses = (pico_Int32) misses;
+        }
+    }
+
+    return status;
+}
+
 PICO_FUNC picoext_getLastScheduledPU(
         pico_Engine engine
         )
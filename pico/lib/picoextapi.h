@@ -102,6 +102,258 @@ PICO_FUNC picoext_getResourceName(
     );
 */
 
+/* Voice configuration functions **********************************************/
+
+/* Levels of pdf expansion for picoext_setVoicePdfExpansion */
+#define PICOEXT_PDF_EXPAND_NONE 0   /* pdfs are decoded from the lingware at each access (default) */
+#define PICOEXT_PDF_EXPAND_LFZ  1   /* the pitch pdf is expanded */
+#define PICOEXT_PDF_EXPAND_ALL  2   /* the pitch and spectrum pdfs are expanded */
+
+/* Selects which pdfs of the voice 'voiceName' are expanded into 32 bit
+   tables when an engine is created for the voice. Expanded pdfs speed up
+   the parameter generation at the cost of system memory: about 24 bytes per
+   pdf vector and cepstral order, i.e. several times the size of the packed
+   spectrum pdf. They are shared by all voices using the same resource and
+   kept until that resource is unloaded. If memory is short, the pdfs stay
+   packed. Must be called before pico_newEngine. */
+
+PICO_FUNC picoext_setVoicePdfExpansion(
+        pico_System system,
+        const pico_Char *voiceName,
+        pico_Int16 level
+        );
+
+/* Makes engines created for the voice 'voiceName' phonetize instead of
+   synthesize (if 'phonetize' is non-zero): their processing chain ends
+   with the phonetics to acoustics mapping, the parameter and signal
+   generation are not created, and the phones are fetched with
+   picoext_getPhones instead of pico_getData. Such a front-end engine can
+   also deliver its output as item stream (picoext_getItemStream). Must be
+   called before pico_newEngine; 0 restores full synthesis. */
+
+PICO_FUNC picoext_setVoicePhonetize(
+        pico_System system,
+        const pico_Char *voiceName,
+        pico_Int16 phonetize
+        );
+
+/* Makes engines created for the voice 'voiceName' back-end engines (if
+   'backEnd' is non-zero): they consist of the parameter and signal
+   generation only and take an item stream of a front-end engine
+   (picoext_putItemStream) instead of text; the speech is fetched with
+   pico_getData. The voice needs only the speaker resource (*_sg). Must be
+   called before pico_newEngine; 0 restores full synthesis. */
+
+PICO_FUNC picoext_setVoiceBackEnd(
+        pico_System system,
+        const pico_Char *voiceName,
+        pico_Int16 backEnd
+        );
+
+/* Sets how far the working and dynamic memory partitions of the text
+   preprocessing of engines created for the voice 'voiceName' may grow (in
+   bytes, rounded up to whole chunks of the initial partition size and at
+   most 16 chunks); 0 keeps the compile-time default of four chunks. The
+   partitions grow from the engine memory, so a larger limit may need a
+   larger engine. Must be called before pico_newEngine; see
+   picoext_getPreprocMemUsage for sizing. */
+
+PICO_FUNC picoext_setVoicePreprocMemLimit(
+        pico_System system,
+        const pico_Char *voiceName,
+        pico_Int32 workMemMax,
+        pico_Int32 dynMemMax
+        );
+
+
+/* Phonetization functions *****************************************************/
+
+#define PICOEXT_MAX_PHONE_STATES 10
+
+/* A phone as determined for synthesis. F0 targets are the means of the
+   pitch model of each state, before smoothing and pitch modification. */
+typedef struct picoext_phone_record {
+    pico_Int16 phoneId;                                  /* phone id of the voice's phone table */
+    pico_Int16 numStates;                                /* number of valid state entries */
+    pico_Uint32 startMs;                                 /* start time since the last engine reset */
+    pico_Uint32 durationMs;
+    pico_Uint32 stateDurationMs[PICOEXT_MAX_PHONE_STATES];
+    pico_Uint16 stateF0Hz[PICOEXT_MAX_PHONE_STATES];     /* 0 if the state is unvoiced */
+} picoext_PhoneRecord;
+
+/* Counterpart of pico_getData for engines of a phonetizing voice (see
+   picoext_setVoicePhonetize): does one processing step and returns up to
+   'maxRecords' phones in 'outRecords'. Returns PICO_STEP_BUSY while there
+   is more to process, PICO_STEP_IDLE when all input text has been
+   processed, and PICO_STEP_ERROR on errors or if the voice does not
+   phonetize. */
+
+PICO_FUNC picoext_getPhones(
+        pico_Engine engine,
+        picoext_PhoneRecord *outRecords,
+        const pico_Int16 maxRecords,
+        pico_Int16 *outNumRecords
+        );
+
+
+/* Split synthesis functions ***************************************************/
+
+/* The item stream connects a front-end engine (picoext_setVoicePhonetize)
+   with a back-end engine (picoext_setVoiceBackEnd), e.g. in different
+   processes or on different machines. It is a byte stream that starts with
+   a header after every reset of the front-end engine, followed by the
+   phone and command items the phonetics to acoustics mapping produces, in
+   the binary item format of the engine (about 34 bytes per phone). The
+   header holds the stream version and the name of the speaker resource
+   the items refer to; a back-end engine rejects streams of another version
+   or for another resource. */
+
+#define PICOEXT_ITEM_STREAM_MIN_BUFSIZE 260
+
+/* Counterpart of pico_getData for front-end engines: does one processing
+   step and returns the next complete items of the stream, at most
+   'bufferSize' bytes (at least PICOEXT_ITEM_STREAM_MIN_BUFSIZE). Returns
+   PICO_STEP_BUSY while there is more to process, PICO_STEP_IDLE when all
+   input text has been processed and PICO_STEP_ERROR on errors. */
+
+PICO_FUNC picoext_getItemStream(
+        pico_Engine engine,
+        void *buffer,
+        const pico_Int16 bufferSize,
+        pico_Int16 *bytesReceived
+        );
+
+/* Counterpart of pico_putTextUtf8 for back-end engines: feeds 'size' bytes
+   of an item stream, which may be split anywhere. '*bytesPut' is less than
+   'size' if the engine input is full; call pico_getData and feed the rest
+   later. Returns PICO_EXC_UNEXPECTED_FILE_TYPE if the stream does not
+   start with a matching header and PICO_EXC_FILE_CORRUPT for invalid
+   items. After pico_resetEngine the stream must start with a header
+   again. */
+
+PICO_FUNC picoext_putItemStream(
+        pico_Engine engine,
+        const void *bytes,
+        const pico_Int16 size,
+        pico_Int16 *bytesPut
+        );
+
+
+/* Item tap functions **********************************************************/
+
+/* Processing units of an engine, in the order of the processing chain. */
+#define PICOEXT_UNIT_TOK  1   /* tokenization: token items */
+#define PICOEXT_UNIT_PR   2   /* text preprocessing: word graph items */
+#define PICOEXT_UNIT_WA   3   /* word analysis: word index items */
+#define PICOEXT_UNIT_SA   4   /* sentence analysis: word phone items */
+#define PICOEXT_UNIT_ACPH 5   /* accentuation and phrasing: boundary items */
+#define PICOEXT_UNIT_SPHO 6   /* sentence phonology: syllable phone items */
+#define PICOEXT_UNIT_PAM  7   /* phonetics to acoustics mapping: phone items */
+#define PICOEXT_UNIT_CEP  8   /* parameter generation: FRAME_PAR items */
+#define PICOEXT_UNIT_SIG  9   /* signal generation: speech frame items */
+
+/* An item starts with a 4 byte head: item type (a character, see
+   PICODATA_ITEM_* in picodata.h), two info bytes and the length of the
+   content that follows the head. */
+#define PICOEXT_ITEM_HEADSIZE 4
+
+/* Item types needed to follow the timing of words and phones. At the
+   output of PICOEXT_UNIT_SPHO, the syllables of a word are followed by a
+   boundary item; the content of a syllable item are its phone ids, one
+   byte each. A phone item has the phone id in info1; PICOEXT_UNIT_PAM
+   outputs the phones of the syllables in order, with pause phones added
+   at phrase and sentence boundaries, and passes on <mark> commands at
+   their position between the phones (command item with info1
+   PICOEXT_ITEM_CMD_MARKER and the mark name as content). */
+#define PICOEXT_ITEM_SYLLPHON   'y'
+#define PICOEXT_ITEM_BOUND      'b'
+#define PICOEXT_ITEM_PHONE      'h'
+#define PICOEXT_ITEM_CMD        'c'
+#define PICOEXT_ITEM_CMD_MARKER 'm'
+
+/* Called for every item 'unit' outputs, within the pico_getData (or
+   picoext_getPhones, picoext_getItemStream) call that processes it and in
+   processing order. 'item' points into engine memory and is valid only
+   during the call; the tap must not call functions of the engine. */
+typedef void (* picoext_ItemTapCallback)(
+        void *userData,
+        pico_Int16 unit,
+        const pico_Char *item,
+        pico_Int16 itemSize
+        );
+
+/* Attaches 'callback' to the output of 'unit' (PICOEXT_UNIT_*), replacing
+   a tap attached before; a NULL 'callback' detaches it. Taps are kept by
+   pico_resetEngine. Returns PICO_ERR_INVALID_ARGUMENT if the engine has no
+   such unit, e.g. the units of the back end for a phonetizing voice.
+   Items are passed without copying them; units without a tap are not
+   slowed down. */
+
+PICO_FUNC picoext_setItemTap(
+        pico_Engine engine,
+        const pico_Int16 unit,
+        picoext_ItemTapCallback callback,
+        void *userData
+        );
+
+/* Returns in '*outNumSamples' the number of samples synthesized for the
+   phone item 'item' of 'itemSize' bytes (the phones of an utterance add
+   up to its samples). Returns PICO_ERR_INVALID_ARGUMENT if 'item' is not a
+   complete phone item. */
+
+PICO_FUNC picoext_getPhoneItemSamples(
+        const pico_Char *item,
+        const pico_Int16 itemSize,
+        pico_Int32 *outNumSamples
+        );
+
+
+/* Cancellation functions ******************************************************/
+
+/* Cancels the current processing of 'engine'. Unlike the other functions it
+   may be called from another thread while pico_getData runs: the smoothing
+   of the cepstral unit and the backward pass of the PAM stop within a
+   fraction of their usual time, buffered speech data is dropped, and
+   pico_getData returns PICO_STEP_IDLE without output until the engine is
+   reset with pico_resetEngine, which ends the cancellation. */
+
+PICO_FUNC picoext_cancelEngine(
+        pico_Engine engine
+        );
+
+
+/* Lingware conversion functions ***********************************************/
+
+/* Writes the loaded 'resource' as in-place lingware file 'fileName' (with
+   extension ".inp"). The file holds the content of the source file together
+   with the structures that are otherwise computed when loading it (compiled
+   preprocessing networks, the graph index) or when creating an engine
+   (expanded pdfs, written only if the voice of an existing engine has
+   expanded them), and the FST lookahead automata if they have been built
+   with picoext_compileResourceFsts. pico_loadResource maps an in-place file where the
+   platform supports it, so that loading it neither copies the lingware
+   nor recomputes these structures. The structures are stored in the byte
+   order and layout of the current build; other builds load the file but
+   recompute them. */
+
+PICO_FUNC picoext_writeInplaceResource(
+        pico_System system,
+        pico_Resource resource,
+        const pico_Char *fileName
+        );
+
+/* Builds the lookahead automata of the FSTs of the loaded 'resource', to be
+   written with picoext_writeInplaceResource. When an in-place file has them,
+   a transduction is a right-to-left and a left-to-right pass over the
+   phones instead of a backtracking search; the result is the same. Building
+   them is much slower than loading and is meant for converting lingware. */
+
+PICO_FUNC picoext_compileResourceFsts(
+        pico_System system,
+        pico_Resource resource
+        );
+
+
 /* Debugging/testing support functions *****************************************/
 
 /* Sets tracing level. Increasing amounts of information is displayed
@@ -147,6 +399,41 @@ PICO_FUNC picoext_getEngineMemUsage(
         pico_Int32 *outMaxUsedBytes
         );
 
+/* Returns the high-water marks of the working and dynamic memory partitions
+   of the text preprocessing since the last full engine reset, and the
+   current sizes of these partitions, which grow on demand up to the
+   maximum set with picoext_setVoicePreprocMemLimit (all in bytes). */
+PICO_FUNC picoext_getPreprocMemUsage(
+        pico_Engine engine,
+        pico_Int32 *outMaxWorkMemBytes,
+        pico_Int32 *outMaxDynMemBytes,
+        pico_Int32 *outWorkMemSize,
+        pico_Int32 *outDynMemSize
+        );
+
+/* Sets the number of entries of the cache of PAM decision tree results
+   (rounded down to a power of two, at most 32768; 0 disables the cache).
+   Each entry takes 64 bytes of engine memory; PICO_EXC_OUT_OF_MEM is
+   returned and the cache disabled if the engine memory is exhausted.
+   Repeated phonetic contexts then skip the tree traversal, which pays off
+   in workloads synthesizing many similar prompts. */
+PICO_FUNC picoext_setPamTreeCacheSize(
+        pico_Engine engine,
+        pico_Int32 numEntries
+        );
+
+/* Returns the number of entries of the PAM decision tree cache, the number
+   of entries in use and the number of tree lookups answered from the cache
+   (hits) or by tree traversal (misses) since the last full engine reset or
+   cache resize. */
+PICO_FUNC picoext_getPamTreeCacheUsage(
+        pico_Engine engine,
+        pico_Int32 *outNumEntries,
+        pico_Int32 *outUsedEntries,
+        pico_Int32 *outHits,
+        pico_Int32 *outMisses
+        );
+
 PICO_FUNC picoext_getLastScheduledPU(
         pico_Engine engine
         );
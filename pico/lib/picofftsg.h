@@ -45,7 +45,7 @@ extern "C" {
 extern void rdft(int n, int isgn, PICOFFTSG_FFTTYPE *a);
 extern void dfct(int n, float *a, int VAL_SHIFT);
 extern void dfct_nmf(int n, int *a);
-extern float norm_result(int m2, PICOFFTSG_FFTTYPE *tmpX, PICOFFTSG_FFTTYPE *norm_window);
+extern float norm_result(int m2, PICOFFTSG_FFTTYPE *tmpX, const PICOFFTSG_FFTTYPE *norm_window);
 
 #ifdef __cplusplus
 }
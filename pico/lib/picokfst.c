@@ -40,6 +40,19 @@ extern "C" {
 
 #define FileHdrSize 4       /* size of FST file header */
 
+/* lookahead automaton (see picokfst_compileLookahead); its table starts with
+   a header of five uint32 (nr of FST states, nr of input symbols, nr of
+   lookahead states, nr of words of a state set, nr of class transitions),
+   followed by the sorted input symbols, the lookahead transitions, the state
+   sets, the class transition index and the class transitions, each part
+   padded to a multiple of four bytes */
+#define KFST_LA_HEAD_SIZE   20
+#define KFST_LA_MAX_STATES  4096
+#define KFST_LA_MAX_CLASS_TRANS 0xFFFF
+#define KFST_LA_NR_FIXED_CLASSES 2
+#define KFST_LA_SET_SIZE(nrStates) ((picoos_uint32)(nrStates) / 32 + 1)
+#define KFST_ALIGN4(n) (((n) + 3) & ~3)
+
 
 
 /* ************************************************************/
@@ -67,6 +80,18 @@ typedef struct kfst_subobj{
     picoos_int32 transTabPos;         /* absolute address of the start of the transition table */
     picoos_int32 inEpsStateTabPos;    /* absolute address of the start of the input epsilon transition table */
     picoos_int32 accStateTabPos;      /* absolute address of the table of accepting states */
+    picoos_uint8 * laTable;           /* lookahead automaton or NULL */
+    picoos_uint32 laSize;             /* size in bytes of the lookahead automaton */
+    picoos_bool laInImage;            /* lookahead automaton taken from the in-place image */
+    picoos_int32 laNrSyms;            /* nr of input symbols with an input class of their own */
+    picoos_int32 laNrStates;          /* nr of lookahead states */
+    picoos_int32 laSetSize;           /* nr of words in a set of FST states */
+    picokfst_symid_t * laSyms;        /* sorted input symbols; class of laSyms[i] is i + 2 */
+    picoos_uint16 * laNext;           /* lookahead transitions, laNrStates x nr of classes */
+    picoos_uint32 * laSets;           /* FST states of each lookahead state, laNrStates x laSetSize */
+    picoos_uint16 * ctIndex;          /* start of the class transitions of FST state s and
+                                         class c at (s - 1) * nr of classes + c in ctTrans */
+    picokfst_symid_t * ctTrans;       /* class transitions as pairs of output symbol and end state */
 } kfst_subobj_t;
 
 
@@ -141,6 +166,67 @@ static void BytesToNum (picoos_uint8 * stream, picoos_uint32 * pos, picoos_int32
 /* setting up FST from byte stream */
 /* ************************************************************/
 
+/* sets up the access to lookahead automaton 'table' of 'size' bytes;
+   returns FALSE (and leaves 'kfst' unchanged) if it does not fit the FST */
+static picoos_bool kfstSetLookahead (kfst_SubObj kfst, picoos_uint8 * table, picoos_uint32 size)
+{
+    picoos_uint32 * head;
+    picoos_uint32 nrSyms, nrClasses, nrStates, setSize, nrCt, symBytes, nextBytes, setBytes, indexBytes;
+
+    if ((NULL == table) || (size < KFST_LA_HEAD_SIZE)) {
+        return FALSE;
+    }
+    head = (picoos_uint32 *) table;
+    nrSyms = head[1];
+    nrStates = head[2];
+    setSize = head[3];
+    nrCt = head[4];
+    if ((head[0] != (picoos_uint32) kfst->nrStates) || (setSize != KFST_LA_SET_SIZE(kfst->nrStates))
+        || (nrStates == 0) || (nrStates > KFST_LA_MAX_STATES) || (nrSyms > 0x7FFF) || (nrCt > KFST_LA_MAX_CLASS_TRANS)) {
+        return FALSE;
+    }
+    nrClasses = nrSyms + KFST_LA_NR_FIXED_CLASSES;
+    symBytes = KFST_ALIGN4(nrSyms * sizeof(picokfst_symid_t));
+    nextBytes = KFST_ALIGN4(nrStates * nrClasses * sizeof(picoos_uint16));
+    setBytes = nrStates * setSize * sizeof(picoos_uint32);
+    indexBytes = KFST_ALIGN4((kfst->nrStates * nrClasses + 1) * sizeof(picoos_uint16));
+    if (size != KFST_LA_HEAD_SIZE + symBytes + nextBytes + setBytes + indexBytes
+                + KFST_ALIGN4(2 * nrCt * sizeof(picokfst_symid_t))) {
+        return FALSE;
+    }
+    kfst->laTable = table;
+    kfst->laSize = size;
+    kfst->laNrSyms = nrSyms;
+    kfst->laNrStates = nrStates;
+    kfst->laSetSize = setSize;
+    table += KFST_LA_HEAD_SIZE;
+    kfst->laSyms = (picokfst_symid_t *) table;
+    table += symBytes;
+    kfst->laNext = (picoos_uint16 *) table;
+    table += nextBytes;
+    kfst->laSets = (picoos_uint32 *) table;
+    table += setBytes;
+    kfst->ctIndex = (picoos_uint16 *) table;
+    table += indexBytes;
+    kfst->ctTrans = (picokfst_symid_t *) table;
+    return TRUE;
+}
+
+
+static picoos_uint8 * kfstSubGetSection(register picoknow_KnowledgeBase this,
+                                        picoos_uint32 type, picoos_uint32 * size)
+{
+    kfst_SubObj kfst = (kfst_SubObj) this->subObj;
+
+    if ((PICOKNOW_SECTION_FST_LOOKAHEAD == type) && (NULL != kfst->laTable)) {
+        *size = kfst->laSize;
+        return kfst->laTable;
+    }
+    *size = 0;
+    return NULL;
+}
+
+
 static pico_status_t kfstInitialize(register picoknow_KnowledgeBase this,
         picoos_Common common)
 {
@@ -177,6 +263,13 @@ static pico_status_t kfstInitialize(register picoknow_KnowledgeBase this,
     kfst->accStateTabPos = kfst->hdrLen + offs;
     /* -CT- */
 
+    kfst->laTable = picoknow_getSection(this, PICOKNOW_SECTION_FST_LOOKAHEAD, &kfst->laSize);
+    kfst->laInImage = kfstSetLookahead(kfst, kfst->laTable, kfst->laSize);
+    if (!kfst->laInImage) {
+        kfst->laTable = NULL;
+        kfst->laSize = 0;
+    }
+
     return PICO_OK;
 }
 
@@ -184,7 +277,13 @@ static pico_status_t kfstInitialize(register picoknow_KnowledgeBase this,
 static pico_status_t kfstSubObjDeallocate(register picoknow_KnowledgeBase this,
         picoos_MemoryManager mm)
 {
+    kfst_SubObj kfst;
+
     if (NULL != this) {
+        kfst = (kfst_SubObj) this->subObj;
+        if ((NULL != kfst) && (NULL != kfst->laTable) && !kfst->laInImage) {
+            picoos_deallocate(mm, (void *) &kfst->laTable);
+        }
         picoos_deallocate(mm, (void *) &this->subObj);
     }
     return PICO_OK;
@@ -205,6 +304,7 @@ pico_status_t picokfst_specializeFSTKnowledgeBase(picoknow_KnowledgeBase this,
     if (0 < this->size) {
         /* not a dummy kb */
         this->subDeallocate = kfstSubObjDeallocate;
+        this->subGetSection = kfstSubGetSection;
 
         this->subObj = picoos_allocate(common->mm, sizeof(kfst_subobj_t));
 
@@ -431,8 +531,398 @@ extern picoos_bool picokfst_kfstIsAcceptingState (picokfst_FST this, picokfst_st
     }
 }
 
+
+/* ************************************************************/
+/* lookahead automaton */
+/* ************************************************************/
+
+/* The lookahead automaton reads the transduction input from right to left.
+   Its state after reading the input from position i to the end is the set of
+   FST states from which a transduction path can consume that part of the
+   input and end in an accepting state. Lookahead state 0 belongs to the empty
+   rest of the input. The class transitions list, per FST state and input
+   class, the transitions that the pair search yields (in the same order), so
+   that they are found without searching. */
+
+#define KFST_LA_IN_SET(set, s) (((set)[(s) / 32] >> ((s) % 32)) & 1)
+#define KFST_LA_ADD_TO_SET(set, s) ((set)[(s) / 32] |= ((picoos_uint32) 1 << ((s) % 32)))
+
+
+/* returns the nr of input symbols of 'fst' other than epsilon; the symbols are
+   put into 'syms' unless it is NULL */
+static picoos_int32 kfstGetInSyms (kfst_SubObj fst, picokfst_symid_t syms[])
+{
+    picoos_uint32 pos;
+    picoos_int32 h, offs, cellPos, inSym, nextOffs, n;
+
+    n = 0;
+    for (h = 0; h < fst->alphaHashTabSize; h++) {
+        pos = fst->alphaHashTabPos + (h * 4);
+        FixedBytesToSignedNum(fst->fstStream,4,& pos,& offs);
+        if (offs > 0) {
+            cellPos = fst->alphaHashTabPos + offs;
+            do {
+                pos = cellPos;
+                BytesToNum(fst->fstStream,& pos,& inSym);
+                BytesToNum(fst->fstStream,& pos,& nextOffs);
+                if (inSym != PICOKFST_SYMID_EPS) {
+                    if (NULL != syms) {
+                        syms[n] = (picokfst_symid_t) inSym;
+                    }
+                    n++;
+                }
+                cellPos = cellPos + nextOffs;
+            } while (nextOffs > 0);
+        }
+    }
+    return n;
+}
+
+
+/* returns the nr of class transitions of FST state 'state' and input class
+   'laClass' (input symbol 'inSym'); the transitions are put into 'trans'
+   unless it is NULL */
+static picoos_int32 kfstGetClassTrans (kfst_SubObj fst, picokfst_state_t state, picoos_int32 laClass,
+                                       picokfst_symid_t inSym, picokfst_symid_t trans[])
+{
+    picoos_int32 n, searchState;
+    picoos_bool found;
+    picokfst_symid_t outSym;
+    picokfst_class_t pairClass;
+    picokfst_state_t endState;
+
+    n = 0;
+    if (PICOKFST_LACLASS_EPS == laClass) {
+        picokfst_kfstStartInEpsTransSearch((picokfst_FST) fst, state, & found, & searchState);
+        while (found) {
+            picokfst_kfstGetNextInEpsTrans((picokfst_FST) fst, & searchState, & found, & outSym, & endState);
+            if (found && (endState > 0)) {
+                if (NULL != trans) {
+                    trans[2 * n] = outSym;
+                    trans[2 * n + 1] = endState;
+                }
+                n++;
+            }
+        }
+    } else if (laClass >= KFST_LA_NR_FIXED_CLASSES) {
+        picokfst_kfstStartPairSearch((picokfst_FST) fst, inSym, & found, & searchState);
+        while (found) {
+            picokfst_kfstGetNextPair((picokfst_FST) fst, & searchState, & found, & outSym, & pairClass);
+            if (found) {
+                picokfst_kfstGetTrans((picokfst_FST) fst, state, pairClass, & endState);
+                if (endState > 0) {
+                    if (NULL != trans) {
+                        trans[2 * n] = outSym;
+                        trans[2 * n + 1] = endState;
+                    }
+                    n++;
+                }
+            }
+        }
+    }
+    return n;
+}
+
+
+/* adds to 'set' the FST states from which an input epsilon transition leads
+   into 'set' (repeatedly) */
+static void kfstLaEpsClosure (kfst_SubObj fst, picoos_uint32 set[])
+{
+    picoos_bool changed, found;
+    picoos_int32 searchState;
+    picokfst_state_t s, endState;
+    picokfst_symid_t outSym;
+
+    do {
+        changed = FALSE;
+        for (s = 1; s <= fst->nrStates; s++) {
+            if (!KFST_LA_IN_SET(set, s)) {
+                picokfst_kfstStartInEpsTransSearch((picokfst_FST) fst, s, & found, & searchState);
+                while (found) {
+                    picokfst_kfstGetNextInEpsTrans((picokfst_FST) fst, & searchState, & found, & outSym, & endState);
+                    if (found && (endState > 0) && KFST_LA_IN_SET(set, endState)) {
+                        KFST_LA_ADD_TO_SET(set, s);
+                        changed = TRUE;
+                        found = FALSE;
+                    }
+                }
+            }
+        }
+    } while (changed);
+}
+
+
+/* calculates into 'set' the lookahead set for input symbol class 'laClass'
+   (input symbol 'inSym') followed by the input having lookahead set 'next' */
+static void kfstLaPredecessor (kfst_SubObj fst, picoos_int32 laClass, picokfst_symid_t inSym,
+                               const picoos_uint32 next[], picoos_uint32 set[])
+{
+    picoos_uint32 i;
+    picoos_int32 searchState;
+    picoos_bool found;
+    picokfst_state_t s, endState;
+    picokfst_symid_t outSym;
+    picokfst_class_t pairClass;
+
+    for (i = 0; i < KFST_LA_SET_SIZE(fst->nrStates); i++) {
+        set[i] = (PICOKFST_LACLASS_EPS == laClass) ? next[i] : 0;
+    }
+    if (laClass >= KFST_LA_NR_FIXED_CLASSES) {
+        for (s = 1; s <= fst->nrStates; s++) {
+            picokfst_kfstStartPairSearch((picokfst_FST) fst, inSym, & found, & searchState);
+            while (found) {
+                picokfst_kfstGetNextPair((picokfst_FST) fst, & searchState, & found, & outSym, & pairClass);
+                if (found) {
+                    picokfst_kfstGetTrans((picokfst_FST) fst, s, pairClass, & endState);
+                    if ((endState > 0) && KFST_LA_IN_SET(next, endState)) {
+                        KFST_LA_ADD_TO_SET(set, s);
+                        found = FALSE;
+                    }
+                }
+            }
+        }
+    }
+    kfstLaEpsClosure(fst, set);
+}
+
+
+static picoos_uint32 kfstLaHash (const picoos_uint32 set[], picoos_uint32 setSize, picoos_uint32 hashSize)
+{
+    picoos_uint32 i, h;
+
+    h = 0;
+    for (i = 0; i < setSize; i++) {
+        h = h * 31 + set[i];
+    }
+    return h % hashSize;
+}
+
+
+static picoos_bool kfstLaEqualSets (const picoos_uint32 a[], const picoos_uint32 b[], picoos_uint32 setSize)
+{
+    picoos_uint32 i;
+
+    for (i = 0; i < setSize; i++) {
+        if (a[i] != b[i]) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+
+/* see description in header file */
+pico_status_t picokfst_compileLookahead (picoknow_KnowledgeBase this, picoos_Common common)
+{
+    kfst_SubObj fst;
+    picoos_int32 nrSyms, nrClasses, nrStates, nrCt, r, c, i, j;
+    picoos_uint32 setSize, hashSize, h, size, symBytes, nextBytes, setBytes, indexBytes;
+    picokfst_symid_t sym;
+    picokfst_state_t s;
+    picokfst_symid_t * syms;
+    picoos_uint16 * next;
+    picoos_uint16 * hashTab;
+    picoos_uint32 * sets;
+    picoos_uint32 * set;
+    picoos_uint32 * head;
+    picoos_uint16 * ctIndex;
+    picoos_uint8 * table;
+
+    if ((NULL == this) || (NULL == this->subObj) || (kfstSubObjDeallocate != this->subDeallocate)) {
+        /* not an FST kb */
+        return PICO_OK;
+    }
+    fst = (kfst_SubObj) this->subObj;
+    if (NULL != fst->laTable) {
+        return PICO_OK;
+    }
+
+    nrSyms = kfstGetInSyms(fst, NULL);
+    nrClasses = nrSyms + KFST_LA_NR_FIXED_CLASSES;
+    setSize = KFST_LA_SET_SIZE(fst->nrStates);
+    hashSize = 2 * KFST_LA_MAX_STATES + 1;
+    syms = (picokfst_symid_t *) picoos_allocate(common->mm, (nrSyms + 1) * sizeof(picokfst_symid_t));
+    next = (picoos_uint16 *) picoos_allocate(common->mm, KFST_LA_MAX_STATES * nrClasses * sizeof(picoos_uint16));
+    sets = (picoos_uint32 *) picoos_allocate(common->mm, (KFST_LA_MAX_STATES + 1) * setSize * sizeof(picoos_uint32));
+    hashTab = (picoos_uint16 *) picoos_allocate(common->mm, hashSize * sizeof(picoos_uint16));
+    if ((NULL == syms) || (NULL == next) || (NULL == sets) || (NULL == hashTab)) {
+        picoos_deallocate(common->mm, (void *) &syms);
+        picoos_deallocate(common->mm, (void *) &next);
+        picoos_deallocate(common->mm, (void *) &sets);
+        picoos_deallocate(common->mm, (void *) &hashTab);
+        return picoos_emRaiseException(common->em, PICO_EXC_OUT_OF_MEM, NULL, NULL);
+    }
+
+    /* sorted input symbols */
+    kfstGetInSyms(fst, syms);
+    for (i = 1; i < nrSyms; i++) {
+        sym = syms[i];
+        for (j = i; (j > 0) && (syms[j - 1] > sym); j--) {
+            syms[j] = syms[j - 1];
+        }
+        syms[j] = sym;
+    }
+
+    /* subset construction, starting with the end of the input; a new state
+       set is calculated into the slot after the last state */
+    for (h = 0; h < hashSize; h++) {
+        hashTab[h] = 0;
+    }
+    for (h = 0; h < setSize; h++) {
+        sets[h] = 0;
+    }
+    for (s = 1; s <= fst->nrStates; s++) {
+        if (picokfst_kfstIsAcceptingState((picokfst_FST) fst, s)) {
+            KFST_LA_ADD_TO_SET(sets, s);
+        }
+    }
+    kfstLaEpsClosure(fst, sets);
+    hashTab[kfstLaHash(sets, setSize, hashSize)] = 1;
+    nrStates = 1;
+    for (r = 0; (r < nrStates) && (nrStates <= KFST_LA_MAX_STATES); r++) {
+        for (c = 0; (c < nrClasses) && (nrStates <= KFST_LA_MAX_STATES); c++) {
+            set = sets + nrStates * setSize;
+            kfstLaPredecessor(fst, c, (c >= KFST_LA_NR_FIXED_CLASSES) ? syms[c - KFST_LA_NR_FIXED_CLASSES] : 0,
+                              sets + r * setSize, set);
+            h = kfstLaHash(set, setSize, hashSize);
+            while ((hashTab[h] > 0) && !kfstLaEqualSets(sets + (hashTab[h] - 1) * setSize, set, setSize)) {
+                h = (h + 1) % hashSize;
+            }
+            if (0 == hashTab[h]) {
+                hashTab[h] = (picoos_uint16) ++nrStates;
+            }
+            next[r * nrClasses + c] = hashTab[h] - 1;
+        }
+    }
+
+    nrCt = 0;
+    for (s = 1; (s <= fst->nrStates) && (nrStates <= KFST_LA_MAX_STATES); s++) {
+        for (c = 0; c < nrClasses; c++) {
+            nrCt += kfstGetClassTrans(fst, s, c, (c >= KFST_LA_NR_FIXED_CLASSES) ? syms[c - KFST_LA_NR_FIXED_CLASSES] : 0, NULL);
+        }
+    }
+
+    table = NULL;
+    if ((nrStates > KFST_LA_MAX_STATES) || (nrCt > KFST_LA_MAX_CLASS_TRANS)) {
+        PICODBG_WARN(("fst %i is too large for a lookahead automaton; not compiled", this->id));
+    } else {
+        symBytes = KFST_ALIGN4(nrSyms * sizeof(picokfst_symid_t));
+        nextBytes = KFST_ALIGN4(nrStates * nrClasses * sizeof(picoos_uint16));
+        setBytes = nrStates * setSize * sizeof(picoos_uint32);
+        indexBytes = KFST_ALIGN4((fst->nrStates * nrClasses + 1) * sizeof(picoos_uint16));
+        size = KFST_LA_HEAD_SIZE + symBytes + nextBytes + setBytes + indexBytes
+                + KFST_ALIGN4(2 * nrCt * sizeof(picokfst_symid_t));
+        table = (picoos_uint8 *) picoos_allocate(common->mm, size);
+        if (NULL != table) {
+            picoos_mem_set(table, 0, size);
+            head = (picoos_uint32 *) table;
+            head[0] = fst->nrStates;
+            head[1] = nrSyms;
+            head[2] = nrStates;
+            head[3] = setSize;
+            head[4] = nrCt;
+            fst->laInImage = FALSE;
+            kfstSetLookahead(fst, table, size);
+            picoos_mem_copy(syms, fst->laSyms, nrSyms * sizeof(picokfst_symid_t));
+            picoos_mem_copy(next, fst->laNext, nrStates * nrClasses * sizeof(picoos_uint16));
+            picoos_mem_copy(sets, fst->laSets, setBytes);
+            ctIndex = fst->ctIndex;
+            ctIndex[0] = 0;
+            for (s = 1; s <= fst->nrStates; s++) {
+                for (c = 0; c < nrClasses; c++) {
+                    ctIndex[1] = (picoos_uint16) (ctIndex[0] + kfstGetClassTrans(fst, s, c,
+                            (c >= KFST_LA_NR_FIXED_CLASSES) ? syms[c - KFST_LA_NR_FIXED_CLASSES] : 0,
+                            fst->ctTrans + 2 * ctIndex[0]));
+                    ctIndex++;
+                }
+            }
+            PICODBG_DEBUG(("fst %i: %i lookahead states, %i bytes", this->id, nrStates, size));
+        }
+    }
+    picoos_deallocate(common->mm, (void *) &syms);
+    picoos_deallocate(common->mm, (void *) &next);
+    picoos_deallocate(common->mm, (void *) &sets);
+    picoos_deallocate(common->mm, (void *) &hashTab);
+    if ((NULL == table) && (nrStates <= KFST_LA_MAX_STATES) && (nrCt <= KFST_LA_MAX_CLASS_TRANS)) {
+        return picoos_emRaiseException(common->em, PICO_EXC_OUT_OF_MEM, NULL, NULL);
+    }
+    return PICO_OK;
+}
+
+
+/* see description in header file */
+extern picoos_bool picokfst_kfstHasLookahead (picokfst_FST this)
+{
+    kfst_SubObj fst = (kfst_SubObj) this;
+    return (fst != NULL) && (fst->laTable != NULL);
+}
+
+
+/* see description in header file */
+extern picoos_int32 picokfst_kfstGetInputClass (picokfst_FST this, picokfst_symid_t inSym)
+{
+    picoos_int32 lo, hi, mid;
+
+    kfst_SubObj fst = (kfst_SubObj) this;
+    if (inSym == PICOKFST_SYMID_EPS) {
+        return PICOKFST_LACLASS_EPS;
+    }
+    lo = 0;
+    hi = fst->laNrSyms - 1;
+    while (lo <= hi) {
+        mid = (lo + hi) / 2;
+        if (fst->laSyms[mid] < inSym) {
+            lo = mid + 1;
+        } else if (fst->laSyms[mid] > inSym) {
+            hi = mid - 1;
+        } else {
+            return mid + KFST_LA_NR_FIXED_CLASSES;
+        }
+    }
+    return PICOKFST_LACLASS_OTHER;
+}
+
+
+/* see description in header file */
+extern picoos_int32 picokfst_kfstLookaheadStep (picokfst_FST this, picoos_int32 laState, picoos_int32 laClass)
+{
+    kfst_SubObj fst = (kfst_SubObj) this;
+    if ((laState < 0) || (laState >= fst->laNrStates)) {
+        return -1;
+    }
+    return fst->laNext[laState * (fst->laNrSyms + KFST_LA_NR_FIXED_CLASSES) + laClass];
+}
+
+
+/* see description in header file */
+extern picoos_bool picokfst_kfstLookaheadContains (picokfst_FST this, picoos_int32 laState, picokfst_state_t state)
+{
+    kfst_SubObj fst = (kfst_SubObj) this;
+    if ((laState < 0) || (laState >= fst->laNrStates) || (state < 1) || (state > fst->nrStates)) {
+        return FALSE;
+    }
+    return KFST_LA_IN_SET(fst->laSets + laState * fst->laSetSize, state);
+}
+
+
+/* see description in header file */
+extern const picokfst_symid_t * picokfst_kfstGetClassTrans (picokfst_FST this, picokfst_state_t state,
+                                                            picoos_int32 laClass, picoos_int32 * nrTrans)
+{
+    picoos_uint32 i;
+
+    kfst_SubObj fst = (kfst_SubObj) this;
+    if ((state < 1) || (state > fst->nrStates)) {
+        *nrTrans = 0;
+        return NULL;
+    }
+    i = (state - 1) * (fst->laNrSyms + KFST_LA_NR_FIXED_CLASSES) + laClass;
+    *nrTrans = fst->ctIndex[i + 1] - fst->ctIndex[i];
+    return fst->ctTrans + 2 * fst->ctIndex[i];
+}
+
 #ifdef __cplusplus
 }
 #endif
 
-/* End picofst.c */
+/* End picofst.c */
\ No newline at end of file
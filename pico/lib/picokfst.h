@@ -90,6 +90,14 @@ enum picofst_transduction_mode {
 pico_status_t picokfst_specializeFSTKnowledgeBase(picoknow_KnowledgeBase this,
                                                   picoos_Common common);
 
+/* builds the lookahead automaton of FST kb 'this' (see picokfst_kfstHasLookahead),
+ * which is then offered as in-place image section; meant to be done offline
+ * when converting lingware, because the subset construction is expensive.
+ * Kbs that are not FST kbs or already have the automaton are left as they are,
+ * and so is an FST for which the automaton would exceed its size limit. */
+pico_status_t picokfst_compileLookahead(picoknow_KnowledgeBase this,
+                                        picoos_Common common);
+
 
 /* ************************************************************/
 /* FST type and getFST function */
@@ -161,6 +169,38 @@ void picokfst_kfstGetNextInEpsTrans (picokfst_FST this, picoos_int32 * searchSta
    with the terminator symbol pair */
 picoos_bool picokfst_kfstIsAcceptingState (picokfst_FST this, picokfst_state_t state);
 
+/* returns whether the lookahead automaton of FST is available (it is taken
+   from in-place lingware, see picokfst_compileLookahead). The automaton reads
+   an input sequence from right to left; its state after reading the symbols
+   from position i to the end stands for the set of FST states from which a
+   transduction path consumes these symbols and ends in an accepting state.
+   State 0 belongs to the empty rest of the input. The functions below may
+   only be used if the automaton is available */
+picoos_bool picokfst_kfstHasLookahead (picokfst_FST this);
+
+/* input classes of the lookahead automaton; input symbols with pairs have
+   a class of their own above these */
+#define PICOKFST_LACLASS_OTHER 0   /* input symbol without pairs */
+#define PICOKFST_LACLASS_EPS   1   /* input epsilon */
+
+/* returns the input class of input symbol 'inSym' */
+picoos_int32 picokfst_kfstGetInputClass (picokfst_FST this, picokfst_symid_t inSym);
+
+/* returns the lookahead state after reading a symbol of input class 'laClass'
+   (to the left of the input read so far) in lookahead state 'laState', or -1
+   if 'laState' is invalid */
+picoos_int32 picokfst_kfstLookaheadStep (picokfst_FST this, picoos_int32 laState, picoos_int32 laClass);
+
+/* returns whether FST state 'state' belongs to the set of lookahead state 'laState' */
+picoos_bool picokfst_kfstLookaheadContains (picokfst_FST this, picoos_int32 laState, picokfst_state_t state);
+
+/* returns the transitions from FST state 'state' with the pairs of an input
+   symbol of class 'laClass' (in the order of the pair search), or with the
+   input epsilon pairs for class PICOKFST_LACLASS_EPS; the '*nrTrans'
+   transitions are returned as output symbol and end state, alternately */
+const picokfst_symid_t * picokfst_kfstGetClassTrans (picokfst_FST this, picokfst_state_t state,
+                                                     picoos_int32 laClass, picoos_int32 * nrTrans);
+
 #ifdef __cplusplus
 }
 #endif
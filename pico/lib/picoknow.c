@@ -54,8 +54,10 @@ extern picoknow_KnowledgeBase picoknow_newKnowledgeBase(picoos_MemoryManager mm)
         this->id = PICOKNOW_KBID_NULL;
         this->base = NULL;
         this->size = 0;
+        this->image = NULL;
         this->subObj = NULL;
         this->subDeallocate = NULL;
+        this->subGetSection = NULL;
     }
     return this;
 }
@@ -74,6 +76,26 @@ extern void picoknow_disposeKnowledgeBase(picoos_MemoryManager mm, picoknow_Know
     }
 }
 
+extern picoos_uint8 * picoknow_getSection(picoknow_KnowledgeBase this, picoos_uint32 type, picoos_uint32 * size)
+{
+    picoos_uint32 * dir;
+    picoos_uint32 i, n;
+
+    *size = 0;
+    if ((NULL == this) || (NULL == this->image)) {
+        return NULL;
+    }
+    dir = (picoos_uint32 *) this->image;
+    n = dir[1];
+    for (i = 0; i < n; i++) {
+        if ((dir[2 + 4*i] == (picoos_uint32) this->id) && (dir[2 + 4*i + 1] == type)) {
+            *size = dir[2 + 4*i + 3];
+            return this->image + dir[2 + 4*i + 2];
+        }
+    }
+    return NULL;
+}
+
 #ifdef __cplusplus
 }
 #endif
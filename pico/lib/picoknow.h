@@ -158,6 +158,32 @@ typedef enum picoknow_kb_id {
 #define PICOKNOW_MAX_NUM_RESOURCE_KBS 64
 
 
+/* types of the sections of an in-place resource image; a section holds a
+ * structure that a knowledge base otherwise computes at load time */
+typedef enum picoknow_section_type {
+    PICOKNOW_SECTION_NULL          = 0,
+    PICOKNOW_SECTION_KPR_TOKS      = 1, /* compiled preproc tokens */
+    PICOKNOW_SECTION_KPR_ATTRVALS  = 2, /* decoded preproc attribute values */
+    PICOKNOW_SECTION_KPR_STRLC     = 3, /* lowercase preproc strings */
+    PICOKNOW_SECTION_TAB_GRAPHIDX  = 4, /* direct graph index */
+    PICOKNOW_SECTION_PDF_EXPANDED  = 5, /* expanded mul pdf */
+    PICOKNOW_SECTION_FST_LOOKAHEAD = 6  /* lookahead automaton of an fst */
+} picoknow_section_type_t;
+
+#define PICOKNOW_NUM_SECTION_TYPES 7
+
+/* section directory of an in-place resource image, in native byte order:
+ * uint32 PICOKNOW_IMAGE_MAGIC, uint32 number of sections, then per section
+ * uint32 kb id, section type, offset (relative to the directory, a multiple
+ * of PICOKNOW_IMAGE_ALIGN) and size in bytes. The content and the directory
+ * start at file positions that are multiples of PICOKNOW_IMAGE_ALIGN too, so
+ * the sections of a mapped or loaded image are aligned to it */
+#define PICOKNOW_IMAGE_MAGIC 0x706E4950  /* PInp */
+#define PICOKNOW_IMAGE_ALIGN 16
+#define PICOKNOW_IMAGE_DIR_HEAD_SIZE 8
+#define PICOKNOW_IMAGE_DIR_ENTRY_SIZE 16
+
+
 /**  class   : KnowledgeBase
  *   shortcut : kb
  *
@@ -166,15 +192,21 @@ typedef struct picoknow_knowledge_base * picoknow_KnowledgeBase;
 
 typedef pico_status_t (* picoknow_kbSubDeallocate) (register picoknow_KnowledgeBase this, picoos_MemoryManager mm);
 
+/* returns the structure of section type 'type' as it is to be stored in an
+   in-place image, or NULL if the kb has no such structure */
+typedef picoos_uint8 * (* picoknow_kbSubGetSection) (register picoknow_KnowledgeBase this, picoos_uint32 type, picoos_uint32 * size);
+
 typedef struct picoknow_knowledge_base {
     /* public */
     picoknow_KnowledgeBase next;
     picoknow_kb_id_t id;
     picoos_uint8 * base; /* start address */
     picoos_uint32 size; /* size */
+    picoos_uint8 * image; /* section directory of the in-place image or NULL */
 
     /* protected */
     picoknow_kbSubDeallocate subDeallocate;
+    picoknow_kbSubGetSection subGetSection; /* NULL if the kb has no sections */
     void * subObj;
 } picoknow_knowledge_base_t;
 
@@ -182,6 +214,13 @@ extern picoknow_KnowledgeBase picoknow_newKnowledgeBase(picoos_MemoryManager mm)
 
 extern void picoknow_disposeKnowledgeBase(picoos_MemoryManager mm, picoknow_KnowledgeBase * this);
 
+/**
+ * returns the section of type 'type' that the in-place image holds for
+ * knowledge base 'this', or NULL if there is none; 'size' returns its size.
+ * The directory has been validated by the resource manager.
+ */
+extern picoos_uint8 * picoknow_getSection(picoknow_KnowledgeBase this, picoos_uint32 type, picoos_uint32 * size);
+
 #ifdef __cplusplus
 }
 #endif
@@ -84,6 +84,15 @@ extern "C" {
 
 #define KPDF_NUMSTREAMS  3 /* coeff, delta, deltadelta */
 
+/* number of values rounded up to whole PICOKPDF_EXP_ALIGN units */
+#define KPDF_EXP_UNIT  (PICOKPDF_EXP_ALIGN / sizeof(picoos_int32))
+#define KPDF_EXP_ROUND(n)  ((((n) + KPDF_EXP_UNIT - 1) / KPDF_EXP_UNIT) * KPDF_EXP_UNIT)
+
+/* size in bytes of the expanded planes of 'pdfmul' */
+#define KPDF_EXP_SIZE(pdfmul) \
+    ((picoos_uint32) 2 * KPDF_NUMSTREAMS * (pdfmul)->expplanesize \
+        * sizeof(picoos_int32))
+
 
 /* ************************************************************/
 /* pdf loading */
@@ -147,6 +156,8 @@ static pico_status_t kpdfMULInitialize(register picoknow_KnowledgeBase this,
     picoos_uint16 pos;
     picoos_uint8 scmeanpow, maxbigpow, nummean;
     picoos_uint8 i;
+    picoos_uint8 *exp;
+    picoos_uint32 expsize;
 
     if (NULL == this || NULL == this->subObj) {
         return picoos_emRaiseException(common->em, PICO_EXC_KB_MISSING,
@@ -230,6 +241,10 @@ static pico_status_t kpdfMULInitialize(register picoknow_KnowledgeBase this,
         return picoos_emRaiseException(common->em,PICO_EXC_FILE_CORRUPT,NULL,NULL);
     }
     pdfmul->content = &(this->base[pos]);
+    pdfmul->expstride = (pdfmul->ceporder > 1) ? KPDF_EXP_ROUND(pdfmul->ceporder) : 1;
+    pdfmul->expplanesize = KPDF_EXP_ROUND((picoos_uint32) pdfmul->numframes * pdfmul->expstride);
+    pdfmul->expanded = NULL;
+    pdfmul->expandedMem = NULL;
     PICODBG_DEBUG(("numframes %d, vecsize %d, numstates %d, ceporder %d, "
                    "numvuv %d, numdeltas %d, meanpow %d, bigpow %d",
                    pdfmul->numframes, pdfmul->vecsize, pdfmul->numstates,
@@ -242,6 +257,13 @@ static pico_status_t kpdfMULInitialize(register picoknow_KnowledgeBase this,
         return picoos_emRaiseException(common->em, PICO_EXC_FILE_CORRUPT,
                                        NULL, NULL);
     }
+    /* take the expanded tables from the in-place image if they are there;
+       image sections are aligned to PICOKNOW_IMAGE_ALIGN, a multiple of
+       PICOKPDF_EXP_ALIGN */
+    exp = picoknow_getSection(this, PICOKNOW_SECTION_PDF_EXPANDED, &expsize);
+    if ((NULL != exp) && (expsize == KPDF_EXP_SIZE(pdfmul))) {
+        pdfmul->expanded = (picoos_int32 *) exp;
+    }
     PICODBG_DEBUG(("mul pdf initialized"));
     return PICO_OK;
 }
@@ -280,11 +302,26 @@ static pico_status_t kpdfMULSubObjDeallocate(register picoknow_KnowledgeBase thi
         pdfmul = (picokpdf_pdfmul_t *)this->subObj;
         picoos_deallocate(mm,(void *) &(pdfmul->meanpowUm));
         picoos_deallocate(mm,(void *) &(pdfmul->ivarpow));
+        if (NULL != pdfmul->expandedMem) {
+            picoos_deallocate(mm,(void *) &(pdfmul->expandedMem));
+        }
         picoos_deallocate(mm, (void *) &(this->subObj));
     }
     return PICO_OK;
 }
 
+static picoos_uint8 * kpdfMULSubGetSection(register picoknow_KnowledgeBase this,
+                                           picoos_uint32 type, picoos_uint32 * size) {
+    picokpdf_pdfmul_t *pdfmul = (picokpdf_pdfmul_t *)this->subObj;
+
+    if ((PICOKNOW_SECTION_PDF_EXPANDED == type) && (NULL != pdfmul->expanded)) {
+        *size = KPDF_EXP_SIZE(pdfmul);
+        return (picoos_uint8 *) pdfmul->expanded;
+    }
+    *size = 0;
+    return NULL;
+}
+
 static pico_status_t kpdfDURSubObjDeallocate(register picoknow_KnowledgeBase this,
                                           picoos_MemoryManager mm) {
     if (NULL != this) {
@@ -326,6 +363,7 @@ pico_status_t picokpdf_specializePdfKnowledgeBase(picoknow_KnowledgeBase this,
             break;
         case PICOKPDF_KPDFTYPE_MUL:
             this->subDeallocate = kpdfMULSubObjDeallocate;
+            this->subGetSection = kpdfMULSubGetSection;
             this->subObj = picoos_allocate(common->mm,sizeof(picokpdf_pdfmul_t));
             if (NULL == this->subObj) {
                 return picoos_emRaiseException(common->em, PICO_EXC_OUT_OF_MEM,
@@ -356,6 +394,140 @@ pico_status_t picokpdf_specializePdfKnowledgeBase(picoknow_KnowledgeBase this,
 }
 
 
+/* ************************************************************/
+/* pdf expansion */
+/* ************************************************************/
+
+/* decodes value 'cepnum' of plane 'plane' (see PICOKPDF_EXP_MEAN) of vector
+   'vecind' from the packed vectors, scaled as in the expanded planes; the
+   same decoding as the (inlined) getFromPdf of picocep */
+static picoos_int32 kpdfDecodeMUL(const picokpdf_PdfMUL this,
+                                  picoos_uint16 vecind, picoos_uint8 plane,
+                                  picoos_uint8 cepnum)
+{
+    picoos_uint8 s, ind, ceporder, ceporder2, cc;
+    picoos_uint8 *p;
+    picoos_uint32 k, vecstart;
+
+    vecstart = (picoos_uint32) vecind * this->vecsize;
+    ceporder = this->ceporder;
+    if (plane >= PICOKPDF_EXP_IVAR) {
+        cc = (plane - PICOKPDF_EXP_IVAR) * ceporder + cepnum;
+        if (this->numdeltas == 0xFF) {
+            k = vecstart + this->numvuv + ceporder * 6 + cc;
+        } else {
+            k = vecstart + this->numvuv + ceporder * 2
+                    + this->numdeltas * 3 + cc;
+        }
+        return (picoos_int32) (this->content[k]) << (this->ivarpow[cc]);
+    }
+    if ((this->numdeltas == 0xFF) || (plane == PICOKPDF_EXP_MEAN)) {
+        cc = (plane - PICOKPDF_EXP_MEAN) * ceporder + cepnum;
+        p = this->content + (vecstart + this->numvuv + cc * 2);
+        return ((picoos_int32) ((picoos_int16) (*(p + 1) << 8)) | *p)
+                << (this->meanpowUm[cc]);
+    }
+    ceporder2 = ceporder * 2;
+    if (plane == PICOKPDF_EXP_MEAN + 1) {
+        /* sparse delta means: search the index column from the start */
+        s = 0;
+        ind = 0;
+        while ((s < this->numdeltas)
+                && (ind < cepnum || (ind == 0 && cepnum == 0))) {
+            k = vecstart + this->numvuv + ceporder2 + s;
+            ind = this->content[k];
+            if (ind == cepnum) {
+                k = vecstart + this->numvuv + ceporder2
+                        + this->numdeltas + s * 2;
+                return ((picoos_int32) ((picoos_int16) ((this->content[k + 1]) << 8))
+                        | this->content[k]) << (this->meanpowUm[ceporder + cepnum]);
+            }
+            s++;
+        }
+        return 0;
+    }
+    /* sparse delta delta means: search the index column from the end */
+    s = this->numdeltas;
+    ind = ceporder2;
+    while ((s-- > 0) && (ind > ceporder + cepnum)) {
+        k = vecstart + this->numvuv + ceporder2 + s;
+        ind = this->content[k];
+        if (ind == ceporder + cepnum) {
+            k = vecstart + this->numvuv + ceporder2 + this->numdeltas + s * 2;
+            return ((picoos_int32) ((picoos_int16) ((this->content[k + 1]) << 8))
+                    | this->content[k]) << (this->meanpowUm[ceporder2 + cepnum]);
+        }
+    }
+    return 0;
+}
+
+pico_status_t picokpdf_expandPdfMUL(picoknow_KnowledgeBase this,
+                                    picoos_Common common)
+{
+    picokpdf_pdfmul_t *pdfmul;
+    picoos_int32 *v;
+    picoos_uint8 rem;
+    picoos_uint16 i;
+    picoos_uint8 plane, cepnum;
+
+    if ((NULL == this) || (NULL == this->subObj)) {
+        return PICO_ERR_NULLPTR_ACCESS;
+    }
+    pdfmul = (picokpdf_pdfmul_t *)this->subObj;
+    if (NULL != pdfmul->expanded) {
+        return PICO_OK;
+    }
+    /* the memory manager aligns to PICOOS_ALIGN_SIZE only */
+    pdfmul->expandedMem = picoos_allocate(common->mm,
+            (picoos_objsize_t) KPDF_EXP_SIZE(pdfmul) + PICOKPDF_EXP_ALIGN);
+    if (NULL == pdfmul->expandedMem) {
+        return PICO_EXC_OUT_OF_MEM;
+    }
+    rem = (uintptr_t) pdfmul->expandedMem % PICOKPDF_EXP_ALIGN;
+    pdfmul->expanded = (picoos_int32 *) ((picoos_uint8 *) pdfmul->expandedMem
+            + ((rem > 0) ? (PICOKPDF_EXP_ALIGN - rem) : 0));
+    picoos_mem_set(pdfmul->expanded, 0, KPDF_EXP_SIZE(pdfmul));
+    for (plane = 0; plane < 2 * KPDF_NUMSTREAMS; plane++) {
+        for (i = 0; i < pdfmul->numframes; i++) {
+            v = PICOKPDF_EXP_ROW(pdfmul, plane, i);
+            for (cepnum = 0; cepnum < pdfmul->ceporder; cepnum++) {
+                v[cepnum] = kpdfDecodeMUL(pdfmul, i, plane, cepnum);
+            }
+        }
+    }
+    PICODBG_DEBUG(("mul pdf expanded, %d bytes", KPDF_EXP_SIZE(pdfmul)));
+    return PICO_OK;
+}
+
+picoos_single picokpdf_getStaticMeanMUL(const picokpdf_PdfMUL this,
+                                        picoos_uint16 vecind,
+                                        picoos_uint8 cepnum)
+{
+    picoos_int32 mean, ivar;
+
+    if (NULL != this->expanded) {
+        mean = PICOKPDF_EXP_ROW(this, PICOKPDF_EXP_MEAN, vecind)[cepnum];
+        ivar = PICOKPDF_EXP_ROW(this, PICOKPDF_EXP_IVAR, vecind)[cepnum];
+    } else {
+        mean = kpdfDecodeMUL(this, vecind, PICOKPDF_EXP_MEAN, cepnum);
+        ivar = kpdfDecodeMUL(this, vecind, PICOKPDF_EXP_IVAR, cepnum);
+    }
+    if (ivar <= 0) {
+        return (picoos_single) 0;
+    }
+    /* both are scaled by the inverse variance */
+    return (picoos_single) mean / (picoos_single) ivar;
+}
+
+picoos_bool picokpdf_isVoicedMUL(const picokpdf_PdfMUL this,
+                                 picoos_uint16 vecind)
+{
+    /* odd value is voiced, even if unvoiced (see picocep) */
+    return (this->numvuv > 0)
+            && (this->content[(picoos_uint32) vecind * this->vecsize] & 0x01);
+}
+
+
 /* ************************************************************/
 /* pdf getPdf* */
 /* ************************************************************/
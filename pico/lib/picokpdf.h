@@ -122,6 +122,10 @@ typedef struct picokpdf_pdfmul {
     picoos_uint8 *meanpowUm;  /* KPDF_NUMSTREAMS x ceporder values */
     picoos_uint8 *ivarpow;    /* KPDF_NUMSTREAMS x ceporder values */
     picoos_uint8 *content;
+    picoos_uint16 expstride;  /* number of values per row of the expanded planes */
+    picoos_uint32 expplanesize; /* number of values per expanded plane */
+    picoos_int32 *expanded;   /* NULL or the expanded planes, see picokpdf_expandPdfMUL */
+    void *expandedMem;        /* memory holding expanded, NULL if it is in the in-place image */
 } picokpdf_pdfmul_t;
 
 /* subobj specific for pdf phs type */
@@ -152,6 +156,58 @@ picokpdf_PdfPHS picokpdf_getPdfPHS(picoknow_KnowledgeBase this);
 /* PDF MUL functions */
 /* ************************************************************/
 
+/* planes of an expanded mul pdf; the plane of a value is the group plus
+   its stream (0 static, 1 delta, 2 delta delta) */
+#define PICOKPDF_EXP_MEAN  0  /* static, delta and delta delta means */
+#define PICOKPDF_EXP_IVAR  3  /* static, delta and delta delta inverse variances */
+
+/* alignment in bytes of the expanded planes and of their rows */
+#define PICOKPDF_EXP_ALIGN 16
+
+/* start of the row of vector 'vecind' in plane 'plane' of the expanded
+   mul pdf 'pdf' */
+#define PICOKPDF_EXP_ROW(pdf, plane, vecind) \
+    ((pdf)->expanded + (picoos_uint32) (plane) * (pdf)->expplanesize \
+        + (picoos_uint32) (vecind) * (pdf)->expstride)
+
+/**
+ * expands the packed vectors of a mul pdf into 32 bit tables
+ *
+ * The expanded pdf consists of 2 x KPDF_NUMSTREAMS planes, the static,
+ * delta and delta delta means followed by the static, delta and delta
+ * delta inverse variances, all scaled to the fixed point representation
+ * used by picocep (absent sparse delta means are 0). Each plane starts at
+ * a multiple of PICOKPDF_EXP_ALIGN bytes and holds a row of ceporder values
+ * per vector (see PICOKPDF_EXP_ROW). Rows of more than one value are padded
+ * with zeros to expstride values so that they are aligned as well; rows of
+ * a single value (the pitch pdf) are not, the plane is then one aligned
+ * vector over all pdf vectors. The tables are allocated from the memory
+ * manager of 'common' and kept until the knowledge base is disposed;
+ * calling the function again has no effect, as does calling it for a pdf
+ * whose expanded tables come with an in-place image.
+ *
+ * @return PICO_OK, or PICO_EXC_OUT_OF_MEM if the tables could not be
+ *         allocated, in which case the pdf stays packed
+ */
+pico_status_t picokpdf_expandPdfMUL(picoknow_KnowledgeBase this,
+                                    picoos_Common common);
+
+/**
+ * returns the static mean of coefficient 'cepnum' of vector 'vecind' of a
+ * mul pdf as natural value, i.e. the value the parameter generation of
+ * picocep settles on within a long state (the log F0 for the pitch pdf)
+ */
+picoos_single picokpdf_getStaticMeanMUL(const picokpdf_PdfMUL this,
+                                        picoos_uint16 vecind,
+                                        picoos_uint8 cepnum);
+
+/**
+ * returns TRUE if vector 'vecind' of a mul pdf with voicing information
+ * (the spectrum pdf) is voiced
+ */
+picoos_bool picokpdf_isVoicedMUL(const picokpdf_PdfMUL this,
+                                 picoos_uint16 vecind);
+
 #ifdef __cplusplus
 }
 #endif
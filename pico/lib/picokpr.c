@@ -27,6 +27,7 @@
  */
 #include "picoos.h"
 #include "picodbg.h"
+#include "picobase.h"
 #include "picodata.h"
 #include "picoknow.h"
 #include "picokpr.h"
@@ -118,6 +119,18 @@ typedef picoos_uint8 picokpr_Tok[KPR_TOK_SIZE];
 typedef picoos_uint8 picokpr_Prod[KPR_PROD_SIZE];
 typedef picoos_uint8 picokpr_Ctx[KPR_CTX_SIZE];
 
+/* load-time compiled network token: the fields of picokpr_Tok decoded to
+   native integers */
+typedef struct kpr_ctok
+{
+    picokpr_TokSetWP setWP;
+    picokpr_TokSetNP setNP;
+    picokpr_TokArrOffset nextOfs;
+    picokpr_TokArrOffset altLOfs;
+    picokpr_TokArrOffset altROfs;
+    picokpr_AttrValArrOffset attribOfs;
+} kpr_CTok;
+
 /* variable array types */
 typedef picokpr_Str * picokpr_VarStrArr;
 typedef picokpr_LexCat2 * picokpr_VarLexCatArr;
@@ -157,6 +170,13 @@ typedef struct kpr_subobj
     picokpr_Tok * rTokArr;
     picokpr_Prod * rProdArr;
     picokpr_Ctx * rCtxArr;
+
+    /* load-time compiled network (see kpr_compile); each array is NULL if
+       not available, the accessors then decode the raw arrays */
+    kpr_CTok * cTokArr;
+    picoos_int32 * cAttrValArr;
+    picoos_uint8 * cStrLcArr;
+    picoos_bool cInImage; /* compiled arrays are sections of the in-place image */
 } kpr_subobj_t;
 
 
@@ -166,6 +186,149 @@ static picoos_uint32 kpr_getUInt32(picoos_uint8 * p)
 }
 
 
+static picoos_int32 kpr_decodeInt32(picoos_uint8 * p)
+{
+    picoos_uint32 c = kpr_getUInt32(p);
+
+    if (c > KPR_MAX_INT32) {
+        return (c - KPR_MAX_INT32) - 1;
+    } else {
+        return (((int)c + (int) -(KPR_MAX_INT32)) - 1);
+    }
+}
+
+
+/* builds the lowercase string array: cStrLcArr[ofs] is the lowercase form of
+   the string at rStrArr[ofs], so strings can be compared case-insensitively
+   with a plain byte comparison; only possible if lowercasing preserves the
+   byte length of every character, otherwise cStrLcArr stays NULL */
+static void kpr_compileStrLc(kpr_subobj_t * kpr, picoos_MemoryManager mm)
+{
+    picoos_int32 pos, i, len;
+    picobase_utf8char utf8char;
+    picoos_uint8 lc[PICOBASE_UTF8_MAXLEN+1];
+    picoos_uint8 done;
+
+    kpr->cStrLcArr = picoos_allocate(mm, kpr->rStrArrLen);
+    if (NULL == kpr->cStrLcArr) {
+        return;
+    }
+    pos = 0;
+    while (pos < kpr->rStrArrLen) {
+        if (kpr->rStrArr[pos] == 0) {
+            kpr->cStrLcArr[pos++] = 0;
+            continue;
+        }
+        len = picobase_det_utf8_length(kpr->rStrArr[pos]);
+        if ((len == 0) || (pos + len > kpr->rStrArrLen)) {
+            break;
+        }
+        for (i = 0; (i < len) && (kpr->rStrArr[pos+i] != 0); i++) {
+            utf8char[i] = kpr->rStrArr[pos+i];
+        }
+        utf8char[i] = 0;
+        if (i < len) {
+            break;
+        }
+        picobase_lowercase_utf8_str(utf8char, (picoos_char *)lc, PICOBASE_UTF8_MAXLEN+1, &done);
+        if (((picoos_int32)picoos_strlen((picoos_char *)lc) != len) || (picobase_det_utf8_length(lc[0]) != len)) {
+            break;
+        }
+        for (i = 0; i < len; i++) {
+            kpr->cStrLcArr[pos++] = lc[i];
+        }
+    }
+    if (pos < kpr->rStrArrLen) {
+        PICODBG_WARN(("no lowercase string array, string at %i", pos));
+        picoos_deallocate(mm, (void *) &kpr->cStrLcArr);
+    }
+}
+
+
+/* compiles the network at load time: tokens and attribute values are
+   decoded once instead of on every access while matching; the raw arrays
+   stay in use for what cannot be allocated */
+static void kpr_compile(kpr_subobj_t * kpr, picoos_MemoryManager mm)
+{
+    picoos_int32 i;
+    picoos_uint8 * p;
+
+    kpr->cTokArr = picoos_allocate(mm, kpr->rTokArrLen * sizeof(kpr_CTok));
+    if (NULL != kpr->cTokArr) {
+        for (i = 0; i < kpr->rTokArrLen; i++) {
+            p = (picoos_uint8 *)&(kpr->rTokArr[i]);
+            kpr->cTokArr[i].setWP = kpr_getUInt32(&p[KPR_TOK_SETWP_OFS]);
+            kpr->cTokArr[i].setNP = kpr_getUInt32(&p[KPR_TOK_SETNP_OFS]);
+            kpr->cTokArr[i].nextOfs = p[KPR_TOK_NEXTOFS_OFS+0] + 256*p[KPR_TOK_NEXTOFS_OFS+1];
+            kpr->cTokArr[i].altLOfs = p[KPR_TOK_ALTLOFS_OFS+0] + 256*p[KPR_TOK_ALTLOFS_OFS+1];
+            kpr->cTokArr[i].altROfs = p[KPR_TOK_ALTROFS_OFS+0] + 256*p[KPR_TOK_ALTROFS_OFS+1];
+            kpr->cTokArr[i].attribOfs = p[KPR_TOK_ATTRIBOFS_OFS+0] + 256*p[KPR_TOK_ATTRIBOFS_OFS+1];
+        }
+    }
+    kpr->cAttrValArr = picoos_allocate(mm, kpr->rAttrValArrLen * sizeof(picoos_int32));
+    if (NULL != kpr->cAttrValArr) {
+        for (i = 0; i < kpr->rAttrValArrLen; i++) {
+            kpr->cAttrValArr[i] = kpr_decodeInt32(&(kpr->rAttrValArr[i][KPR_ATTRVAL_INT_OFS]));
+        }
+    }
+    kpr_compileStrLc(kpr, mm);
+}
+
+
+/* takes the compiled network from the in-place image if it holds it for
+   this network; returns FALSE if the network has to be compiled */
+static picoos_bool kpr_adoptImage(picoknow_KnowledgeBase this, kpr_subobj_t * kpr)
+{
+    picoos_uint8 * tok, * attrVal, * strLc;
+    picoos_uint32 tokSize, attrValSize, strLcSize;
+
+    tok = picoknow_getSection(this, PICOKNOW_SECTION_KPR_TOKS, &tokSize);
+    attrVal = picoknow_getSection(this, PICOKNOW_SECTION_KPR_ATTRVALS, &attrValSize);
+    strLc = picoknow_getSection(this, PICOKNOW_SECTION_KPR_STRLC, &strLcSize);
+    if ((NULL == tok) || (tokSize != kpr->rTokArrLen * sizeof(kpr_CTok))
+        || (NULL == attrVal) || (attrValSize != kpr->rAttrValArrLen * sizeof(picoos_int32))
+        || ((NULL != strLc) && (strLcSize != (picoos_uint32) kpr->rStrArrLen))) {
+        return FALSE;
+    }
+    kpr->cTokArr = (kpr_CTok *) tok;
+    kpr->cAttrValArr = (picoos_int32 *) attrVal;
+    kpr->cStrLcArr = strLc;
+    return TRUE;
+}
+
+
+static picoos_uint8 * kprSubGetSection(register picoknow_KnowledgeBase this,
+                                       picoos_uint32 type, picoos_uint32 * size)
+{
+    kpr_subobj_t * kpr = (kpr_subobj_t *) this->subObj;
+
+    *size = 0;
+    switch (type) {
+        case PICOKNOW_SECTION_KPR_TOKS:
+            if (NULL != kpr->cTokArr) {
+                *size = kpr->rTokArrLen * sizeof(kpr_CTok);
+                return (picoos_uint8 *) kpr->cTokArr;
+            }
+            break;
+        case PICOKNOW_SECTION_KPR_ATTRVALS:
+            if (NULL != kpr->cAttrValArr) {
+                *size = kpr->rAttrValArrLen * sizeof(picoos_int32);
+                return (picoos_uint8 *) kpr->cAttrValArr;
+            }
+            break;
+        case PICOKNOW_SECTION_KPR_STRLC:
+            if (NULL != kpr->cStrLcArr) {
+                *size = kpr->rStrArrLen;
+                return kpr->cStrLcArr;
+            }
+            break;
+        default:
+            break;
+    }
+    return NULL;
+}
+
+
 static pico_status_t kprInitialize(register picoknow_KnowledgeBase this,
                                    picoos_Common common)
 {
@@ -179,6 +342,10 @@ static pico_status_t kprInitialize(register picoknow_KnowledgeBase this,
                                        NULL, NULL);
     }
     kpr = (kpr_subobj_t *) this->subObj;
+    kpr->cTokArr = NULL;
+    kpr->cAttrValArr = NULL;
+    kpr->cStrLcArr = NULL;
+    kpr->cInImage = FALSE;
 
     kpr->rStrArrLen = kpr_getUInt32(&(this->base[KPR_STRARRLEN_OFFSET]));
     kpr->rLexCatArrLen = kpr_getUInt32(&(this->base[KPR_LEXCATARRLEN_OFFSET]));
@@ -219,6 +386,11 @@ static pico_status_t kprInitialize(register picoknow_KnowledgeBase this,
 
     kpr->rNetName = &(kpr->rStrArr[kpr_getUInt32(&(this->base[KPR_NETNAME_OFFSET]))]);
 
+    kpr->cInImage = kpr_adoptImage(this, kpr);
+    if (!kpr->cInImage) {
+        kpr_compile(kpr, common->mm);
+    }
+
     return PICO_OK;
 }
 
@@ -226,7 +398,21 @@ static pico_status_t kprInitialize(register picoknow_KnowledgeBase this,
 static pico_status_t kprSubObjDeallocate(register picoknow_KnowledgeBase this,
                                          picoos_MemoryManager mm)
 {
+    kpr_subobj_t * kpr;
+
     if (NULL != this) {
+        kpr = (kpr_subobj_t *) this->subObj;
+        if ((NULL != kpr) && !kpr->cInImage) {
+            if (NULL != kpr->cTokArr) {
+                picoos_deallocate(mm, (void *) &kpr->cTokArr);
+            }
+            if (NULL != kpr->cAttrValArr) {
+                picoos_deallocate(mm, (void *) &kpr->cAttrValArr);
+            }
+            if (NULL != kpr->cStrLcArr) {
+                picoos_deallocate(mm, (void *) &kpr->cStrLcArr);
+            }
+        }
         picoos_deallocate(mm, (void *) &this->subObj);
     }
     return PICO_OK;
@@ -245,6 +431,7 @@ pico_status_t picokpr_specializePreprocKnowledgeBase(picoknow_KnowledgeBase this
                                        NULL, NULL);
     }
     this->subDeallocate = kprSubObjDeallocate;
+    this->subGetSection = kprSubGetSection;
     this->subObj = picoos_allocate(common->mm, sizeof(kpr_subobj_t));
     if (NULL == this->subObj) {
         return picoos_emRaiseException(common->em, PICO_EXC_OUT_OF_MEM,
@@ -278,6 +465,14 @@ extern picokpr_VarStrPtr picokpr_getVarStrPtr(picokpr_Preproc preproc, picokpr_S
     return p;
 }
 
+extern picokpr_VarStrPtr picokpr_getVarStrLcPtr(picokpr_Preproc preproc, picokpr_StrArrOffset ofs)
+{
+    if (NULL == ((kpr_SubObj)preproc)->cStrLcArr) {
+        return NULL;
+    }
+    return (picoos_uint8 *)&(((kpr_SubObj)preproc)->cStrLcArr[ofs]);
+}
+
 /* *****************************************************************************/
 
 extern picoos_bool picokpr_isEqual (picokpr_Preproc preproc, picoos_uchar str[], picoos_int32 len__9, picokpr_StrArrOffset str2)
@@ -341,11 +536,17 @@ extern picokpr_LexCat picokpr_getLexCat(picokpr_Preproc preproc, picokpr_LexCatA
 
 extern picoos_int32 picokpr_getAttrValArrInt32(picokpr_Preproc preproc, picokpr_AttrValArrOffset ofs)
 {
-    picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rAttrValArr[ofs]);
-    picoos_uint32 c =              p[KPR_ATTRVAL_INT_OFS] +
-                               256*p[KPR_ATTRVAL_INT_OFS+1] +
-                           256*256*p[KPR_ATTRVAL_INT_OFS+2] +
-                       256*256*256*p[KPR_ATTRVAL_INT_OFS+3];
+    picoos_uint8 * p;
+    picoos_uint32 c;
+
+    if (NULL != ((kpr_SubObj)preproc)->cAttrValArr) {
+        return ((kpr_SubObj)preproc)->cAttrValArr[ofs];
+    }
+    p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rAttrValArr[ofs]);
+    c =              p[KPR_ATTRVAL_INT_OFS] +
+                 256*p[KPR_ATTRVAL_INT_OFS+1] +
+             256*256*p[KPR_ATTRVAL_INT_OFS+2] +
+         256*256*256*p[KPR_ATTRVAL_INT_OFS+3];
 
     if (c > KPR_MAX_INT32) {
         return (c - KPR_MAX_INT32) - 1;
@@ -430,10 +631,15 @@ extern picokpr_OutItemArrOffset picokpr_getOutItemArgOfs(picokpr_Preproc preproc
 extern picokpr_TokSetNP picokpr_getTokSetNP(picokpr_Preproc preproc, picokpr_TokArrOffset ofs)
 {
     picoos_uint32 c/*, b*/;
-    picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]) + KPR_TOK_SETNP_OFS;
-    /*picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]);*/
+    picoos_uint8 * p;
     picoos_uint32 p0, p1, p2, p3;
 
+    if (NULL != ((kpr_SubObj)preproc)->cTokArr) {
+        return ((kpr_SubObj)preproc)->cTokArr[ofs].setNP;
+    }
+    p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]) + KPR_TOK_SETNP_OFS;
+    /*picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]);*/
+
         p0 = *(p++);
         p1 = *(p++);
         p2 = *(p++);
@@ -467,10 +673,15 @@ extern picokpr_TokSetNP picokpr_getTokSetNP(picokpr_Preproc preproc, picokpr_Tok
 extern picokpr_TokSetWP picokpr_getTokSetWP(picokpr_Preproc preproc, picokpr_TokArrOffset ofs)
 {
     picoos_uint32 c/*, b*/;
-    /* picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]);*/
-    picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]) + KPR_TOK_SETWP_OFS;
+    picoos_uint8 * p;
     picoos_uint32 p0, p1, p2, p3;
 
+    if (NULL != ((kpr_SubObj)preproc)->cTokArr) {
+        return ((kpr_SubObj)preproc)->cTokArr[ofs].setWP;
+    }
+    /* picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]);*/
+    p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]) + KPR_TOK_SETWP_OFS;
+
     p0 = *(p++);
     p1 = *(p++);
     p2 = *(p++);
@@ -502,7 +713,12 @@ extern picokpr_TokSetWP picokpr_getTokSetWP(picokpr_Preproc preproc, picokpr_Tok
 
 extern picokpr_TokArrOffset picokpr_getTokNextOfs(picokpr_Preproc preproc, picokpr_TokArrOffset ofs)
 {
-    picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]);
+    picoos_uint8 * p;
+
+    if (NULL != ((kpr_SubObj)preproc)->cTokArr) {
+        return ((kpr_SubObj)preproc)->cTokArr[ofs].nextOfs;
+    }
+    p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]);
 
     return p[KPR_TOK_NEXTOFS_OFS+0] + 256*p[KPR_TOK_NEXTOFS_OFS+1];
 }
@@ -510,8 +726,14 @@ extern picokpr_TokArrOffset picokpr_getTokNextOfs(picokpr_Preproc preproc, picok
 
 extern picokpr_TokArrOffset picokpr_getTokAltLOfs(picokpr_Preproc preproc, picokpr_TokArrOffset ofs)
 {
-    picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]) + KPR_TOK_ALTLOFS_OFS;
-    picokpr_TokArrOffset c = *p++;
+    picoos_uint8 * p;
+    picokpr_TokArrOffset c;
+
+    if (NULL != ((kpr_SubObj)preproc)->cTokArr) {
+        return ((kpr_SubObj)preproc)->cTokArr[ofs].altLOfs;
+    }
+    p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]) + KPR_TOK_ALTLOFS_OFS;
+    c = *p++;
     return c +   256**p;
 
     /*picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]);
@@ -523,8 +745,14 @@ extern picokpr_TokArrOffset picokpr_getTokAltLOfs(picokpr_Preproc preproc, picok
 
 extern picokpr_TokArrOffset picokpr_getTokAltROfs(picokpr_Preproc preproc, picokpr_TokArrOffset ofs)
 {
-     picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]) + KPR_TOK_ALTROFS_OFS;
-    picokpr_TokArrOffset c = *p++;
+    picoos_uint8 * p;
+    picokpr_TokArrOffset c;
+
+    if (NULL != ((kpr_SubObj)preproc)->cTokArr) {
+        return ((kpr_SubObj)preproc)->cTokArr[ofs].altROfs;
+    }
+    p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]) + KPR_TOK_ALTROFS_OFS;
+    c = *p++;
     return c +   256**p;
 
     /*picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]);
@@ -535,7 +763,12 @@ extern picokpr_TokArrOffset picokpr_getTokAltROfs(picokpr_Preproc preproc, picok
 
 extern picokpr_AttrValArrOffset picokpr_getTokAttribOfs(picokpr_Preproc preproc, picokpr_TokArrOffset ofs)
 {
-    picoos_uint8 * p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]);
+    picoos_uint8 * p;
+
+    if (NULL != ((kpr_SubObj)preproc)->cTokArr) {
+        return ((kpr_SubObj)preproc)->cTokArr[ofs].attribOfs;
+    }
+    p = (picoos_uint8 *)&(((kpr_SubObj)preproc)->rTokArr[ofs]);
 
     return p[KPR_TOK_ATTRIBOFS_OFS+0] + 256*p[KPR_TOK_ATTRIBOFS_OFS+1];
 }
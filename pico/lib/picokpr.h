@@ -96,6 +96,8 @@ picokpr_Preproc picokpr_getPreproc(picoknow_KnowledgeBase this);
 
 /* knowledge base access routines for strings in StrArr */
 extern picokpr_VarStrPtr picokpr_getVarStrPtr(picokpr_Preproc preproc, picokpr_StrArrOffset ofs);
+/* lowercase form of the string at 'ofs' (built at load time), NULL if not available */
+extern picokpr_VarStrPtr picokpr_getVarStrLcPtr(picokpr_Preproc preproc, picokpr_StrArrOffset ofs);
 extern picoos_bool picokpr_isEqual (picokpr_Preproc preproc, picoos_uchar str[], picoos_int32 len__9, picokpr_StrArrOffset str2);
 extern picoos_bool picokpr_isEqualHead (picokpr_Preproc preproc, picoos_uchar str[], picoos_int32 len__10, picokpr_StrArrOffset head);
 extern picoos_bool picokpr_isEqualMid (picokpr_Preproc preproc, picoos_uchar str[], picoos_int32 len__11, picokpr_StrArrOffset mid);
@@ -172,6 +172,7 @@ void picoktab_disposeFixedIds(picoos_MemoryManager mm, picoktab_FixedIds * this)
 */
 
 static picoos_uint32 ktab_propOffset (const picoktab_Graphs this, picoos_uint32 graphsOffset, picoos_uint32 prop);
+static void ktab_getStrProp (const picoktab_Graphs this, picoos_uint32 graphsOffset, picoos_uint32 propOffset, picoos_uchar * str);
 
 #define KTAB_START_GRAPHS_NR_OFFSET     0
 #define KTAB_START_GRAPHS_SIZE_OFFSET   2
@@ -188,6 +189,9 @@ static picoos_uint32 ktab_propOffset (const picoktab_Graphs this, picoos_uint32
 #define KTAB_GRAPH_PROPSET_GRAPHSUBS2    ((picoos_uint8)'\x040')
 #define KTAB_GRAPH_PROPSET_PUNCT         ((picoos_uint8)'\x080')
 
+/* the direct graph index covers at most the basic multilingual plane */
+#define KTAB_GRAPH_INDEX_MAX_LEN         0x10000
+
 
 typedef struct ktabgraphs_subobj *ktabgraphs_SubObj;
 
@@ -197,9 +201,163 @@ typedef struct ktabgraphs_subobj {
 
     picoos_uint8 * offsetTable;
     picoos_uint8 * graphTable;
+
+    /* load-time index: graphIndex[c] is the graph offset of code point c
+       (0 if not in the table) for c < graphIndexLen; NULL if not available */
+    picoos_uint16 * graphIndex;
+    picoos_uint32 graphIndexLen;
+    picoos_uint32 graphMaxCode;   /* highest code point covered by the table */
+    picoos_bool graphIndexInImage; /* graphIndex is a section of the in-place image */
 } ktabgraphs_subobj_t;
 
 
+/* Returns the offset in the graphs table of graph number 'nr' */
+static picoos_uint32 ktab_graphEntryOffset (const ktabgraphs_subobj_t * g, picoos_int32 nr)
+{
+    if (g->sizeOffset == 1) {
+        return g->offsetTable[nr];
+    } else {
+        return g->offsetTable[g->sizeOffset*nr] + 256*g->offsetTable[g->sizeOffset*nr + 1];
+    }
+}
+
+
+/* Decodes 'utf8' into code point 'code' if it consists of exactly one
+   character in shortest form. Returns FALSE otherwise */
+static picoos_bool ktab_utf8CodePoint (const picoos_uchar * utf8, picoos_uint32 * code)
+{
+    picoos_uint32 i, len;
+
+    len = picobase_det_utf8_length(utf8[0]);
+    if ((len == 0) || (utf8[0] == 0)) {
+        return FALSE;
+    }
+    if (len == 1) {
+        *code = utf8[0];
+    } else {
+        *code = utf8[0] & (0x7F >> len);
+        for (i = 1; i < len; i++) {
+            if ((utf8[i] & 0xC0) != 0x80) {
+                return FALSE;
+            }
+            *code = ((*code) << 6) | (utf8[i] & 0x3F);
+        }
+        if (((len == 2) && (*code < 0x80)) || ((len == 3) && (*code < 0x800)) || ((len == 4) && (*code < 0x10000))) {
+            return FALSE;
+        }
+    }
+    return (utf8[len] == 0);
+}
+
+
+/* Builds the direct graph index. It is only built if all FROM/TO fields are
+   single characters and the graph ranges are sorted and disjoint, i.e. if
+   the binary search in picoktab_graphOffset finds the same graph for every
+   character; otherwise graphIndex stays NULL and the binary search is used */
+static void ktab_buildGraphIndex (ktabgraphs_subobj_t * g, picoos_MemoryManager mm)
+{
+    picoos_int32 m;
+    picoos_uint32 graphsOffset, propOffset, fromCode, toCode, prevToCode, c;
+    picobase_utf8char from;
+    picobase_utf8char to;
+
+    g->graphIndex = NULL;
+    g->graphIndexLen = 0;
+    g->graphMaxCode = 0;
+    if (g->nrOffset == 0) {
+        return;
+    }
+
+    /* check the ranges */
+    prevToCode = 0;
+    for (m = 0; m < g->nrOffset; m++) {
+        graphsOffset = ktab_graphEntryOffset(g, m);
+        ktab_getStrProp((picoktab_Graphs) g, graphsOffset, 1, from);
+        propOffset = ktab_propOffset((picoktab_Graphs) g, graphsOffset, KTAB_GRAPH_PROPSET_TO);
+        if (propOffset > 0) {
+            ktab_getStrProp((picoktab_Graphs) g, graphsOffset, propOffset, to);
+        } else {
+            picoos_strcpy((picoos_char *)to, (picoos_char *)from);
+        }
+        if (!ktab_utf8CodePoint(from, &fromCode) || !ktab_utf8CodePoint(to, &toCode)
+            || (fromCode > toCode) || ((m > 0) && (fromCode <= prevToCode))
+            || (graphsOffset > 0xFFFF)) {
+            PICODBG_WARN(("graph table not sorted; no direct graph index"));
+            return;
+        }
+        prevToCode = toCode;
+    }
+    g->graphMaxCode = prevToCode;
+
+    g->graphIndexLen = g->graphMaxCode + 1;
+    if (g->graphIndexLen > KTAB_GRAPH_INDEX_MAX_LEN) {
+        g->graphIndexLen = KTAB_GRAPH_INDEX_MAX_LEN;
+    }
+    g->graphIndex = picoos_allocate(mm, g->graphIndexLen * sizeof(picoos_uint16));
+    if (NULL == g->graphIndex) {
+        PICODBG_WARN(("no memory for direct graph index"));
+        g->graphIndexLen = 0;
+        return;
+    }
+    picoos_mem_set(g->graphIndex, 0, g->graphIndexLen * sizeof(picoos_uint16));
+
+    /* fill in the ranges */
+    for (m = 0; m < g->nrOffset; m++) {
+        graphsOffset = ktab_graphEntryOffset(g, m);
+        ktab_getStrProp((picoktab_Graphs) g, graphsOffset, 1, from);
+        propOffset = ktab_propOffset((picoktab_Graphs) g, graphsOffset, KTAB_GRAPH_PROPSET_TO);
+        if (propOffset > 0) {
+            ktab_getStrProp((picoktab_Graphs) g, graphsOffset, propOffset, to);
+        } else {
+            picoos_strcpy((picoos_char *)to, (picoos_char *)from);
+        }
+        ktab_utf8CodePoint(from, &fromCode);
+        ktab_utf8CodePoint(to, &toCode);
+        for (c = fromCode; (c <= toCode) && (c < g->graphIndexLen); c++) {
+            g->graphIndex[c] = (picoos_uint16) graphsOffset;
+        }
+    }
+}
+
+
+
+/* takes the direct graph index from the in-place image; the highest code
+   point of the table is not stored there, it is known only if the index
+   does not cover the whole basic multilingual plane */
+static picoos_bool ktab_adoptGraphIndex (picoknow_KnowledgeBase this, ktabgraphs_subobj_t * g)
+{
+    picoos_uint8 * index;
+    picoos_uint32 size;
+
+    index = picoknow_getSection(this, PICOKNOW_SECTION_TAB_GRAPHIDX, &size);
+    if ((NULL == index) || (size == 0) || (size % sizeof(picoos_uint16) != 0)
+        || (size > KTAB_GRAPH_INDEX_MAX_LEN * sizeof(picoos_uint16))) {
+        return FALSE;
+    }
+    g->graphIndex = (picoos_uint16 *) index;
+    g->graphIndexLen = size / sizeof(picoos_uint16);
+    if (g->graphIndexLen < KTAB_GRAPH_INDEX_MAX_LEN) {
+        g->graphMaxCode = g->graphIndexLen - 1;
+    } else {
+        g->graphMaxCode = 0xFFFFFFFF;
+    }
+    return TRUE;
+}
+
+
+static picoos_uint8 * ktabGraphsSubGetSection(register picoknow_KnowledgeBase this,
+                                              picoos_uint32 type, picoos_uint32 * size)
+{
+    ktabgraphs_subobj_t * ktabgraphs = (ktabgraphs_subobj_t *) this->subObj;
+
+    if ((PICOKNOW_SECTION_TAB_GRAPHIDX == type) && (NULL != ktabgraphs->graphIndex)) {
+        *size = ktabgraphs->graphIndexLen * sizeof(picoos_uint16);
+        return (picoos_uint8 *) ktabgraphs->graphIndex;
+    }
+    *size = 0;
+    return NULL;
+}
+
 
 static pico_status_t ktabGraphsInitialize(register picoknow_KnowledgeBase this,
                                           picoos_Common common) {
@@ -216,12 +374,23 @@ static pico_status_t ktabGraphsInitialize(register picoknow_KnowledgeBase this,
     ktabgraphs->sizeOffset  = (int)(this->base[KTAB_START_GRAPHS_SIZE_OFFSET]);
     ktabgraphs->offsetTable = &(this->base[KTAB_START_GRAPHS_OFFSET_TABLE]);
     ktabgraphs->graphTable  = &(this->base[KTAB_START_GRAPHS_GRAPH_TABLE]);
+    ktabgraphs->graphIndexInImage = ktab_adoptGraphIndex(this, ktabgraphs);
+    if (!ktabgraphs->graphIndexInImage) {
+        ktab_buildGraphIndex(ktabgraphs, common->mm);
+    }
     return PICO_OK;
 }
 
 static pico_status_t ktabGraphsSubObjDeallocate(register picoknow_KnowledgeBase this,
                                                 picoos_MemoryManager mm) {
+    ktabgraphs_subobj_t * ktabgraphs;
+
     if (NULL != this) {
+        ktabgraphs = (ktabgraphs_subobj_t *) this->subObj;
+        if ((NULL != ktabgraphs) && (NULL != ktabgraphs->graphIndex)
+            && !ktabgraphs->graphIndexInImage) {
+            picoos_deallocate(mm, (void *) &ktabgraphs->graphIndex);
+        }
         picoos_deallocate(mm, (void *) &this->subObj);
     }
     return PICO_OK;
@@ -235,6 +404,7 @@ pico_status_t picoktab_specializeGraphsKnowledgeBase(picoknow_KnowledgeBase this
                                        NULL, NULL);
     }
     this->subDeallocate = ktabGraphsSubObjDeallocate;
+    this->subGetSection = ktabGraphsSubGetSection;
     this->subObj = picoos_allocate(common->mm, sizeof(ktabgraphs_subobj_t));
     if (NULL == this->subObj) {
         return picoos_emRaiseException(common->em, PICO_EXC_OUT_OF_MEM,
@@ -375,6 +545,15 @@ picoos_uint32 picoktab_graphOffset (const picoktab_Graphs this, picoos_uchar * u
    picobase_utf8char to;
    picoos_bool utfGEfrom;
    picoos_bool utfLEto;
+   picoos_uint32 code;
+
+   if ((NULL != g->graphIndex) && ktab_utf8CodePoint(utf8graph, &code)) {
+     if (code < g->graphIndexLen) {
+       return g->graphIndex[code];
+     } else if (code > g->graphMaxCode) {
+       return 0;
+     }
+   }
 
    if (g->nrOffset > 0) {
      a = 0;
@@ -383,15 +562,7 @@ picoos_uint32 picoktab_graphOffset (const picoktab_Graphs this, picoos_uchar * u
        m = (a+b) / 2;
 
        /* get offset to graph[m] */
-       if (g->sizeOffset == 1) {
-         graphsOffset = g->offsetTable[g->sizeOffset*m];
-       }
-       else {
-         graphsOffset =     g->offsetTable[g->sizeOffset*m    ] +
-                        256*g->offsetTable[g->sizeOffset*m + 1];
-         /* PICODBG_DEBUG(("picoktab_graphOffset: %i %i %i %i", m, g->offsetTable[g->sizeOffset*m], g->offsetTable[g->sizeOffset*m + 1], graphsOffset));
-         */
-       }
+       graphsOffset = ktab_graphEntryOffset(g, m);
 
        /* get FROM and TO field of graph[m] */
        ktab_getStrProp(this, graphsOffset, 1, from);
@@ -220,6 +220,7 @@ picoos_Common picoos_newCommon(picoos_MemoryManager mm)
         this->em = NULL;
         this->mm = NULL;
         this->fileList = NULL;
+        picopal_atomic_set(&this->cancel, 0);
     }
     return this;
 }
@@ -1327,6 +1328,31 @@ picoos_bool picoos_FileLength(picoos_File f, picoos_uint32 * len)
     }
 }
 
+/* Maps the whole file 'f' read-only into memory */
+picoos_bool picoos_MapBinary(picoos_File f, picoos_uint8 ** addr, picoos_uint32 * len)
+{
+    *addr = NULL;
+    *len = 0;
+    if ((NULL == f) || f->write) {
+        return FALSE;
+    }
+    *addr = (picoos_uint8 *) picopal_fmap(f->nf, f->lFileLen);
+    if (NULL == *addr) {
+        return FALSE;
+    }
+    *len = f->lFileLen;
+    return TRUE;
+}
+
+/* Releases a mapping created by picoos_MapBinary */
+void picoos_UnmapBinary(picoos_uint8 ** addr, picoos_uint32 len)
+{
+    if (NULL != *addr) {
+        picopal_funmap(*addr, len);
+        *addr = NULL;
+    }
+}
+
 /* Return full name of file 'f'. maxsize is the size of 'name[]' in bytes */
 picoos_bool picoos_Name(picoos_File f, picoos_char name[], picoos_uint32 maxsize)
 {
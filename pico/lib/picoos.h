@@ -69,6 +69,7 @@ typedef picopal_uint8   picoos_bool;
 
 typedef picopal_objsize_t picoos_objsize_t;
 typedef picopal_ptrdiff_t picoos_ptrdiff_t;
+typedef picopal_atomic_t picoos_atomic_t;
 
 /* *************************************************/
 /* functions                                       */
@@ -125,6 +126,9 @@ typedef struct picoos_common {
     picoos_ExceptionManager em;
     picoos_MemoryManager mm;
     picoos_File fileList;
+    /* cancellation token of an engine; may be set asynchronously (e.g. from
+       another thread), so it is only accessed with picopal_atomic_get/_set */
+    picoos_atomic_t cancel;
 } picoos_common_t;
 
 picoos_Common picoos_newCommon(picoos_MemoryManager mm);
@@ -343,6 +347,14 @@ picoos_bool picoos_FileLength(picoos_File f, picoos_uint32 * len);
 /* Return full name of file 'f'. */
 picoos_bool picoos_Name(picoos_File f, picoos_char name[], picoos_uint32 maxsize);
 
+/* Maps the whole file 'f' read-only into memory; 'addr' and 'len' return
+ the start address (page aligned) and the length of the mapping. Returns
+ FALSE if the file cannot be mapped on this platform; it has to be read then. */
+picoos_bool picoos_MapBinary(picoos_File f, picoos_uint8 ** addr, picoos_uint32 * len);
+
+/* Releases a mapping created by picoos_MapBinary and sets 'addr' to NULL. */
+void picoos_UnmapBinary(picoos_uint8 ** addr, picoos_uint32 len);
+
 /* Returns whether file 'name' exists or not. */
 picoos_bool picoos_FileExists(picoos_Common g, picoos_char name[] /*, picoos_char ckey[] */);
 
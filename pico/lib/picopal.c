@@ -90,6 +90,9 @@ extern "C" {
 #if PICO_PLATFORM == PICO_Windows
 #include <windows.h>
 #endif
+#if (PICO_PLATFORM == PICO_Linux) || (PICO_PLATFORM == PICO_MacOSX)
+#include <sys/mman.h>
+#endif
 
 #if defined(PRAGMA_MESSAGE)
 #pragma message("PICO_PLATFORM       : " PICO_PLATFORM_STRING)
@@ -400,6 +403,37 @@ picopal_objsize_t picopal_fread_bytes (picopal_File f, void * ptr, picopal_objsi
 }
 
 picopal_objsize_t picopal_fwrite_bytes (picopal_File f, void * ptr, picopal_objsize_t objsize, picopal_uint32 nobj){    return (picopal_objsize_t) fwrite(ptr, objsize, nobj, (FILE *)f);}
+
+void * picopal_fmap (picopal_File f, picopal_uint32 len)
+{
+#if (PICO_PLATFORM == PICO_Linux) || (PICO_PLATFORM == PICO_MacOSX)
+    void * addr;
+
+    if ((NULL == f) || (0 == len)) {
+        return NULL;
+    }
+    addr = mmap(NULL, len, PROT_READ, MAP_PRIVATE, fileno((FILE *)f), 0);
+    return (MAP_FAILED == addr) ? NULL : addr;
+#else
+    /* not yet implemented for other platforms */
+    f = f;              /* avoid warning "var not used in this function"*/
+    len = len;          /* avoid warning "var not used in this function"*/
+    return NULL;
+#endif
+}
+
+void picopal_funmap (void * addr, picopal_uint32 len)
+{
+#if (PICO_PLATFORM == PICO_Linux) || (PICO_PLATFORM == PICO_MacOSX)
+    if (NULL != addr) {
+        munmap(addr, len);
+    }
+#else
+    /* not yet implemented for other platforms */
+    addr = addr;        /* avoid warning "var not used in this function"*/
+    len = len;          /* avoid warning "var not used in this function"*/
+#endif
+}
 /* *************************************************/
 /* functions for debugging/testing purposes only   */
 /* *************************************************/
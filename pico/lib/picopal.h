@@ -42,6 +42,14 @@
 #include "picopltf.h"
 #include "picodefs.h"
 
+#if defined(__STDC_VERSION__) && (__STDC_VERSION__ >= 201112L) \
+        && !defined(__STDC_NO_ATOMICS__)
+#define PICOPAL_C11_ATOMICS 1
+#include <stdatomic.h>
+#else
+#include <signal.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
@@ -118,6 +126,18 @@ typedef unsigned char   picopal_uchar;
 typedef size_t    picopal_objsize_t;
 typedef ptrdiff_t picopal_ptrdiff_t;
 
+/* flag that may be set from another thread or a signal handler (e.g. a
+   cancellation token); only accessed with picopal_atomic_get/_set */
+#if defined(PICOPAL_C11_ATOMICS)
+typedef atomic_int picopal_atomic_t;
+#define picopal_atomic_get(a)    atomic_load(a)
+#define picopal_atomic_set(a, v) atomic_store((a), (v))
+#else
+typedef volatile sig_atomic_t picopal_atomic_t;
+#define picopal_atomic_get(a)    (*(a))
+#define picopal_atomic_set(a, v) (*(a) = (v))
+#endif
+
 /* *************************************************/
 /* functions                                       */
 /* *************************************************/
@@ -234,6 +254,17 @@ extern pico_status_t picopal_fput_char (picopal_File f, picopal_char ch);
 */
 
 
+extern void * picopal_fmap (picopal_File f, picopal_uint32 len);
+/* 'FMap' maps the first 'len' bytes of the file 'f' read-only into memory
+   and gives back the (page aligned) start address. If the platform offers
+   no file mapping or the mapping fails, NULL is given back and the file
+   has to be read instead. The mapping stays valid after closing 'f'. */
+
+
+extern void picopal_funmap (void * addr, picopal_uint32 len);
+/* 'FUnmap' releases a mapping given back by 'FMap'. */
+
+
 /*
 extern pico_status_t picopal_remove (picopal_char filename[]);
 
@@ -68,10 +68,48 @@ extern "C" {
 #define PICOPAM_BREAK_ADD_SIZE 4        /*syllable feature vector increment dued to BREAK and SILENCE*/
 #define PICOPAM_VECT_SIZE 64+PICOPAM_BREAK_ADD_SIZE /*syllable feature vector size (bytes)*/
 #define PICOPAM_INVEC_SIZE 60           /*phone feature vector size */
-#define PICOPAM_MAX_SYLL_PER_SENT 100   /*maximum number of syllables per sentece*/
-#define PICOPAM_MAX_PH_PER_SENT 400     /*maximum number of phonemes  per sentece*/
+#define PICOPAM_SYLL_PER_SENT 100       /*initial number of syllables per sentence*/
+#define PICOPAM_PH_PER_SENT 400         /*initial number of phonemes per sentence*/
 #define PICOPAM_MAX_ITEM_PER_SENT 255   /*maximum number of attached items per sentence*/
-#define PICOPAM_MAX_ITEM_SIZE_PER_SENT 4096 /*maximum size of attached items per sentence*/
+#define PICOPAM_ITEM_SIZE_PER_SENT 4096 /*initial size of attached items per sentence*/
+
+/* the sentence buffers are enlarged on demand up to the following limits;
+   only a sentence exceeding them is split before backward processing.
+   Syllable counts are kept in 8 bit features, so a sentence can never hold
+   more than 255 syllables */
+#if !defined(PICOPAM_MAX_SYLL_PER_SENT)
+#define PICOPAM_MAX_SYLL_PER_SENT 250
+#endif
+#if !defined(PICOPAM_MAX_PH_PER_SENT)
+#define PICOPAM_MAX_PH_PER_SENT 1000
+#endif
+#if !defined(PICOPAM_MAX_ITEM_SIZE_PER_SENT)
+#define PICOPAM_MAX_ITEM_SIZE_PER_SENT 16384
+#endif
+
+#if (PICOPAM_MAX_SYLL_PER_SENT < PICOPAM_SYLL_PER_SENT) || (PICOPAM_MAX_SYLL_PER_SENT > 255) || \
+    (PICOPAM_MAX_PH_PER_SENT < PICOPAM_PH_PER_SENT) || (PICOPAM_MAX_PH_PER_SENT > 32767) || \
+    (PICOPAM_MAX_ITEM_SIZE_PER_SENT < PICOPAM_ITEM_SIZE_PER_SENT) || (PICOPAM_MAX_ITEM_SIZE_PER_SENT > 32767)
+#error "PICOPAM_MAX_SYLL_PER_SENT / PICOPAM_MAX_PH_PER_SENT / PICOPAM_MAX_ITEM_SIZE_PER_SENT out of range"
+#endif
+
+/* decision tree result cache: results of the duration, pitch and cepstral
+   trees are kept per (tree, phone feature vector) in a direct mapped table
+   of a power of two number of entries; 0 disables the cache */
+#if !defined(PICOPAM_DTCACHE_SIZE)
+#define PICOPAM_DTCACHE_SIZE 0
+#endif
+#define PICOPAM_DTCACHE_MAX_SIZE 32768  /*maximum number of cache entries*/
+#define PICOPAM_DTCACHE_EMPTY 0xFF      /*tree id of an unused cache entry*/
+
+#if (PICOPAM_DTCACHE_SIZE > PICOPAM_DTCACHE_MAX_SIZE)
+#error "PICOPAM_DTCACHE_SIZE out of range"
+#endif
+
+/*tree ids used as part of the cache key*/
+#define PICOPAM_DTID_DUR 0
+#define PICOPAM_DTID_LFZ 1
+#define PICOPAM_DTID_MGC (PICOPAM_DTID_LFZ + PICOPAM_DT_NRLFZ)
 
 #define PICOPAM_READY 20 /*PAM could start backward processing*/
 #define PICOPAM_MORE  21 /*PAM has still to collect */
@@ -138,6 +176,18 @@ typedef struct
     picopal_uint8 phoneV[PICOPAM_VECT_SIZE];
 } sFtVect, *pSftVect;
 
+/*----------------------------------------------------------
+ decision tree result cache entry: the phone feature vector
+ fed to tree 'treeId' and the resulting class (64 bytes)
+ ---------------------------------------------------------*/
+typedef struct
+{
+    picoos_uint8 invec[PICOPAM_INVEC_SIZE];
+    picoos_uint8 treeId;
+    picoos_uint8 pad;
+    picoos_uint16 class;
+} pam_dtcache_entry_t;
+
 /*----------------------------------------------------------
  Name    :   pam_subobj
  Function:   subobject definition for the pam processing
@@ -166,12 +216,16 @@ typedef struct pam_subobj
     picoos_uint8 *sPhIds; /*phone ids for the full sentence        */
     picoos_uint8 *sSyllItems; /*items attached to the syllable         */
     picoos_int16 *sSyllItemOffs;/*offset of items attached to the syllable*/
+    picoos_int16 nSyllFeatsSize; /*allocated number of syllable vectors*/
+    picoos_int16 nPhIdsSize; /*allocated number of phone ids*/
+    picoos_int16 nSyllItemsSize; /*allocated size of the attached items area*/
     /*---------------------- adapter general variables ---------------------*/
     picoos_int16 nTotalPhonemes; /*number of phonemes in the sentence*/
     picoos_int16 nCurrPhoneme; /*current phoneme in the sentence   */
     picoos_int16 nSyllPhoneme; /*current phoneme in the syllable   */
     picoos_int16 nCurrSyllable; /*current syllable in the sentence  */
     picoos_int16 nTotalSyllables; /*number of syllables in the sentence -> J1*/
+    picoos_int16 nSyllFeatsUsed; /*syllable vectors written since the last reset*/
     picoos_uint8 nLastAttachedItemId;/*last attached item id*/
     picoos_uint8 nCurrAttachedItem; /*current attached item*/
     picoos_int16 nAttachedItemsSize; /*total size of the attached items*/
@@ -261,6 +315,12 @@ typedef struct pam_subobj
     picoos_single phonF0[PICOPAM_DT_NRLFZ];
     /*---------------------- Phones related data  -------------------*/
     picoktab_Phones tabphones;
+    /*---------------------- decision tree result cache -------------------*/
+    pam_dtcache_entry_t *dtCache;
+    picoos_uint32 dtCacheSize; /* number of entries, a power of two or 0 */
+    picoos_uint32 dtCacheUsed;
+    picoos_uint32 dtCacheHits;
+    picoos_uint32 dtCacheMisses;
 } pam_subobj_t;
 
 
@@ -432,6 +492,13 @@ static pico_status_t pam_expand_vector(register picodata_ProcessingUnit this);
 static picoos_uint8 pam_do_tree(register picodata_ProcessingUnit this,
         const picokdt_DtPAM dtpam, const picoos_uint8 *invec,
         const picoos_uint8 inveclen, picokdt_classify_result_t *dtres);
+static picoos_uint8 pam_do_cached_tree(register picodata_ProcessingUnit this,
+        picoos_uint8 treeId, const picokdt_DtPAM dtpam,
+        const picoos_uint8 *invec, const picoos_uint8 inveclen,
+        picokdt_classify_result_t *dtres);
+static pico_status_t pam_dtcache_resize(picoos_MemoryManager mm,
+        pam_subobj_t *pam, picoos_uint32 nEntries);
+static void pam_dtcache_clear(pam_subobj_t *pam);
 static pico_status_t pam_get_f0(register picodata_ProcessingUnit this,
         picoos_uint16 *lf0Index, picoos_uint8 nState, picoos_single *phonF0);
 static pico_status_t pam_get_duration(register picodata_ProcessingUnit this,
@@ -480,14 +547,18 @@ static pico_status_t pam_allocate(picoos_MemoryManager mm, pam_subobj_t *pam)
      * PAM Local buffers ALLOCATION
      ------------------------------------------------------------------*/
     /*PAM Local buffers*/
+    pam->nSyllFeatsSize = PICOPAM_SYLL_PER_SENT;
+    pam->nPhIdsSize = PICOPAM_PH_PER_SENT;
+    pam->nSyllItemsSize = PICOPAM_ITEM_SIZE_PER_SENT;
+
     data = (picopal_uint8 *) picoos_allocate(mm, sizeof(sFtVect)
-            * PICOPAM_MAX_SYLL_PER_SENT);
+            * pam->nSyllFeatsSize);
     if (data == NULL)
         return PICO_ERR_OTHER;
     pam->sSyllFeats = (sFtVect*) data;
 
     data = (picopal_uint8 *) picoos_allocate(mm, sizeof(picopal_uint8)
-            * PICOPAM_MAX_PH_PER_SENT);
+            * pam->nPhIdsSize);
     if (data == NULL) {
         pam_deallocate(mm, pam);
         return PICO_ERR_OTHER;
@@ -503,7 +574,7 @@ static pico_status_t pam_allocate(picoos_MemoryManager mm, pam_subobj_t *pam)
     pam->sPhFeats = (picopal_uint8*) data;
 
     data = (picopal_uint8 *) picoos_allocate(mm, sizeof(picopal_uint8)
-            * PICOPAM_MAX_ITEM_SIZE_PER_SENT);
+            * pam->nSyllItemsSize);
     if (data == NULL) {
         pam_deallocate(mm, pam);
         return PICO_ERR_OTHER;
@@ -512,12 +583,19 @@ static pico_status_t pam_allocate(picoos_MemoryManager mm, pam_subobj_t *pam)
 
     dataI = (picoos_int16 *) picoos_allocate(mm, sizeof(picoos_int16)
             * PICOPAM_MAX_ITEM_PER_SENT);
-    if (data == NULL) {
+    if (dataI == NULL) {
         pam_deallocate(mm, pam);
         return PICO_ERR_OTHER;
     }
     pam->sSyllItemOffs = (picoos_int16*) dataI;
 
+    /*the decision tree cache is optional: without memory PAM runs uncached*/
+    pam->dtCache = NULL;
+    pam->dtCacheSize = 0;
+    if (PICOPAM_DTCACHE_SIZE > 0) {
+        pam_dtcache_resize(mm, pam, PICOPAM_DTCACHE_SIZE);
+    }
+
     return PICO_OK;
 }/*pam_allocate*/
 
@@ -545,6 +623,8 @@ static void pam_deallocate(picoos_MemoryManager mm, pam_subobj_t *pam)
         picoos_deallocate(mm, (void *) &pam->sSyllItems);
     if (pam->sSyllItemOffs != NULL)
         picoos_deallocate(mm, (void *) &pam->sSyllItemOffs);
+    if (pam->dtCache != NULL)
+        picoos_deallocate(mm, (void *) &pam->dtCache);
 
 }/*pam_deallocate*/
 
@@ -558,7 +638,7 @@ static void pam_deallocate(picoos_MemoryManager mm, pam_subobj_t *pam)
  */
 static pico_status_t pam_initialize(register picodata_ProcessingUnit this, picoos_int32 resetMode)
 {
-    pico_status_t nI, nJ;
+    pico_status_t nI, nJ, nSyll;
     pam_subobj_t *pam;
 
     if (NULL == this || NULL == this->subObj) {
@@ -577,33 +657,52 @@ static pico_status_t pam_initialize(register picodata_ProcessingUnit this, picoo
     /*-----------------------------------------------------------------
      * MANAGE INTERNAL INITIALIZATION
      ------------------------------------------------------------------*/
-    /*init the syllable structure*/
-    for (nI = 0; nI < PICOPAM_MAX_SYLL_PER_SENT; nI++)
+    /*init the syllable structure; syllable vectors are not cleared between
+      sentences, so their content must be cleared between utterances, but
+      only the ones written since the last reset*/
+    nSyll = pam->nSyllFeatsSize;
+    if (resetMode == PICO_RESET_UTTERANCE) {
+        nSyll = pam->nSyllFeatsUsed;
+        if (nSyll < pam->nTotalSyllables + 1)
+            nSyll = pam->nTotalSyllables + 1;
+        if (nSyll < pam->nCurrSyllable + 1)
+            nSyll = pam->nCurrSyllable + 1;
+        if (nSyll > pam->nSyllFeatsSize)
+            nSyll = pam->nSyllFeatsSize;
+    }
+    for (nI = 0; nI < nSyll; nI++)
         for (nJ = 0; nJ < PICOPAM_VECT_SIZE; nJ++)
             pam->sSyllFeats[nI].phoneV[nJ] = 0;
 
-    for (nI = 0; nI < PICOPAM_MAX_PH_PER_SENT; nI++)
-        pam->sPhIds[nI] = 0;
-
     for (nI = 0; nI < PICOPAM_VECT_SIZE; nI++)
         pam->sPhFeats[nI] = 0;
 
-    for (nI = 0; nI < PICOPAM_MAX_ITEM_SIZE_PER_SENT; nI++)
-        pam->sSyllItems[nI] = 0;
+    /*the per sentence phone and item buffers are written before being read*/
+    if (resetMode != PICO_RESET_UTTERANCE) {
+        for (nI = 0; nI < pam->nPhIdsSize; nI++)
+            pam->sPhIds[nI] = 0;
 
-    for (nI = 0; nI < PICOPAM_MAX_ITEM_PER_SENT; nI++)
-        pam->sSyllItemOffs[nI] = 0;
+        for (nI = 0; nI < pam->nSyllItemsSize; nI++)
+            pam->sSyllItems[nI] = 0;
+
+        for (nI = 0; nI < PICOPAM_MAX_ITEM_PER_SENT; nI++)
+            pam->sSyllItemOffs[nI] = 0;
+    }
 
     /*Other variables*/
     pam_reset_processors(this);
+    pam->nSyllFeatsUsed = 0;
     pam->nLastAttachedItemId = pam->nCurrAttachedItem = 0;
     pam->nAttachedItemsSize = 0;
 
-    if (resetMode == PICO_RESET_SOFT) {
+    if (resetMode != PICO_RESET_FULL) {
         /*following initializations needed only at startup or after a full reset*/
         return PICO_OK;
     }
 
+    /*cached tree results are only valid for the trees they came from*/
+    pam_dtcache_clear(pam);
+
     /*pitch and duration modifiers*/
     pam->pMod = 1.0f;
     pam->dMod = 1.0f;
@@ -620,6 +719,9 @@ static pico_status_t pam_initialize(register picodata_ProcessingUnit this, picoo
         { 1, 10, 10, 10, 10 },/*SEND*/
         { 1, 1, 1, 1, 1 } /*DEFAULT*/
         };
+        /*only the diagonal is set below; the rest must not depend on
+          whatever the engine memory held before*/
+        picoos_mem_set(pam->sil_weights, 0, sizeof(pam->sil_weights));
         for (i = 0; i < PICOPAM_PWIDX_SIZE; i++) {
             for (j = 0; j < PICOPAM_PWIDX_SIZE; j++) {
                 pam->sil_weights[j][j] = tmp_weights[i][j];
@@ -762,6 +864,9 @@ static pico_status_t pam_subobj_deallocate(register picodata_ProcessingUnit this
         if (pam->sSyllItemOffs != NULL) {
             picoos_deallocate(this->common->mm, (void *) &pam->sSyllItemOffs);
         }
+        if (pam->dtCache != NULL) {
+            picoos_deallocate(this->common->mm, (void *) &pam->dtCache);
+        }
         picoos_deallocate(this->common->mm, (void *) &this->subObj);
     }
 
@@ -826,6 +931,61 @@ picodata_ProcessingUnit picopam_newPamUnit(picoos_MemoryManager mm,
     return this;
 }/*picopam_newPamUnit*/
 
+/**
+ * sets the number of entries of the decision tree cache of a pam PU
+ * @param    this : handle to a pam PU struct
+ * @param    nEntries : number of entries, rounded down to a power of two,
+ *           up to PICOPAM_DTCACHE_MAX_SIZE; 0 disables the cache
+ * @return   PICO_OK : cache resized
+ * @return   PICO_ERR_INVALID_ARGUMENT : nEntries out of range
+ * @return   PICO_EXC_OUT_OF_MEM : not enough engine memory, the cache is disabled
+ * @return   PICO_ERR_OTHER : invalid PU
+ * @remarks  the cache content and statistics are cleared
+ * @callgraph
+ * @callergraph
+ */
+pico_status_t picopam_setTreeCacheSize(picodata_ProcessingUnit this,
+        picoos_uint32 nEntries)
+{
+    if (NULL == this || NULL == this->subObj) {
+        return PICO_ERR_OTHER;
+    }
+    if (nEntries > PICOPAM_DTCACHE_MAX_SIZE) {
+        return PICO_ERR_INVALID_ARGUMENT;
+    }
+    return pam_dtcache_resize(this->common->mm, (pam_subobj_t *) this->subObj,
+            nEntries);
+}/*picopam_setTreeCacheSize*/
+
+/**
+ * returns the statistics of the decision tree cache of a pam PU
+ * @param    this : handle to a pam PU struct
+ * @param    size : number of cache entries (output)
+ * @param    used : number of entries holding a result (output)
+ * @param    hits, misses : number of tree lookups answered from the cache
+ *           and by tree traversal since the cache was last cleared (output)
+ * @return   PICO_OK : statistics returned
+ * @return   PICO_ERR_OTHER : invalid PU
+ * @callgraph
+ * @callergraph
+ */
+pico_status_t picopam_getTreeCacheStats(picodata_ProcessingUnit this,
+        picoos_uint32 * size, picoos_uint32 * used,
+        picoos_uint32 * hits, picoos_uint32 * misses)
+{
+    pam_subobj_t *pam;
+
+    if (NULL == this || NULL == this->subObj) {
+        return PICO_ERR_OTHER;
+    }
+    pam = (pam_subobj_t *) this->subObj;
+    *size = pam->dtCacheSize;
+    *used = pam->dtCacheUsed;
+    *hits = pam->dtCacheHits;
+    *misses = pam->dtCacheMisses;
+    return PICO_OK;
+}/*picopam_getTreeCacheStats*/
+
 /*-------------------------------------------------------------------------------
  PROCESSING AND INTERNAL FUNCTIONS
  --------------------------------------------------------------------------------*/
@@ -877,6 +1037,82 @@ static void get_default_boundary_limit(picoos_uint8 uBoundType,
 
 }/*get_default_boundary_limit*/
 
+/**
+ * makes sure a sentence buffer holds at least "needed" elements
+ * @param    this : pointer to current PU struct
+ * @param    buf : address of the buffer pointer
+ * @param    size : address of the allocated number of elements
+ * @param    elemSize : size of one element (bytes)
+ * @param    needed : requested number of elements
+ * @param    maxSize : maximum number of elements
+ * @return    TRUE : the buffer holds "needed" elements
+ * @return    FALSE : "maxSize" reached or no engine memory left
+ * @remarks the buffer is doubled (at most up to "maxSize"); the new elements
+ * @remarks are cleared, the old ones are kept
+ * @callgraph
+ * @callergraph
+ */
+static picoos_bool pam_grow_buffer(register picodata_ProcessingUnit this,
+        void **buf, picoos_int16 *size, picoos_objsize_t elemSize,
+        picoos_int32 needed, picoos_int32 maxSize)
+{
+    picoos_int32 newSize;
+    picoos_uint8 *data;
+
+    if (needed <= *size) {
+        return TRUE;
+    }
+    if (needed > maxSize) {
+        return FALSE;
+    }
+    newSize = 2 * (*size);
+    if (newSize < needed) {
+        newSize = needed;
+    }
+    if (newSize > maxSize) {
+        newSize = maxSize;
+    }
+    data = (picoos_uint8 *) picoos_allocate(this->common->mm, elemSize * newSize);
+    if (data == NULL) {
+        return FALSE;
+    }
+    picoos_mem_copy(*buf, data, elemSize * (*size));
+    picoos_mem_set(data + elemSize * (*size), 0, elemSize * (newSize - *size));
+    picoos_deallocate(this->common->mm, buf);
+    *buf = data;
+    *size = (picoos_int16) newSize;
+    PICODBG_INFO(("pam sentence buffer enlarged to %i elements", newSize));
+    return TRUE;
+}/*pam_grow_buffer*/
+
+/**
+ * makes sure the sentence buffers hold the requested number of syllables,
+ * phonemes and attached item bytes, enlarging them if needed
+ * @param    this : pointer to current PU struct
+ * @param    nSyll : requested number of syllables
+ * @param    nPh : requested number of phonemes
+ * @param    nItemBytes : requested size of the attached items area
+ * @return    TRUE : all requests are satisfied
+ * @return    FALSE : a buffer could not be enlarged
+ * @callgraph
+ * @callergraph
+ */
+static picoos_bool pam_reserve(register picodata_ProcessingUnit this,
+        picoos_int32 nSyll, picoos_int32 nPh, picoos_int32 nItemBytes)
+{
+    register pam_subobj_t * pam;
+    pam = (pam_subobj_t *) this->subObj;
+
+    return pam_grow_buffer(this, (void **) &pam->sSyllFeats,
+            &pam->nSyllFeatsSize, sizeof(sFtVect), nSyll,
+            PICOPAM_MAX_SYLL_PER_SENT)
+            && pam_grow_buffer(this, (void **) &pam->sPhIds, &pam->nPhIdsSize,
+                    sizeof(picoos_uint8), nPh, PICOPAM_MAX_PH_PER_SENT)
+            && pam_grow_buffer(this, (void **) &pam->sSyllItems,
+                    &pam->nSyllItemsSize, sizeof(picoos_uint8), nItemBytes,
+                    PICOPAM_MAX_ITEM_SIZE_PER_SENT);
+}/*pam_reserve*/
+
 /**
  * checks if "neededSize" is available on "nCurrPhoneme"
  * @param    pam : pam subobj
@@ -889,7 +1125,7 @@ static void get_default_boundary_limit(picoos_uint8 uBoundType,
 static pico_status_t check_phones_size(pam_subobj_t *pam,
         picoos_int16 neededSize)
 {
-    if ((pam->nCurrPhoneme + neededSize) > PICOPAM_MAX_PH_PER_SENT - 1) {
+    if ((pam->nCurrPhoneme + neededSize) > pam->nPhIdsSize - 1) {
         return PICO_ERR_OTHER;
     }
     return PICO_OK;
@@ -907,7 +1143,7 @@ static pico_status_t check_phones_size(pam_subobj_t *pam,
 static pico_status_t check_syllables_size(pam_subobj_t *pam,
         picoos_int16 neededSize)
 {
-    if ((pam->nCurrSyllable + neededSize) > PICOPAM_MAX_SYLL_PER_SENT - 1) {
+    if ((pam->nCurrSyllable + neededSize) > pam->nSyllFeatsSize - 1) {
         return PICO_ERR_OTHER;
     }
     return PICO_OK;
@@ -920,6 +1156,7 @@ static pico_status_t check_syllables_size(pam_subobj_t *pam,
  * @return    TRUE : resource limits would be reached during processing of input item
  * @return    FALSE : item could be processed normally
  * @remarks item pointed to by *item should be already valid
+ * @remarks the local storage is enlarged if needed and possible
  * @callgraph
  * @callergraph
  */
@@ -929,6 +1166,7 @@ static pico_status_t pamCheckResourceLimits(
     register pam_subobj_t * pam;
     picodata_itemhead_t head;
     pico_status_t sResult;
+    picoos_int32 nItemBytes;
     if (NULL == this || NULL == this->subObj) {
         return PICODATA_PU_ERROR;
     }
@@ -938,15 +1176,16 @@ static pico_status_t pamCheckResourceLimits(
     head.info1 = item[1];
     head.info2 = item[2];
     head.len = item[3];
+    /*room needed in the attached items area if the item has to be queued*/
+    nItemBytes = pam->nAttachedItemsSize + head.len + PICODATA_ITEM_HEADSIZE
+            + 2;
 
     switch (head.type) {
         /*commands that generate syllables/phonemes*/
         case PICODATA_ITEM_SYLLPHON:
-            if (pam->nCurrSyllable >= PICOPAM_MAX_SYLL_PER_SENT - 2) {
-                return sResult; /*no room for more syllables*/
-            }
-            if ((pam->nCurrPhoneme + head.len) >= PICOPAM_MAX_PH_PER_SENT - 2) {
-                return sResult; /*no room for more phoneme*/
+            if (!pam_reserve(this, pam->nCurrSyllable + 3, pam->nCurrPhoneme
+                    + head.len + 3, 0)) {
+                return sResult; /*no room for more syllables or phonemes*/
             }
             break;
         case PICODATA_ITEM_BOUND:
@@ -959,19 +1198,17 @@ static pico_status_t pamCheckResourceLimits(
 #endif
             ) {
 
-                if (pam->nCurrSyllable >= PICOPAM_MAX_SYLL_PER_SENT - 2) {
-                    return sResult; /*no room for more syllables*/
-                }
-                if ((pam->nCurrPhoneme + 1) >= PICOPAM_MAX_PH_PER_SENT - 2) {
-                    return sResult; /*no room for more phoneme*/
+                if (!pam_reserve(this, pam->nCurrSyllable + 3,
+                        pam->nCurrPhoneme + 4, nItemBytes)) {
+                    return sResult; /*no room for more syllables, phonemes or items*/
                 }
             }
             break;
 
         default:
             /*all other commands has to be queued*/
-            if ((pam->nAttachedItemsSize + head.len)
-                    >= PICOPAM_MAX_ITEM_SIZE_PER_SENT - 1) {
+            if (!pam_reserve(this, 0, 0, nItemBytes)
+                    || (pam->nLastAttachedItemId >= PICOPAM_MAX_ITEM_PER_SENT)) {
                 return sResult; /*no room for more items*/
             }
             break;
@@ -1084,10 +1321,13 @@ static pico_status_t pam_queue(register picodata_ProcessingUnit this,
     head.len = item[3];
 
     /*test condition on enough room to store current item in the "sSyllItems" area*/
-    if ((pam->nAttachedItemsSize + head.len + sizeof(picodata_itemhead_t))
-            >= PICOPAM_MAX_ITEM_SIZE_PER_SENT - 1) {
+    if ((pam->nAttachedItemsSize + head.len + PICODATA_ITEM_HEADSIZE)
+            >= pam->nSyllItemsSize - 1) {
         return FALSE; /*resource limit reached*/
     }
+    if (pam->nLastAttachedItemId >= PICOPAM_MAX_ITEM_PER_SENT) {
+        return FALSE; /*no more item ids*/
+    }
     /*store current offset*/
     pam->sSyllItemOffs[pam->nLastAttachedItemId] = pam->nAttachedItemsSize;
     /*store the item to the "sSyllItems" area*/
@@ -2201,8 +2441,8 @@ static pico_status_t pamPhoneProcess(register picodata_ProcessingUnit this)
     sResult = pamReorgVector(this);
 
     /*tree traversal for duration*/
-    if (!pam_do_tree(this, pam->dtdur, &(pam->sPhFeats[0]), PICOPAM_INVEC_SIZE,
-            &dTreeResult)) {
+    if (!pam_do_cached_tree(this, PICOPAM_DTID_DUR, pam->dtdur,
+            &(pam->sPhFeats[0]), PICOPAM_INVEC_SIZE, &dTreeResult)) {
         PICODBG_WARN(("problem using pam tree dtdur, using fallback value"));
         dTreeResult.class = 0;
     }
@@ -2212,8 +2452,8 @@ static pico_status_t pamPhoneProcess(register picodata_ProcessingUnit this)
 
     /*tree traversal for pitch*/
     for (nI = 0; nI < PICOPAM_MAX_STATES_PER_PHONE; nI++) {
-        if (!pam_do_tree(this, pam->dtlfz[nI], &(pam->sPhFeats[0]),
-                PICOPAM_INVEC_SIZE, &dTreeResult)) {
+        if (!pam_do_cached_tree(this, PICOPAM_DTID_LFZ + nI, pam->dtlfz[nI],
+                &(pam->sPhFeats[0]), PICOPAM_INVEC_SIZE, &dTreeResult)) {
             PICODBG_WARN(("problem using pam tree lf0Tree, using fallback value"));
             dTreeResult.class = 0;
         }
@@ -2230,8 +2470,8 @@ static pico_status_t pamPhoneProcess(register picodata_ProcessingUnit this)
     /*cep tree traversal*/
     for (nI = 0; nI < PICOPAM_MAX_STATES_PER_PHONE; nI++) {
 
-        if (!pam_do_tree(this, pam->dtmgc[nI], &(pam->sPhFeats[0]),
-                PICOPAM_INVEC_SIZE, &dTreeResult)) {
+        if (!pam_do_cached_tree(this, PICOPAM_DTID_MGC + nI, pam->dtmgc[nI],
+                &(pam->sPhFeats[0]), PICOPAM_INVEC_SIZE, &dTreeResult)) {
             PICODBG_WARN(("problem using pam tree lf0Tree, using fallback value"));
             dTreeResult.class = 0;
         }
@@ -2812,6 +3052,127 @@ static picoos_uint8 pam_do_tree(register picodata_ProcessingUnit this,
     return dtres->set;
 }/*pam_do_tree*/
 
+/**
+ * performs one step of a PamTree, looking up the result in the decision
+ * tree cache first
+ * @param    this : Pam item subobject pointer
+ * @param    treeId : the id of the tree (PICOPAM_DTID_*) used in the cache key
+ * @param    dtpam : the Pam decision tree
+ * @param    *invec : the input vector pointer
+ * @param    inveclen : length of the input vector
+ * @param    *dtres : the classification result
+ * @return    dtres->set : the result of tree traversal
+ * @remarks  the trees are deterministic functions of the input vector, so a
+ *           cached class is identical to the one obtained by traversal; only
+ *           successful traversals are cached
+ * @callgraph
+ * @callergraph
+ */
+static picoos_uint8 pam_do_cached_tree(register picodata_ProcessingUnit this,
+        picoos_uint8 treeId, const picokdt_DtPAM dtpam,
+        const picoos_uint8 *invec, const picoos_uint8 inveclen,
+        picokdt_classify_result_t *dtres)
+{
+    pam_subobj_t *pam;
+    pam_dtcache_entry_t *entry;
+    picoos_uint32 hash;
+    picoos_uint8 nI, same;
+
+    pam = (pam_subobj_t *) this->subObj;
+    if ((pam->dtCacheSize == 0) || (inveclen != PICOPAM_INVEC_SIZE)) {
+        return pam_do_tree(this, dtpam, invec, inveclen, dtres);
+    }
+
+    /*FNV-1a hash of the tree id and the input vector*/
+    hash = (2166136261u ^ treeId) * 16777619u;
+    for (nI = 0; nI < PICOPAM_INVEC_SIZE; nI++) {
+        hash = (hash ^ invec[nI]) * 16777619u;
+    }
+    entry = &(pam->dtCache[hash & (pam->dtCacheSize - 1)]);
+
+    if (entry->treeId == treeId) {
+        same = TRUE;
+        for (nI = 0; same && (nI < PICOPAM_INVEC_SIZE); nI++) {
+            same = (entry->invec[nI] == invec[nI]);
+        }
+        if (same) {
+            pam->dtCacheHits++;
+            dtres->set = TRUE;
+            dtres->class = entry->class;
+            return TRUE;
+        }
+    }
+
+    pam->dtCacheMisses++;
+    if (!pam_do_tree(this, dtpam, invec, inveclen, dtres)) {
+        return FALSE;
+    }
+    if (entry->treeId == PICOPAM_DTCACHE_EMPTY) {
+        pam->dtCacheUsed++;
+    }
+    picoos_mem_copy(invec, entry->invec, PICOPAM_INVEC_SIZE);
+    entry->treeId = treeId;
+    entry->class = dtres->class;
+    return TRUE;
+}/*pam_do_cached_tree*/
+
+/**
+ * empties the decision tree cache and clears its statistics
+ * @param    pam : Pam item subobject pointer
+ * @return   void
+ * @callgraph
+ * @callergraph
+ */
+static void pam_dtcache_clear(pam_subobj_t *pam)
+{
+    picoos_uint32 nI;
+
+    for (nI = 0; nI < pam->dtCacheSize; nI++) {
+        pam->dtCache[nI].treeId = PICOPAM_DTCACHE_EMPTY;
+    }
+    pam->dtCacheUsed = 0;
+    pam->dtCacheHits = 0;
+    pam->dtCacheMisses = 0;
+}/*pam_dtcache_clear*/
+
+/**
+ * (re)allocates the decision tree cache
+ * @param    mm : engine memory manager
+ * @param    pam : Pam item subobject pointer
+ * @param    nEntries : number of cache entries, rounded down to a power of two;
+ *           0 disables the cache
+ * @return   PICO_OK : cache allocated or disabled
+ * @return   PICO_EXC_OUT_OF_MEM : not enough memory, the cache is disabled
+ * @callgraph
+ * @callergraph
+ */
+static pico_status_t pam_dtcache_resize(picoos_MemoryManager mm,
+        pam_subobj_t *pam, picoos_uint32 nEntries)
+{
+    picoos_uint32 size;
+
+    if (pam->dtCache != NULL) {
+        picoos_deallocate(mm, (void *) &pam->dtCache);
+    }
+    pam->dtCacheSize = 0;
+    if (nEntries > 0) {
+        for (size = 1; (size << 1) <= nEntries; size <<= 1) {
+            /*largest power of two not above nEntries*/
+        }
+        pam->dtCache = (pam_dtcache_entry_t *) picoos_allocate(mm,
+                sizeof(pam_dtcache_entry_t) * size);
+        if (pam->dtCache == NULL) {
+            PICODBG_WARN(("no memory for a decision tree cache of %i entries",
+                    size));
+            pam_dtcache_clear(pam);
+            return PICO_EXC_OUT_OF_MEM;
+        }
+        pam->dtCacheSize = size;
+    }
+    pam_dtcache_clear(pam);
+    return PICO_OK;
+}/*pam_dtcache_resize*/
+
 /**
  * returns the carrier vowel id inside a syllable
  * @param    this : Pam item subobject pointer
@@ -2963,6 +3324,9 @@ static pico_status_t pam_reset_processors(register picodata_ProcessingUnit this)
     }
     pam = (pam_subobj_t *) this->subObj;
 
+    /*remember the syllable vectors this sentence may have written*/
+    if (pam->nSyllFeatsUsed < pam->nTotalSyllables + 1)
+        pam->nSyllFeatsUsed = pam->nTotalSyllables + 1;
     pam->nCurrSyllable = -1;
     pam->nTotalPhonemes = pam->nSyllPhoneme = pam->nCurrPhoneme
             = pam->nTotalSyllables = pam->sType = pam->pType = 0;
@@ -4584,6 +4948,7 @@ static pico_status_t pam_adapter_forward_step(
  * @param    this : pointer to PAM PU sub object pointer
  * @return    PICO_OK : backward step complete
  * @return  PICO_ERR_OTHER : errors on retrieving the PU pointer
+ * @return  PICO_ERR_OTHER : the engine was cancelled (the sentence is discarded)
  * @remarks derived in some parts from the pam forward code
  * @callgraph
  * @callergraph
@@ -4605,6 +4970,9 @@ static pico_status_t pam_adapter_backward_step(
     /*Do the backward step*/
     nSyll = pam->nCurrSyllable;
     while (pam->nCurrSyllable >= 0) {
+        if (picopal_atomic_get(&this->common->cancel)) {
+            return PICO_ERR_OTHER;
+        }
         nProcessed = 0;
         if (pam->sSyllFeats[pam->nCurrSyllable].phoneV[P2] == 1) {
             /*primary boundary*/
@@ -73,6 +73,24 @@ picodata_ProcessingUnit picopam_newPamUnit(
     picodata_CharBuffer cbIn,   picodata_CharBuffer cbOut,
     picorsrc_Voice voice);
 
+/**
+ * Sets the number of entries of the cache of decision tree results kept by
+ * the PAM unit across sentences (rounded down to a power of two, 0 disables
+ * the cache). The cache is allocated from the engine memory; if that is
+ * exhausted, PICO_EXC_OUT_OF_MEM is returned and the cache stays disabled
+ */
+pico_status_t picopam_setTreeCacheSize(picodata_ProcessingUnit this,
+        picoos_uint32 nEntries);
+
+/**
+ * Returns the number of entries of the decision tree cache, the number of
+ * entries in use, and the number of tree lookups answered from the cache
+ * (hits) and by tree traversal (misses) since the last full reset or resize
+ */
+pico_status_t picopam_getTreeCacheStats(picodata_ProcessingUnit this,
+        picoos_uint32 * size, picoos_uint32 * used,
+        picoos_uint32 * hits, picoos_uint32 * misses);
+
 #ifdef __cplusplus
 }
 #endif
@@ -54,10 +54,40 @@ extern "C" {
 #define PR_WORK_MEM_SIZE  10000
 #define PR_DYN_MEM_SIZE   7000
 
+/* default maximal sizes of the working and dynamic memory partitions, used
+   unless the voice sets its own (picorsrc_setVoicePreprocMemLimit); a
+   partition starts with the size above and grows in chunks of that size,
+   allocated from the engine memory, while it is exhausted */
+#if !defined(PR_WORK_MEM_MAX_SIZE)
+#define PR_WORK_MEM_MAX_SIZE  (4 * PR_WORK_MEM_SIZE)
+#endif
+#if !defined(PR_DYN_MEM_MAX_SIZE)
+#define PR_DYN_MEM_MAX_SIZE   (4 * PR_DYN_MEM_SIZE)
+#endif
+
+#define PR_MAX_MEM_CHUNKS 16
+
+#define PR_WORK_MEM_MAX_CHUNKS  (PR_WORK_MEM_MAX_SIZE / PR_WORK_MEM_SIZE)
+#define PR_DYN_MEM_MAX_CHUNKS   (PR_DYN_MEM_MAX_SIZE / PR_DYN_MEM_SIZE)
+
+#if (PR_WORK_MEM_MAX_CHUNKS < 1) || (PR_WORK_MEM_MAX_CHUNKS > PR_MAX_MEM_CHUNKS) || \
+    (PR_DYN_MEM_MAX_CHUNKS < 1) || (PR_DYN_MEM_MAX_CHUNKS > PR_MAX_MEM_CHUNKS)
+#error "PR_WORK_MEM_MAX_SIZE / PR_DYN_MEM_MAX_SIZE out of range"
+#endif
+
 #define PR_ENABLED TRUE
 
 #define PR_MAX_NR_ITERATIONS 1000;
 
+/* search beam: maximal number of token matches per path search before the
+   best path found so far is taken; 0 searches exhaustively */
+#if !defined(PR_SEARCH_BEAM)
+#define PR_SEARCH_BEAM 0
+#endif
+
+/* number of entries of the token match cache (power of 2) */
+#define PR_MATCH_CACHE_SIZE 256
+
 #define SPEC_CHAR           "\\/"
 
 #define PICO_ERR_CONTEXT_NOT_FOUND            PICO_ERR_OTHER
@@ -256,14 +286,27 @@ struct pr_PathEle {
     picokpr_StrArrOffset rprodname;
     picoos_int32 rprodprefcost;
     pr_LocalState rlState;
+    picoos_int32 rcostacc;      /* path cost up to and including this element */
+    picoos_bool rcostfirst;     /* lexical cost state after this element */
 };
 
 typedef struct pr_Path {
     picoos_int32 rcost;
     picoos_int32 rlen;
+    picoos_int32 rcostlen;      /* nr of leading elements with valid rcostacc */
     struct pr_PathEle rele[PR_MAX_PATH_LEN];
 } pr_Path;
 
+/* cached result of matching token 'tok' of 'network' with item 'itemid' */
+typedef struct pr_MatchCacheEle {
+    picokpr_Preproc network;
+    picokpr_TokArrOffset tok;
+    picoos_int16 itemid;
+    picoos_int16 compare;
+    picoos_uint16 gen;
+    picoos_uint8 state;
+} pr_MatchCacheEle;
+
 /* *****************************************************************************/
 
 /** subobject : PreprocUnit
@@ -278,6 +321,9 @@ typedef struct pr_subobj
     pr_GlobalState rgState;
     pr_Path ractpath;
     pr_Path rbestpath;
+    pr_MatchCacheEle matchCache[PR_MATCH_CACHE_SIZE];
+    picoos_uint16 matchCacheGen;   /* entries of other generations are invalid */
+    picoos_int32 nrMatches;        /* token matches of the current search */
     picoos_int32 rnritems;
     pr_WorkItems ritems;
     picoos_int32 rignore;
@@ -305,8 +351,14 @@ typedef struct pr_subobj
     picoos_uint8 pr_WorkMem[PR_WORK_MEM_SIZE];
     picoos_uint32 workMemTop;
     picoos_uint32 maxWorkMemTop;
-    picoos_uint8 pr_DynMem[PR_DYN_MEM_SIZE];
-    picoos_MemoryManager dynMemMM;
+    picoos_uint8 nrWorkMemChunks;
+    picoos_uint8 nrDynMemChunks;
+    picoos_uint8 maxWorkMemChunks;
+    picoos_uint8 maxDynMemChunks;
+    picoos_uint8 * workMemChunk[PR_MAX_MEM_CHUNKS];  /* [0] is pr_WorkMem */
+    picoos_uint8 * dynMemChunk[PR_MAX_MEM_CHUNKS];   /* [0] is pr_DynMem */
+    picoos_MemoryManager dynMemMM[PR_MAX_MEM_CHUNKS];
+    picoos_uint8 pr_DynMem[PR_DYN_MEM_SIZE];         /* pointer aligned for its memory manager */
     picoos_int32 dynMemSize;
     picoos_int32 maxDynMemSize;
 
@@ -352,27 +404,110 @@ static void pr_getOutputItemList (picodata_ProcessingUnit this, pr_subobj_t * pr
    Working memory is allocated in pr_subobj_t->pr_WorkMem. Working memory is stack
    based and may not to be deallocated with pr_DEALLOCATE, but with pr_resetMemState
    to a state previously saved with pr_getMemState.
+   If a partition is exhausted, it is extended by a chunk of the same size
+   allocated from the engine memory, up to the maximal size set for the voice
+   or PR_WORK_MEM_MAX_SIZE and PR_DYN_MEM_MAX_SIZE respectively. The chunks are kept until the unit is
+   disposed. The working memory top is an offset into the concatenation of the
+   working memory chunks; an allocation that does not fit into the rest of a
+   chunk starts at the next chunk.
 */
 
+static picoos_bool pr_addMemChunk (picodata_ProcessingUnit this, pr_subobj_t * pr, pr_MemTypes mType)
+{
+    picoos_uint8 * chunk;
+
+    if (mType == pr_WorkMem) {
+        if (pr->nrWorkMemChunks >= pr->maxWorkMemChunks) {
+            return FALSE;
+        }
+        chunk = (picoos_uint8 *) picoos_allocate(this->common->mm, PR_WORK_MEM_SIZE);
+        if (NULL == chunk) {
+            return FALSE;
+        }
+        pr->workMemChunk[pr->nrWorkMemChunks++] = chunk;
+        PICODBG_INFO(("pr_WorkMem extended to %i chunks", pr->nrWorkMemChunks));
+    }
+    else {
+        if (pr->nrDynMemChunks >= pr->maxDynMemChunks) {
+            return FALSE;
+        }
+        chunk = (picoos_uint8 *) picoos_allocate(this->common->mm, PR_DYN_MEM_SIZE);
+        if (NULL == chunk) {
+            return FALSE;
+        }
+        pr->dynMemMM[pr->nrDynMemChunks] = picoos_newMemoryManager((void *)chunk, PR_DYN_MEM_SIZE,
+                /*enableMemProt*/ FALSE);
+        if (NULL == pr->dynMemMM[pr->nrDynMemChunks]) {
+            picoos_deallocate(this->common->mm, (void *) &chunk);
+            return FALSE;
+        }
+        pr->dynMemChunk[pr->nrDynMemChunks++] = chunk;
+        PICODBG_INFO(("pr_DynMem extended to %i chunks", pr->nrDynMemChunks));
+    }
+    return TRUE;
+}
+
+
+/* number of chunks of 'chunkSize' bytes a partition of at most 'maxSize'
+   bytes may have; 'defChunks' if 'maxSize' is 0 */
+static picoos_uint8 pr_maxMemChunks (picoos_uint32 maxSize, picoos_uint32 chunkSize, picoos_uint8 defChunks)
+{
+    picoos_uint32 chunks;
+
+    if (maxSize == 0) {
+        return defChunks;
+    }
+    chunks = (maxSize + chunkSize - 1) / chunkSize;
+    return (picoos_uint8) ((chunks > PR_MAX_MEM_CHUNKS) ? PR_MAX_MEM_CHUNKS : chunks);
+}
+
+
+static void pr_updateDynMemSize (pr_subobj_t * pr)
+{
+    picoos_int32 i, usedBytes, incrUsedBytes, maxUsedBytes;
+
+    pr->dynMemSize = 0;
+    for (i = 0; i < pr->nrDynMemChunks; i++) {
+        picoos_getMemUsage(pr->dynMemMM[i], 1, &usedBytes, &incrUsedBytes, &maxUsedBytes);
+        pr->dynMemSize += usedBytes;
+    }
+    if (pr->dynMemSize > pr->maxDynMemSize) {
+        pr->maxDynMemSize = pr->dynMemSize;
+    }
+}
+
+
 static void pr_ALLOCATE (picodata_ProcessingUnit this, pr_MemTypes mType, void * * adr, unsigned int byteSize)
   /* allocates 'byteSize' bytes in the memery partition given by 'mType' */
 {
     pr_subobj_t * pr = (pr_subobj_t *) this->subObj;
-    picoos_int32 incrUsedBytes, prevmaxDynMemSize;
+    picoos_int32 prevmaxDynMemSize;
+    picoos_uint32 chunk, ofs;
+    picoos_int32 i;
 
     if (mType == pr_WorkMem) {
-        if ((pr->workMemTop + byteSize) < PR_WORK_MEM_SIZE) {
-            (*adr) = (void *)(&(pr->pr_WorkMem[pr->workMemTop]));
+        chunk = pr->workMemTop / PR_WORK_MEM_SIZE;
+        ofs = pr->workMemTop % PR_WORK_MEM_SIZE;
+        if ((ofs + byteSize) >= PR_WORK_MEM_SIZE) {
+            chunk++;
+            ofs = 0;
+        }
+        if ((chunk >= pr->nrWorkMemChunks) && (byteSize < PR_WORK_MEM_SIZE) &&
+            !pr_addMemChunk(this, pr, pr_WorkMem)) {
+            chunk = PR_MAX_MEM_CHUNKS;
+        }
+        if ((chunk < pr->nrWorkMemChunks) && ((ofs + byteSize) < PR_WORK_MEM_SIZE)) {
+            (*adr) = (void *)(&(pr->workMemChunk[chunk][ofs]));
             byteSize = ((byteSize + PICOOS_ALIGN_SIZE - 1) / PICOOS_ALIGN_SIZE) * PICOOS_ALIGN_SIZE;
-            pr->workMemTop += byteSize;
+            pr->workMemTop = chunk * PR_WORK_MEM_SIZE + ofs + byteSize;
 #if PR_TRACE_MEM
-            PICODBG_INFO(("pr_WorkMem: +%u, tot:%i of %i", byteSize, pr->workMemTop, PR_WORK_MEM_SIZE));
+            PICODBG_INFO(("pr_WorkMem: +%u, tot:%i of %i", byteSize, pr->workMemTop, pr->nrWorkMemChunks * PR_WORK_MEM_SIZE));
 #endif
 
             if (pr->workMemTop > pr->maxWorkMemTop) {
                 pr->maxWorkMemTop = pr->workMemTop;
 #if PR_TRACE_MAX_MEM
-                PICODBG_INFO(("new max pr_WorkMem: %i of %i", pr->workMemTop, PR_WORK_MEM_SIZE));
+                PICODBG_INFO(("new max pr_WorkMem: %i of %i", pr->workMemTop, pr->nrWorkMemChunks * PR_WORK_MEM_SIZE));
 #endif
             }
         }
@@ -384,17 +519,23 @@ static void pr_ALLOCATE (picodata_ProcessingUnit this, pr_MemTypes mType, void *
         }
     }
     else if (mType == pr_DynMem) {
-        (*adr) = picoos_allocate(pr->dynMemMM, byteSize);
+        (*adr) = NULL;
+        for (i = 0; (i < pr->nrDynMemChunks) && ((*adr) == NULL); i++) {
+            (*adr) = picoos_allocate(pr->dynMemMM[i], byteSize);
+        }
+        if (((*adr) == NULL) && pr_addMemChunk(this, pr, pr_DynMem)) {
+            (*adr) = picoos_allocate(pr->dynMemMM[pr->nrDynMemChunks-1], byteSize);
+        }
         if ((*adr) != NULL) {
             prevmaxDynMemSize = pr->maxDynMemSize;
-            picoos_getMemUsage(pr->dynMemMM, 1, &pr->dynMemSize, &incrUsedBytes, &pr->maxDynMemSize);
+            pr_updateDynMemSize(pr);
 #if PR_TRACE_MEM
-            PICODBG_INFO(("pr_DynMem : +%i, tot:%i of %i", incrUsedBytes, pr->dynMemSize, PR_DYN_MEM_SIZE));
+            PICODBG_INFO(("pr_DynMem : +%i, tot:%i of %i", byteSize, pr->dynMemSize, pr->nrDynMemChunks * PR_DYN_MEM_SIZE));
 #endif
 
 #if PR_TRACE_MAX_MEM
             if (pr->maxDynMemSize > prevmaxDynMemSize) {
-                PICODBG_INFO(("new max pr_DynMem : %i of %i", pr->maxDynMemSize, PR_DYN_MEM_SIZE));
+                PICODBG_INFO(("new max pr_DynMem : %i of %i", pr->maxDynMemSize, pr->nrDynMemChunks * PR_DYN_MEM_SIZE));
             }
 #endif
         }
@@ -413,15 +554,21 @@ static void pr_ALLOCATE (picodata_ProcessingUnit this, pr_MemTypes mType, void *
 static void pr_DEALLOCATE (picodata_ProcessingUnit this, pr_MemTypes mType, void * * adr)
 {
     pr_subobj_t * pr = (pr_subobj_t *) this->subObj;
-    picoos_int32 incrUsedBytes;
+    picoos_int32 i;
     if (mType == pr_WorkMem) {
         PICODBG_INFO(("not possible; use pr_resetMemState instead"));
     }
     else if (mType == pr_DynMem) {
-        picoos_deallocate(pr->dynMemMM, &(*adr));
-        picoos_getMemUsage(pr->dynMemMM, 1, &pr->dynMemSize, &incrUsedBytes, &pr->maxDynMemSize);
+        for (i = 0; i < pr->nrDynMemChunks; i++) {
+            if (((picoos_uint8 *)(*adr) >= pr->dynMemChunk[i]) &&
+                ((picoos_uint8 *)(*adr) < pr->dynMemChunk[i] + PR_DYN_MEM_SIZE)) {
+                picoos_deallocate(pr->dynMemMM[i], &(*adr));
+                break;
+            }
+        }
+        pr_updateDynMemSize(pr);
 #if PR_TRACE_MEM
-        PICODBG_INFO(("pr_DynMem : %i, tot:%i of %i: adr: %u", incrUsedBytes, pr->dynMemSize, PR_DYN_MEM_SIZE, *adr));
+        PICODBG_INFO(("pr_DynMem : tot:%i of %i: adr: %u", pr->dynMemSize, pr->nrDynMemChunks * PR_DYN_MEM_SIZE, *adr));
 #endif
     }
     else {
@@ -443,7 +590,7 @@ static void pr_resetMemState(picodata_ProcessingUnit this, pr_MemTypes mType, pi
     pr_subobj_t * pr = (pr_subobj_t *) this->subObj;
 
 #if PR_TRACE_MEM
-    PICODBG_INFO(("pr_WorkMem: -%i, tot:%i of %i", pr->workMemTop-lmemState, lmemState, PR_WORK_MEM_SIZE));
+    PICODBG_INFO(("pr_WorkMem: -%i, tot:%i of %i", pr->workMemTop-lmemState, lmemState, pr->nrWorkMemChunks * PR_WORK_MEM_SIZE));
 #endif
     mType = mType;        /* avoid warning "var not used in this function"*/
     pr->workMemTop = lmemState;
@@ -1968,18 +2115,17 @@ static void pr_getOutputItemList (picodata_ProcessingUnit this,
 static picoos_int32 pr_attrVal (picokpr_Preproc network, picokpr_TokArrOffset tok, pr_TokSetEleWP type)
 {
 
-    pr_TokSetEleWP tse;
     picoos_int32 n;
     picokpr_TokSetWP set;
 
+    /* the attribute values of a token are stored in the order of the token
+       set elements (starting with PR_FIRST_TSE_WP = 0); count the elements
+       present before 'type' */
     n = 0;
-    tse = PR_FIRST_TSE_WP;
-    set = picokpr_getTokSetWP(network, tok);
-    while (tse < type) {
-        if (((1<<tse) & set) != 0) {
-            n++;
-        }
-        tse = (pr_TokSetEleWP)((picoos_int32)tse+1);
+    set = picokpr_getTokSetWP(network, tok) & (((picokpr_TokSetWP)1 << type) - 1);
+    while (set != 0) {
+        set &= set - 1;
+        n++;
     }
     return picokpr_getAttrValArrInt32(network, picokpr_getTokAttribOfs(network, tok) + n);
 }
@@ -2251,6 +2397,26 @@ static void pr_compare (picoos_uchar str1lc[], picoos_uchar str2[], picoos_int16
 }
 
 
+/* same as pr_compare, but with 'str2lc' already lowercase (see
+   picokpr_getVarStrLcPtr) the comparison is a plain byte comparison */
+static void pr_compareLc (picoos_uchar str1lc[], picoos_uchar str2lc[], picoos_int16 * result)
+{
+    picoos_int32 i;
+
+    i = 0;
+    while ((i < PR_MAX_DATA_LEN) && (str1lc[i] != 0) && (str1lc[i] == str2lc[i])) {
+        i++;
+    }
+    if ((i >= PR_MAX_DATA_LEN) || (str1lc[i] == 0)) {
+        *result = (str2lc[i] == 0) ? PR_EQUAL : PR_SMALLER;
+    } else if ((str2lc[i] == 0) || (str1lc[i] > str2lc[i])) {
+        *result = PR_LARGER;
+    } else {
+        *result = PR_SMALLER;
+    }
+}
+
+
 static picoos_bool pr_hasToken (picokpr_TokSetWP * tswp, picokpr_TokSetNP * tsnp)
 {
     return ((((  PR_TSE_MASK_SPACE | PR_TSE_MASK_DIGIT | PR_TSE_MASK_LETTER | PR_TSE_MASK_SEQ
@@ -2309,6 +2475,9 @@ static picoos_bool pr_getAltToken (picodata_ProcessingUnit this, pr_subobj_t * p
         }
         with__0->rlState = PR_LSInit;
         with__0->rtok = lTok;
+        if (pr->ractpath.rcostlen >= pr->ractpath.rlen) {
+            pr->ractpath.rcostlen = pr->ractpath.rlen - 1;
+        }
         with__0->ritemid =  -1;
         with__0->rcompare =  -1;
         with__0->rprodname = 0;
@@ -2370,6 +2539,10 @@ static picoos_bool pr_getProdToken (picodata_ProcessingUnit this, pr_subobj_t *
         with__0 = & pr->ractpath.rele[pr->ractpath.rlen - 1];
         wpset = picokpr_getTokSetWP(with__0->rnetwork, with__0->rtok);
         if ((PR_TSE_MASK_PROD & wpset) != 0) {
+            /* the production prefix cost of the element changes */
+            if (pr->ractpath.rcostlen >= pr->ractpath.rlen) {
+                pr->ractpath.rcostlen = pr->ractpath.rlen - 1;
+            }
             if ((PR_TSE_MASK_PRODEXT & wpset) != 0) {
                 pr_initPathEle(& pr->ractpath.rele[pr->ractpath.rlen]);
                 lstrp = picokpr_getVarStrPtr(with__0->rnetwork, pr_attrVal(with__0->rnetwork, with__0->rtok, PR_TSEProdExt));
@@ -2793,6 +2966,7 @@ static pr_MatchState pr_matchTokens (picodata_ProcessingUnit this, pr_subobj_t *
 
     register struct pr_PathEle * with__0;
     picokpr_VarStrPtr lstrp;
+    picokpr_StrArrOffset lstrofs;
     picokpr_TokSetNP npset;
     picokpr_TokSetWP wpset;
 
@@ -2802,8 +2976,14 @@ static pr_MatchState pr_matchTokens (picodata_ProcessingUnit this, pr_subobj_t *
 
     *cmpres = PR_EQUAL;
     if ((PR_TSE_MASK_STR & wpset) != 0) {
-        lstrp = picokpr_getVarStrPtr(with__0->rnetwork, pr_attrVal(with__0->rnetwork, with__0->rtok, PR_TSEStr));
-        pr_compare(pr->ritems[with__0->ritemid+1]->strci,lstrp,cmpres);
+        lstrofs = pr_attrVal(with__0->rnetwork, with__0->rtok, PR_TSEStr);
+        lstrp = picokpr_getVarStrLcPtr(with__0->rnetwork, lstrofs);
+        if (NULL != lstrp) {
+            pr_compareLc(pr->ritems[with__0->ritemid+1]->strci,lstrp,cmpres);
+        } else {
+            lstrp = picokpr_getVarStrPtr(with__0->rnetwork, lstrofs);
+            pr_compare(pr->ritems[with__0->ritemid+1]->strci,lstrp,cmpres);
+        }
     }
     if (((PR_TSE_MASK_LEX & wpset) == PR_TSE_MASK_LEX) && ((PR_TSE_MASK_LETTER & npset) == 0)) {
         return pr_matchMultiToken(this, pr, npset, wpset);
@@ -2839,53 +3019,105 @@ static pr_MatchState pr_matchTokens (picodata_ProcessingUnit this, pr_subobj_t *
 }
 
 
+/* starts a new generation of the token match cache; needed whenever the
+   item ids may refer to other items, i.e. at the start of each search */
+static void pr_newMatchCacheGen (pr_subobj_t * pr)
+{
+    pr->matchCacheGen++;
+    if (pr->matchCacheGen == 0) {
+        picoos_mem_set(pr->matchCache, 0, sizeof(pr->matchCache));
+        pr->matchCacheGen = 1;
+    }
+}
+
+
+/* pr_matchTokens only depends on the network token and the item, which do
+   not change during a search; alternative paths through the networks often
+   match the same token with the same item again */
+static pr_MatchState pr_matchTokensCached (picodata_ProcessingUnit this, pr_subobj_t * pr, picoos_int16 * cmpres)
+{
+    register struct pr_PathEle * with__0;
+    pr_MatchCacheEle * ce;
+    pr_MatchState mstate;
+
+    with__0 = & pr->ractpath.rele[pr->ractpath.rlen - 1];
+    ce = & pr->matchCache[((picoos_uint32)with__0->rtok * 31 + (picoos_uint32)with__0->ritemid) & (PR_MATCH_CACHE_SIZE - 1)];
+    if ((ce->gen == pr->matchCacheGen) && (ce->network == with__0->rnetwork) &&
+        (ce->tok == with__0->rtok) && (ce->itemid == with__0->ritemid)) {
+        *cmpres = ce->compare;
+        return (pr_MatchState)ce->state;
+    }
+    mstate = pr_matchTokens(this, pr, cmpres);
+    ce->network = with__0->rnetwork;
+    ce->tok = with__0->rtok;
+    ce->itemid = with__0->ritemid;
+    ce->compare = *cmpres;
+    ce->state = (picoos_uint8)mstate;
+    ce->gen = pr->matchCacheGen;
+    return mstate;
+}
+
+
 static void pr_calcPathCost (struct pr_Path * path)
 {
     picoos_int32 li;
+    picoos_int32 cost;
     picoos_bool lfirst;
     picokpr_TokSetWP wpset;
     picokpr_TokSetNP npset;
-#if PR_TRACE_PATHCOST
+#if PR_TRACE_PATHCOST && defined(PICO_DEBUG)
     picoos_uchar str[1000];
     picoos_uchar * strp;
 #endif
 
-#if PR_TRACE_PATHCOST
-    str[0] = 0;
-#endif
-
-    lfirst = TRUE;
-    path->rcost = PR_COST_INIT;
-    for (li = 0; li < path->rlen; li++) {
+    /* the cost of the elements before 'rcostlen' is still valid; only the
+       changed tail of the path is accumulated */
+    if (path->rcostlen > path->rlen) {
+        path->rcostlen = path->rlen;
+    }
+    if (path->rcostlen > 0) {
+        cost = path->rele[path->rcostlen-1].rcostacc;
+        lfirst = path->rele[path->rcostlen-1].rcostfirst;
+    } else {
+        cost = PR_COST_INIT;
+        lfirst = TRUE;
+    }
+    for (li = path->rcostlen; li < path->rlen; li++) {
         if (li == 0) {
-            path->rcost = path->rcost + path->rele[li].rprodprefcost;
+            cost = cost + path->rele[li].rprodprefcost;
         }
         wpset = picokpr_getTokSetWP(path->rele[li].rnetwork, path->rele[li].rtok);
         npset = picokpr_getTokSetNP(path->rele[li].rnetwork, path->rele[li].rtok);
         if ((PR_TSE_MASK_COST & wpset) != 0) {
             if (((PR_TSE_MASK_LEX & wpset) == PR_TSE_MASK_LEX) && ((PR_TSE_MASK_LETTER & npset) == 0)) {
                 if (lfirst) {
-                    path->rcost = path->rcost - PR_COST + pr_attrVal(path->rele[li].rnetwork, path->rele[li].rtok, PR_TSECost);
+                    cost = cost - PR_COST + pr_attrVal(path->rele[li].rnetwork, path->rele[li].rtok, PR_TSECost);
                 } else {
-                    path->rcost = path->rcost - PR_COST;
+                    cost = cost - PR_COST;
                 }
                 lfirst = FALSE;
             } else {
-                path->rcost = path->rcost - PR_COST + pr_attrVal(path->rele[li].rnetwork, path->rele[li].rtok, PR_TSECost);
+                cost = cost - PR_COST + pr_attrVal(path->rele[li].rnetwork, path->rele[li].rtok, PR_TSECost);
                 lfirst = TRUE;
             }
         } else if (pr_hasToken(& wpset,& npset)) {
-            path->rcost = path->rcost - PR_COST;
+            cost = cost - PR_COST;
         }
-#if PR_TRACE_PATHCOST
+        path->rele[li].rcostacc = cost;
+        path->rele[li].rcostfirst = lfirst;
+    }
+    path->rcostlen = path->rlen;
+    path->rcost = cost;
+
+#if PR_TRACE_PATHCOST && defined(PICO_DEBUG)
+    str[0] = 0;
+    for (li = 0; li < path->rlen; li++) {
         if ((path->rele[li].rprodname != 0)) {
             strp = picokpr_getVarStrPtr(path->rele[li].rnetwork, path->rele[li].rprodname);
             picoos_strcat(str, (picoos_char *)" ");
             picoos_strcat(str, strp);
         }
-#endif
     }
-#if PR_TRACE_PATHCOST
     PICODBG_INFO(("pp cost: %i %s", path->rcost, str));
 #endif
 }
@@ -2952,6 +3184,9 @@ void pr_processToken (picodata_ProcessingUnit this, pr_subobj_t * pr)
                     break;
                 case PR_LSGoBack:
                     pr->ractpath.rlen--;
+                    if (pr->ractpath.rcostlen > pr->ractpath.rlen) {
+                        pr->ractpath.rcostlen = pr->ractpath.rlen;
+                    }
                     break;
                 case PR_LSGetToken:
                     if (pr_getToken(this, pr)) {
@@ -2971,7 +3206,14 @@ void pr_processToken (picodata_ProcessingUnit this, pr_subobj_t * pr)
                     }
                     break;
                 case PR_LSMatch:
-                    switch (pr_matchTokens(this, pr, & with__0->rcompare)) {
+                    pr->nrMatches++;
+                    if ((PR_SEARCH_BEAM > 0) && (pr->nrMatches > PR_SEARCH_BEAM) && (pr->rbestpath.rlen > 0)) {
+                        /* search beam exhausted: take the best path found so far */
+                        PICODBG_INFO(("search beam reached"));
+                        pr->rgState = PR_GSFound;
+                        break;
+                    }
+                    switch (pr_matchTokensCached(this, pr, & with__0->rcompare)) {
                         case PR_MSMatched:
                             with__0->rlState = PR_LSGetNextToken;
                             break;
@@ -3013,9 +3255,12 @@ void pr_process (picodata_ProcessingUnit this, pr_subobj_t * pr)
         case PR_GSFound:
         case PR_GSNotFound:
             pr->ractpath.rlen = 0;
+            pr->ractpath.rcostlen = 0;
             pr->ractpath.rcost = PR_COST_INIT;
             pr->rbestpath.rlen = 0;
             pr->rbestpath.rcost = PR_COST_INIT;
+            pr_newMatchCacheGen(pr);
+            pr->nrMatches = 0;
             if (pr_getTopLevelToken(this, pr, TRUE)) {
                 pr->rgState = PR_GSContinue;
             } else {
@@ -3138,6 +3383,7 @@ extern void pr_treatItem (picodata_ProcessingUnit this, pr_subobj_t * pr, pr_ioI
             pr->rgState = PR_GS_START;
             pr->ractpath.rcost = PR_COST_INIT;
             pr->ractpath.rlen = 0;
+            pr->ractpath.rcostlen = 0;
             pr->rbestpath.rcost = PR_COST_INIT;
             pr->rbestpath.rlen = 0;
             pr->prodList = NULL;
@@ -3185,8 +3431,13 @@ pico_status_t prReset(register picodata_ProcessingUnit this, picoos_int32 resetM
     pr->rlastOutItem = NULL;
     pr->ractpath.rcost = PR_COST_INIT;
     pr->ractpath.rlen = 0;
+    pr->ractpath.rcostlen = 0;
     pr->rbestpath.rcost = PR_COST_INIT;
     pr->rbestpath.rlen = 0;
+    pr->rbestpath.rcostlen = 0;
+    picoos_mem_set(pr->matchCache, 0, sizeof(pr->matchCache));
+    pr->matchCacheGen = 1;
+    pr->nrMatches = 0;
     pr->rnritems = 0;
     pr->ritems[0] = NULL;
     pr->rignore = 0;
@@ -3215,19 +3466,24 @@ pico_status_t prReset(register picodata_ProcessingUnit this, picoos_int32 resetM
     else {
         pr->workMemTop = PICOOS_ALIGN_SIZE - ((uintptr_t)pr->pr_WorkMem % PICOOS_ALIGN_SIZE);
     }
-    pr->maxWorkMemTop=0;
     pr->dynMemSize=0;
-    pr->maxDynMemSize=0;
+    if (resetMode == PICO_RESET_FULL) {
+        /* the high-water marks are kept over soft resets (see picopr_getMemStats) */
+        pr->maxWorkMemTop=0;
+        pr->maxDynMemSize=0;
+    }
     /* this is ok to be in 'initialize' because it is a private memory within pr. Creating a new mm
      * here amounts to resetting this internal memory
      */
-    pr->dynMemMM = picoos_newMemoryManager((void *)pr->pr_DynMem, PR_DYN_MEM_SIZE,
-            /*enableMemProt*/ FALSE);
+    for (i = 0; i < pr->nrDynMemChunks; i++) {
+        pr->dynMemMM[i] = picoos_newMemoryManager((void *)pr->dynMemChunk[i], PR_DYN_MEM_SIZE,
+                /*enableMemProt*/ FALSE);
+    }
     pr->outOfMemory = FALSE;
 
     pr->forceOutput = FALSE;
 
-    if (resetMode == PICO_RESET_SOFT) {
+    if (resetMode != PICO_RESET_FULL) {
         /*following initializations needed only at startup or after a full reset*/
         return PICO_OK;
     }
@@ -3270,9 +3526,17 @@ pico_status_t prSubObjDeallocate(register picodata_ProcessingUnit this,
     if (NULL != this) {
         pr = (pr_subobj_t *) this->subObj;
         mm = mm;        /* avoid warning "var not used in this function"*/
-        PICODBG_INFO(("max pr_WorkMem: %i of %i", pr->maxWorkMemTop, PR_WORK_MEM_SIZE));
-        PICODBG_INFO(("max pr_DynMem: %i of %i", pr->maxDynMemSize, PR_DYN_MEM_SIZE));
+        PICODBG_INFO(("max pr_WorkMem: %i of %i", pr->maxWorkMemTop, pr->nrWorkMemChunks * PR_WORK_MEM_SIZE));
+        PICODBG_INFO(("max pr_DynMem: %i of %i", pr->maxDynMemSize, pr->nrDynMemChunks * PR_DYN_MEM_SIZE));
 
+        while (pr->nrWorkMemChunks > 1) {
+            pr->nrWorkMemChunks--;
+            picoos_deallocate(this->common->mm, (void *) &pr->workMemChunk[pr->nrWorkMemChunks]);
+        }
+        while (pr->nrDynMemChunks > 1) {
+            pr->nrDynMemChunks--;
+            picoos_deallocate(this->common->mm, (void *) &pr->dynMemChunk[pr->nrDynMemChunks]);
+        }
         pr_disposeContextList(this);
         picoos_deallocate(this->common->mm, (void *) &this->subObj);
     }
@@ -3308,6 +3572,13 @@ picodata_ProcessingUnit picopr_newPreprocUnit(picoos_MemoryManager mm, picoos_Co
     }
     pr = (pr_subobj_t *) this->subObj;
 
+    pr->workMemChunk[0] = pr->pr_WorkMem;
+    pr->nrWorkMemChunks = 1;
+    pr->dynMemChunk[0] = pr->pr_DynMem;
+    pr->nrDynMemChunks = 1;
+    pr->maxWorkMemChunks = pr_maxMemChunks(this->voice->prWorkMemMax, PR_WORK_MEM_SIZE, PR_WORK_MEM_MAX_CHUNKS);
+    pr->maxDynMemChunks = pr_maxMemChunks(this->voice->prDynMemMax, PR_DYN_MEM_SIZE, PR_DYN_MEM_MAX_CHUNKS);
+
     pr->graphs = picoktab_getGraphs(this->voice->kbArray[PICOKNOW_KBID_TAB_GRAPHS]);
     pr->preproc[0] = picokpr_getPreproc(this->voice->kbArray[PICOKNOW_KBID_TPP_MAIN]);
     for (i=0; i<PICOKNOW_MAX_NUM_UTPP; i++) {
@@ -3323,6 +3594,23 @@ picodata_ProcessingUnit picopr_newPreprocUnit(picoos_MemoryManager mm, picoos_Co
     return this;
 }
 
+pico_status_t picopr_getMemStats(picodata_ProcessingUnit this,
+        picoos_int32 * maxWorkMemTop, picoos_int32 * maxDynMemSize,
+        picoos_int32 * workMemSize, picoos_int32 * dynMemSize)
+{
+    pr_subobj_t * pr;
+
+    if ((NULL == this) || (NULL == this->subObj)) {
+        return PICO_ERR_NULLPTR_ACCESS;
+    }
+    pr = (pr_subobj_t *) this->subObj;
+    *maxWorkMemTop = pr->maxWorkMemTop;
+    *maxDynMemSize = pr->maxDynMemSize;
+    *workMemSize = pr->nrWorkMemChunks * PR_WORK_MEM_SIZE;
+    *dynMemSize = pr->nrDynMemChunks * PR_DYN_MEM_SIZE;
+    return PICO_OK;
+}
+
 /**
  * fill up internal buffer
  */
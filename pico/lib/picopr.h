@@ -53,6 +53,16 @@ picodata_ProcessingUnit picopr_newPreprocUnit(
         picodata_CharBuffer cbOut,
         picorsrc_Voice voice);
 
+/**
+ * Returns the memory statistics of the preprocessing unit: the high-water
+ * marks of its working and dynamic memory partitions since the last full
+ * reset, and the current sizes of the partitions, which grow on demand up to
+ * PR_WORK_MEM_MAX_SIZE and PR_DYN_MEM_MAX_SIZE (all in bytes)
+ */
+pico_status_t picopr_getMemStats(picodata_ProcessingUnit this,
+        picoos_int32 * maxWorkMemTop, picoos_int32 * maxDynMemSize,
+        picoos_int32 * workMemSize, picoos_int32 * dynMemSize);
+
 #define PICOPR_OUTBUF_SIZE 256
 
 #ifdef __cplusplus
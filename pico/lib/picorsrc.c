@@ -66,8 +66,13 @@ typedef struct picorsrc_resource {
     picoos_int8 lockCount;  /* count of current subscribers of this resource */
     picoos_File file;
     picoos_uint8 * raw_mem; /* pointer to allocated memory. NULL if preallocated. */
+    picoos_uint8 * map; /* mapped in-place file, NULL if not mapped */
+    picoos_uint32 mapLen;
     /* picoos_uint32 size; */
+    picoos_uint32 headerLen; /* length of the file header */
+    picoos_uint32 len; /* length of content */
     picoos_uint8 * start; /* start of content (after header) */
+    picoos_uint8 * image; /* section directory of an in-place file, NULL if none */
     picoknow_KnowledgeBase kbList;
 } picorsrc_resource_t;
 
@@ -104,7 +109,12 @@ static picorsrc_Resource picorsrc_newResource(picoos_MemoryManager mm)
         this->lockCount = 0;
         this->file = NULL;
         this->raw_mem = NULL;
+        this->map = NULL;
+        this->mapLen = 0;
+        this->headerLen = 0;
+        this->len = 0;
         this->start = NULL;
+        this->image = NULL;
         this->kbList = NULL;
         /* this->size=0; */
     }
@@ -121,6 +131,7 @@ static void picorsrc_disposeResource(picoos_MemoryManager mm, picorsrc_Resource
         if ((*this)->raw_mem != NULL) {
             picoos_deallocProtMem(mm, (void *) &(*this)->raw_mem);
         }
+        picoos_UnmapBinary(&(*this)->map, (*this)->mapLen);
         picoos_deallocate(mm,(void * *)this);
     }
 }
@@ -137,6 +148,7 @@ static void picorsrc_initializeVoice(picorsrc_Voice this)
           this->kbArray[i] = NULL;
         }
         this->numResources = 0;
+        this->units = PICORSRC_UNITS_ALL;
         this->next = NULL;
     }
 }
@@ -170,6 +182,10 @@ typedef struct picorsrc_voice_definition {
     picoos_char voiceName[PICO_MAX_VOICE_NAME_SIZE];
     picoos_uint8 numResources;
     picorsrc_resource_name_t resourceName[PICO_MAX_NUM_RSRC_PER_VOICE];
+    picoos_uint8 pdfExpansion; /* PICORSRC_PDF_EXPAND_* */
+    picoos_uint8 units; /* PICORSRC_UNITS_* */
+    picoos_uint32 prWorkMemMax; /* 0: default */
+    picoos_uint32 prDynMemMax;
     picorsrc_VoiceDefinition next;
 } picorsrc_voice_definition_t;
 
@@ -182,6 +198,10 @@ static picorsrc_VoiceDefinition picorsrc_newVoiceDefinition(picoos_MemoryManager
         /* initialize */
         this->voiceName[0] = NULLC;
         this->numResources = 0;
+        this->pdfExpansion = PICORSRC_PDF_EXPAND_NONE;
+        this->units = PICORSRC_UNITS_ALL;
+        this->prWorkMemMax = 0;
+        this->prDynMemMax = 0;
         /*
         for (i=0; i < PICO_MAX_NUM_RSRC_PER_VOICE; i++) {
             this->resourceName[i][0] = NULLC;
@@ -279,12 +299,17 @@ static picoos_uint8 isResourceLoaded(picorsrc_ResourceManager this, picoos_char
     }
  }
 
-static pico_status_t parse_resource_name(picoos_char * fileName)
+static pico_status_t parse_resource_name(picoos_char * fileName, picoos_bool * inplace)
 {
     PICODBG_DEBUG(("analysing file name %s",fileName));
+    *inplace = FALSE;
     if (picoos_has_extension(fileName,
             (picoos_char *)PICO_BIN_EXTENSION)) {
         return PICO_OK;
+    } else if (picoos_has_extension(fileName,
+            (picoos_char *)PICO_INPLACE_EXTENSION)) {
+        *inplace = TRUE;
+        return PICO_OK;
     } else {
         return PICO_EXC_UNEXPECTED_FILE_TYPE;
     }
@@ -338,6 +363,7 @@ static pico_status_t picorsrc_createKnowledgeBase(
         picorsrc_ResourceManager this,
         picoos_uint8 * data,
         picoos_uint32 size,
+        picoos_uint8 * image,
         picoknow_kb_id_t kbid,
         picoknow_KnowledgeBase * kb)
 {
@@ -348,6 +374,7 @@ static pico_status_t picorsrc_createKnowledgeBase(
     (*kb)->base = data;
     (*kb)->size = size;
     (*kb)->id = kbid;
+    (*kb)->image = image;
     switch (kbid) {
         case PICOKNOW_KBID_TPP_MAIN:
         case PICOKNOW_KBID_TPP_USER_1:
@@ -471,6 +498,7 @@ static pico_status_t picorsrc_releaseKnowledgeBase(
 static pico_status_t picorsrc_getKbList(picorsrc_ResourceManager this,
         picoos_uint8 * data,
         picoos_uint32 datalen,
+        picoos_uint8 * image,
         picoknow_KnowledgeBase * kbList)
 {
 
@@ -508,9 +536,9 @@ static pico_status_t picorsrc_getKbList(picorsrc_ResourceManager this,
                 /* currently we consider a kb mentioned in resource but with offset 0 (no knowledge) as
                  * different form a kb not mentioned at all. We might reconsider that later. */
                 PICODBG_DEBUG((" kb (id %i) is mentioned but empty (base:%i, size:%i)",kb->id, kb->base, kb->size));
-                status = picorsrc_createKnowledgeBase(this, NULL, size, (picoknow_kb_id_t)kbid, &kb);
+                status = picorsrc_createKnowledgeBase(this, NULL, size, image, (picoknow_kb_id_t)kbid, &kb);
             } else {
-                status = picorsrc_createKnowledgeBase(this, data+offset, size, (picoknow_kb_id_t)kbid, &kb);
+                status = picorsrc_createKnowledgeBase(this, data+offset, size, image, (picoknow_kb_id_t)kbid, &kb);
             }
             PICODBG_DEBUG(("found kb (id %i) starting at %i with size %i",kb->id, kb->base, kb->size));
             if (PICO_OK == status) {
@@ -530,16 +558,92 @@ static pico_status_t picorsrc_getKbList(picorsrc_ResourceManager this,
 
 }
 
+/* checks the section directory of an in-place file; 'dirLen' is the number
+ * of bytes from the start of the directory to the end of the file */
+static picoos_bool checkImage(picoos_uint8 * image, picoos_uint32 dirLen)
+{
+    picoos_uint32 * dir = (picoos_uint32 *) image;
+    picoos_uint32 i, n, offset, size;
+
+    if ((dirLen < PICOKNOW_IMAGE_DIR_HEAD_SIZE) || (dir[0] != PICOKNOW_IMAGE_MAGIC)) {
+        return FALSE;
+    }
+    n = dir[1];
+    if (n > (dirLen - PICOKNOW_IMAGE_DIR_HEAD_SIZE) / PICOKNOW_IMAGE_DIR_ENTRY_SIZE) {
+        return FALSE;
+    }
+    for (i = 0; i < n; i++) {
+        offset = dir[2 + 4*i + 2];
+        size = dir[2 + 4*i + 3];
+        if ((offset % PICOKNOW_IMAGE_ALIGN != 0) || (offset > dirLen) || (size > dirLen - offset)) {
+            return FALSE;
+        }
+    }
+    return TRUE;
+}
+
+/* makes the content of the in-place file 'res->file' accessible, starting at
+ * file position 'dataOffset': the file is mapped if the platform allows, else
+ * the rest of the file is read into allocated memory. the section directory
+ * at file position 'secOffset' is validated; if it is not valid, the
+ * knowledge bases compute their structures at load time as from a .bin file */
+static pico_status_t readInplaceContent(picorsrc_ResourceManager this, picorsrc_Resource res,
+        picoos_uint32 dataOffset, picoos_uint32 secOffset)
+{
+    picoos_uint32 fileLen, n;
+    picoos_uint8 rem;
+
+    picoos_FileLength(res->file, &fileLen);
+    if ((dataOffset % PICOKNOW_IMAGE_ALIGN != 0) || (secOffset % PICOKNOW_IMAGE_ALIGN != 0)
+        || (dataOffset < res->headerLen + 3 * 4) || (dataOffset > secOffset)
+        || (res->len > secOffset - dataOffset) || (secOffset > fileLen)) {
+        return picoos_emRaiseException(this->common->em, PICO_EXC_FILE_CORRUPT,
+                NULL, (picoos_char *)"in-place file layout");
+    }
+    if (picoos_MapBinary(res->file, &res->map, &res->mapLen)) {
+        res->start = res->map + dataOffset;
+    } else {
+        res->raw_mem = picoos_allocProtMem(this->common->mm, fileLen - dataOffset + PICOKNOW_IMAGE_ALIGN);
+        if (NULL == res->raw_mem) {
+            return PICO_EXC_OUT_OF_MEM;
+        }
+        rem = (uintptr_t) res->raw_mem % PICOKNOW_IMAGE_ALIGN;
+        if (rem > 0) {
+            res->start = res->raw_mem + (PICOKNOW_IMAGE_ALIGN - rem);
+        } else {
+            res->start = res->raw_mem;
+        }
+        n = fileLen - dataOffset;
+        if (!picoos_SetPos(res->file, dataOffset)
+            || !picoos_ReadBytes(res->file, res->start, &n) || (n != fileLen - dataOffset)) {
+            return PICO_ERR_OTHER;
+        }
+        picoos_protectMem(this->common->mm, res->start, n, /*enable*/TRUE);
+    }
+    res->image = res->start + (secOffset - dataOffset);
+    if (!checkImage(res->image, fileLen - secOffset)) {
+        PICODBG_WARN(("invalid section directory, structures are computed"));
+        picoos_emRaiseWarning(this->common->em, PICO_WARN_FALLBACK, NULL,
+                (picoos_char *)"section directory ignored");
+        res->image = NULL;
+    }
+    return PICO_OK;
+}
+
 /* load resource file. the type of resource file etc. are in the header,
- * then follows the directory, then the knowledge bases themselves (as byte streams) */
+ * then follows the directory, then the knowledge bases themselves (as byte streams).
+ * an in-place file (PICO_INPLACE_EXTENSION) has the same header, followed by
+ * the content length, the file positions of the (aligned) content and of the
+ * section directory, see picorsrc_writeInplaceResource */
 
 pico_status_t picorsrc_loadResource(picorsrc_ResourceManager this,
         picoos_char * fileName, picorsrc_Resource * resource)
 {
     picorsrc_Resource res;
-    picoos_uint32 headerlen, len,maxlen;
+    picoos_uint32 headerlen, len,maxlen, dataOffset, secOffset;
     picoos_file_header_t header;
     picoos_uint8 rem;
+    picoos_bool inplace;
     pico_status_t status = PICO_OK;
 
     if (resource == NULL) {
@@ -561,7 +665,7 @@ pico_status_t picorsrc_loadResource(picorsrc_ResourceManager this,
 
     /* ***************** parse file name for file type and parameters */
 
-    if (PICO_OK != parse_resource_name(fileName)) {
+    if (PICO_OK != parse_resource_name(fileName, &inplace)) {
         picoos_deallocate(this->common->mm, (void *) &res);
         return PICO_EXC_UNEXPECTED_FILE_TYPE;
     }
@@ -594,28 +698,42 @@ pico_status_t picorsrc_loadResource(picorsrc_ResourceManager this,
             /* get data length */
         status = picoos_read_pi_uint32(res->file, &len);
         PICODBG_DEBUG(("found net resource len of %i",len));
-        /* allocate memory */
-        if (PICO_OK == status) {
-            PICODBG_TRACE((">>> 2"));
-            maxlen = len + PICOOS_ALIGN_SIZE; /* once would be sufficient? */
-            res->raw_mem = picoos_allocProtMem(this->common->mm, maxlen);
-            /* res->size = maxlen; */
-            status = (NULL == res->raw_mem) ? PICO_EXC_OUT_OF_MEM : PICO_OK;
-        }
-        if (PICO_OK == status) {
-            rem = (uintptr_t) res->raw_mem % PICOOS_ALIGN_SIZE;
-            if (rem > 0) {
-                res->start = res->raw_mem + (PICOOS_ALIGN_SIZE - rem);
-            } else {
-                res->start = res->raw_mem;
+        res->headerLen = headerlen;
+        res->len = len;
+        if (inplace) {
+            if (PICO_OK == status) {
+                status = picoos_read_pi_uint32(res->file, &dataOffset);
             }
+            if (PICO_OK == status) {
+                status = picoos_read_pi_uint32(res->file, &secOffset);
+            }
+            if (PICO_OK == status) {
+                status = readInplaceContent(this, res, dataOffset, secOffset);
+            }
+        } else {
+            /* allocate memory */
+            if (PICO_OK == status) {
+                PICODBG_TRACE((">>> 2"));
+                maxlen = len + PICOOS_ALIGN_SIZE; /* once would be sufficient? */
+                res->raw_mem = picoos_allocProtMem(this->common->mm, maxlen);
+                /* res->size = maxlen; */
+                status = (NULL == res->raw_mem) ? PICO_EXC_OUT_OF_MEM : PICO_OK;
+            }
+            if (PICO_OK == status) {
+                rem = (uintptr_t) res->raw_mem % PICOOS_ALIGN_SIZE;
+                if (rem > 0) {
+                    res->start = res->raw_mem + (PICOOS_ALIGN_SIZE - rem);
+                } else {
+                    res->start = res->raw_mem;
+                }
 
-            /* read file contents into memory */
-            status = (picoos_ReadBytes(res->file, res->start, &len)) ? PICO_OK
-                    : PICO_ERR_OTHER;
-            /* resources are read-only; the following write protection
-             has an effect in test configurations only */
-            picoos_protectMem(this->common->mm, res->start, len, /*enable*/TRUE);
+                /* read file contents into memory */
+                status = (picoos_ReadBytes(res->file, res->start, &len)) ? PICO_OK
+                        : PICO_ERR_OTHER;
+                /* resources are read-only; the following write protection
+                 has an effect in test configurations only */
+                picoos_protectMem(this->common->mm, res->start, len, /*enable*/TRUE);
+            }
         }
         /* note resource unique name */
         if (PICO_OK == status) {
@@ -649,7 +767,7 @@ pico_status_t picorsrc_loadResource(picorsrc_ResourceManager this,
 
         if (PICO_OK == status) {
             /* create kb list from resource */
-            status = picorsrc_getKbList(this, res->start, len, &res->kbList);
+            status = picorsrc_getKbList(this, res->start, len, res->image, &res->kbList);
         }
     }
 
@@ -707,6 +825,7 @@ pico_status_t picorsrc_unloadResource(picorsrc_ResourceManager this, picorsrc_Re
         picoos_deallocProtMem(this->common->mm, (void *) &rsrc->raw_mem);
         PICODBG_DEBUG(("deallocated raw mem"));
     }
+    picoos_UnmapBinary(&rsrc->map, rsrc->mapLen);
 
     r1 = NULL;
     r2 = this->resources;
@@ -734,6 +853,172 @@ pico_status_t picorsrc_unloadResource(picorsrc_ResourceManager this, picorsrc_Re
 }
 
 
+/* ******* writing in-place resource files **************************/
+
+#define INPLACE_ALIGN(x) ((((x) + PICOKNOW_IMAGE_ALIGN - 1) / PICOKNOW_IMAGE_ALIGN) * PICOKNOW_IMAGE_ALIGN)
+
+/* writes 'val' in native byte order or, if 'native' is FALSE, little-endian
+ * like the other numbers of the file header */
+static picoos_bool writeUint32(picoos_File f, picoos_uint32 val, picoos_bool native)
+{
+    picoos_uint8 by[4];
+    picoos_int32 n = 4;
+
+    if (native) {
+        picoos_mem_copy(&val, by, 4);
+    } else {
+        by[0] = (picoos_uint8) (val & 0xFF);
+        by[1] = (picoos_uint8) ((val >> 8) & 0xFF);
+        by[2] = (picoos_uint8) ((val >> 16) & 0xFF);
+        by[3] = (picoos_uint8) ((val >> 24) & 0xFF);
+    }
+    return picoos_WriteBytes(f, (picoos_char *) by, &n) && (4 == n);
+}
+
+static picoos_bool writePadding(picoos_File f, picoos_uint32 * pos, picoos_uint32 target)
+{
+    while (*pos < target) {
+        if (!picoos_WriteByte(f, 0)) {
+            return FALSE;
+        }
+        (*pos)++;
+    }
+    return TRUE;
+}
+
+/* steps to the next section of the kb list starting at '*kb', in the order of
+ * the list and of the section types; '*kb' and '*type' hold the position
+ * and must start with the first kb and PICOKNOW_SECTION_NULL. returns NULL
+ * when there are no more sections */
+static picoos_uint8 * nextSection(picoknow_KnowledgeBase * kb,
+        picoos_uint32 * type, picoos_uint32 * size)
+{
+    picoos_uint8 * p;
+
+    while (NULL != *kb) {
+        if ((NULL != (*kb)->subObj) && (NULL != (*kb)->subGetSection)) {
+            while (++(*type) < PICOKNOW_NUM_SECTION_TYPES) {
+                p = (*kb)->subGetSection(*kb, *type, size);
+                if (NULL != p) {
+                    return p;
+                }
+            }
+        }
+        *kb = (*kb)->next;
+        *type = PICOKNOW_SECTION_NULL;
+    }
+    return NULL;
+}
+
+pico_status_t picorsrc_writeInplaceResource(picorsrc_ResourceManager this,
+        picorsrc_Resource resource, picoos_char * fileName)
+{
+    picoos_File f = NULL;
+    picoknow_KnowledgeBase kb;
+    picoos_uint8 * p;
+    picoos_uint32 type, size, numSections, pos, n, dataOffset, secOffset, offset;
+    picoos_int32 wlen;
+    picoos_bool ok;
+
+    if ((NULL == this) || (NULL == resource) || (NULL == resource->file)) {
+        return PICO_ERR_NULLPTR_ACCESS;
+    }
+    if (!picoos_has_extension(fileName, (picoos_char *)PICO_INPLACE_EXTENSION)) {
+        return PICO_EXC_UNEXPECTED_FILE_TYPE;
+    }
+
+    /* count the sections */
+    numSections = 0;
+    kb = resource->kbList;
+    type = PICOKNOW_SECTION_NULL;
+    while (NULL != nextSection(&kb, &type, &size)) {
+        numSections++;
+    }
+    dataOffset = INPLACE_ALIGN(resource->headerLen + 3 * 4);
+    secOffset = INPLACE_ALIGN(dataOffset + resource->len);
+
+    if (!picoos_CreateBinary(this->common, &f, fileName)) {
+        return picoos_emRaiseException(this->common->em, PICO_EXC_CANT_OPEN_FILE,
+                NULL, (picoos_char *) "%s", fileName);
+    }
+
+    /* the header is copied from the source file */
+    ok = picoos_SetPos(resource->file, 0);
+    pos = 0;
+    while (ok && (pos < resource->headerLen)) {
+        n = resource->headerLen - pos;
+        if (n > sizeof(this->tmpHeader)) {
+            n = sizeof(this->tmpHeader);
+        }
+        wlen = n;
+        ok = picoos_ReadBytes(resource->file, (picoos_uint8 *) this->tmpHeader, &n)
+                && (n == (picoos_uint32) wlen)
+                && picoos_WriteBytes(f, this->tmpHeader, &wlen) && (wlen == (picoos_int32) n);
+        pos += n;
+    }
+    ok = ok && writeUint32(f, resource->len, FALSE)
+            && writeUint32(f, dataOffset, FALSE)
+            && writeUint32(f, secOffset, FALSE);
+    pos += 3 * 4;
+
+    /* content */
+    ok = ok && writePadding(f, &pos, dataOffset);
+    wlen = resource->len;
+    ok = ok && picoos_WriteBytes(f, (picoos_char *) resource->start, &wlen)
+            && (wlen == (picoos_int32) resource->len);
+    pos += resource->len;
+
+    /* section directory */
+    ok = ok && writePadding(f, &pos, secOffset)
+            && writeUint32(f, PICOKNOW_IMAGE_MAGIC, TRUE)
+            && writeUint32(f, numSections, TRUE);
+    offset = INPLACE_ALIGN(PICOKNOW_IMAGE_DIR_HEAD_SIZE + numSections * PICOKNOW_IMAGE_DIR_ENTRY_SIZE);
+    kb = resource->kbList;
+    type = PICOKNOW_SECTION_NULL;
+    while (ok && (NULL != nextSection(&kb, &type, &size))) {
+        ok = writeUint32(f, kb->id, TRUE) && writeUint32(f, type, TRUE)
+                && writeUint32(f, offset, TRUE) && writeUint32(f, size, TRUE);
+        offset = INPLACE_ALIGN(offset + size);
+    }
+    pos = PICOKNOW_IMAGE_DIR_HEAD_SIZE + numSections * PICOKNOW_IMAGE_DIR_ENTRY_SIZE;
+
+    /* sections */
+    kb = resource->kbList;
+    type = PICOKNOW_SECTION_NULL;
+    while (ok && (NULL != (p = nextSection(&kb, &type, &size)))) {
+        ok = writePadding(f, &pos, INPLACE_ALIGN(pos));
+        wlen = size;
+        ok = ok && picoos_WriteBytes(f, (picoos_char *) p, &wlen) && (wlen == (picoos_int32) size);
+        pos += size;
+    }
+
+    picoos_CloseBinary(this->common, &f);
+    if (!ok) {
+        return picoos_emRaiseException(this->common->em, PICO_ERR_OTHER,
+                NULL, (picoos_char *) "writing %s", fileName);
+    }
+    PICODBG_DEBUG(("wrote in-place resource %s with %i sections", fileName, numSections));
+    return PICO_OK;
+}
+
+
+pico_status_t picorsrc_compileFsts(picorsrc_ResourceManager this,
+        picorsrc_Resource resource)
+{
+    picoknow_KnowledgeBase kb;
+    pico_status_t status;
+
+    if ((NULL == this) || (NULL == resource)) {
+        return PICO_ERR_NULLPTR_ACCESS;
+    }
+    status = PICO_OK;
+    for (kb = resource->kbList; (PICO_OK == status) && (NULL != kb); kb = kb->next) {
+        status = picokfst_compileLookahead(kb, this->common);
+    }
+    return status;
+}
+
+
 pico_status_t picorsrc_createDefaultResource(picorsrc_ResourceManager this
         /*, picorsrc_Resource * resource */)
 {
@@ -760,7 +1045,7 @@ pico_status_t picorsrc_createDefaultResource(picorsrc_ResourceManager this
         PICODBG_ERROR(("failed assigning name %s to default resource",res->name));
         status = PICO_ERR_INDEX_OUT_OF_RANGE;
     }
-    status = picorsrc_createKnowledgeBase(this, NULL, 0, (picoknow_kb_id_t)PICOKNOW_KBID_FIXED_IDS, &res->kbList);
+    status = picorsrc_createKnowledgeBase(this, NULL, 0, NULL, (picoknow_kb_id_t)PICOKNOW_KBID_FIXED_IDS, &res->kbList);
 
     if (PICO_OK == status) {
         res->next = this->resources;
@@ -863,6 +1148,10 @@ pico_status_t picorsrc_createVoiceDefinition(picorsrc_ResourceManager this,
         this->freeVdefs = vdef->next;
         vdef->voiceName[0] = NULLC;
         vdef->numResources = 0;
+        vdef->pdfExpansion = PICORSRC_PDF_EXPAND_NONE;
+        vdef->units = PICORSRC_UNITS_ALL;
+        vdef->prWorkMemMax = 0;
+        vdef->prDynMemMax = 0;
         vdef->next = NULL;
     }
     if (NULL == vdef) {
@@ -885,6 +1174,67 @@ pico_status_t picorsrc_createVoiceDefinition(picorsrc_ResourceManager this,
 }
 
 
+pico_status_t picorsrc_setVoicePdfExpansion(picorsrc_ResourceManager this,
+        picoos_char * voiceName, picoos_uint8 level)
+{
+    picorsrc_VoiceDefinition vdef;
+
+    if (NULL == this) {
+        PICODBG_ERROR(("this is NULL"));
+        return PICO_ERR_NULLPTR_ACCESS;
+    }
+    if (level > PICORSRC_PDF_EXPAND_ALL) {
+        return PICO_ERR_INVALID_ARGUMENT;
+    }
+    if ((PICO_OK == findVoiceDefinition(this,voiceName,&vdef)) && (NULL != vdef)) {
+        vdef->pdfExpansion = level;
+        return PICO_OK;
+    } else {
+        return picoos_emRaiseException(this->common->em,PICO_EXC_NAME_UNDEFINED,NULL,(picoos_char *)"%s",voiceName);
+    }
+}
+
+
+pico_status_t picorsrc_setVoiceUnits(picorsrc_ResourceManager this,
+        picoos_char * voiceName, picoos_uint8 units)
+{
+    picorsrc_VoiceDefinition vdef;
+
+    if (NULL == this) {
+        PICODBG_ERROR(("this is NULL"));
+        return PICO_ERR_NULLPTR_ACCESS;
+    }
+    if (units > PICORSRC_UNITS_BACKEND) {
+        return PICO_ERR_INVALID_ARGUMENT;
+    }
+    if ((PICO_OK == findVoiceDefinition(this,voiceName,&vdef)) && (NULL != vdef)) {
+        vdef->units = units;
+        return PICO_OK;
+    } else {
+        return picoos_emRaiseException(this->common->em,PICO_EXC_NAME_UNDEFINED,NULL,(picoos_char *)"%s",voiceName);
+    }
+}
+
+
+pico_status_t picorsrc_setVoicePreprocMemLimit(picorsrc_ResourceManager this,
+        picoos_char * voiceName, picoos_uint32 workMemMax, picoos_uint32 dynMemMax)
+{
+    picorsrc_VoiceDefinition vdef;
+
+    if (NULL == this) {
+        PICODBG_ERROR(("this is NULL"));
+        return PICO_ERR_NULLPTR_ACCESS;
+    }
+    if ((PICO_OK == findVoiceDefinition(this,voiceName,&vdef)) && (NULL != vdef)) {
+        vdef->prWorkMemMax = workMemMax;
+        vdef->prDynMemMax = dynMemMax;
+        return PICO_OK;
+    } else {
+        return picoos_emRaiseException(this->common->em,PICO_EXC_NAME_UNDEFINED,NULL,(picoos_char *)"%s",voiceName);
+    }
+}
+
+
 pico_status_t picorsrc_releaseVoiceDefinition(picorsrc_ResourceManager this,
         picoos_char *voiceName)
 {
@@ -924,6 +1274,15 @@ pico_status_t picorsrc_releaseVoiceDefinition(picorsrc_ResourceManager this,
 /* ******* accessing voices **************************************/
 
 
+static void expandPdf(picorsrc_ResourceManager this, picoknow_KnowledgeBase kb)
+{
+    if ((NULL != kb) && (PICO_OK != picokpdf_expandPdfMUL(kb, this->common))) {
+        picoos_emRaiseWarning(this->common->em, PICO_WARN_FALLBACK, NULL,
+                (picoos_char *)"pdf of kb %i not expanded", kb->id);
+        PICODBG_WARN(("not enough memory to expand pdf of kb %i", kb->id));
+    }
+}
+
 /* create voice, given a voice name. the corresponding lock counts are incremented */
 
 pico_status_t picorsrc_createVoice(picorsrc_ResourceManager this, const picoos_char * voiceName, picorsrc_Voice * voice) {
@@ -998,6 +1357,18 @@ pico_status_t picorsrc_createVoice(picorsrc_ResourceManager this, const picoos_c
             }
         }
     } /* for */
+    (*voice)->units = vdef->units;
+    (*voice)->prWorkMemMax = vdef->prWorkMemMax;
+    (*voice)->prDynMemMax = vdef->prDynMemMax;
+
+    /* expand pdfs as requested by the voice definition; if memory is
+       short, the pdfs stay packed */
+    if (vdef->pdfExpansion >= PICORSRC_PDF_EXPAND_LFZ) {
+        expandPdf(this, (*voice)->kbArray[PICOKNOW_KBID_PDF_LFZ]);
+    }
+    if (vdef->pdfExpansion >= PICORSRC_PDF_EXPAND_ALL) {
+        expandPdf(this, (*voice)->kbArray[PICOKNOW_KBID_PDF_MGC]);
+    }
 
     return PICO_OK;
 }
@@ -1021,6 +1392,28 @@ pico_status_t picorsrc_releaseVoice(picorsrc_ResourceManager this, picorsrc_Voic
     return PICO_OK;
 }
 
+/* returns the resource providing knowledge base 'kbid' to the voice */
+
+picorsrc_Resource picorsrc_getVoiceKbResource(picorsrc_Voice voice, picoos_uint8 kbid)
+{
+    picoknow_KnowledgeBase kb;
+    picoos_uint8 i;
+
+    if ((NULL == voice) || (kbid >= PICORSRC_KB_ARRAY_SIZE) || (NULL == voice->kbArray[kbid])) {
+        return NULL;
+    }
+    for (i = 0; i < voice->numResources; i++) {
+        kb = voice->resourceArray[i]->kbList;
+        while ((NULL != kb) && (kb != voice->kbArray[kbid])) {
+            kb = kb->next;
+        }
+        if (NULL != kb) {
+            return voice->resourceArray[i];
+        }
+    }
+    return NULL;
+}
+
 #ifdef __cplusplus
 }
 #endif
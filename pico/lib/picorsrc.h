@@ -52,6 +52,16 @@ extern "C" {
 /* size of kb array of a voice */
 #define PICORSRC_KB_ARRAY_SIZE 64
 
+/* levels of pdf expansion of a voice, see picorsrc_setVoicePdfExpansion */
+#define PICORSRC_PDF_EXPAND_NONE 0 /* pdfs stay packed */
+#define PICORSRC_PDF_EXPAND_LFZ  1 /* pitch pdf is expanded */
+#define PICORSRC_PDF_EXPAND_ALL  2 /* pitch and spectrum pdfs are expanded */
+
+/* processing units of the engines of a voice, see picorsrc_setVoiceUnits */
+#define PICORSRC_UNITS_ALL      0 /* text to speech */
+#define PICORSRC_UNITS_FRONTEND 1 /* text to PAM output */
+#define PICORSRC_UNITS_BACKEND  2 /* PAM output to speech */
+
 typedef picoos_char picorsrc_resource_name_t[PICORSRC_MAX_RSRC_NAME_SIZ];
 
 typedef enum picorsrc_resource_type {
@@ -119,6 +129,27 @@ pico_status_t picorsrc_loadResource(picorsrc_ResourceManager this,
 /* unload resource file. (warn if resource file is busy) */
 pico_status_t picorsrc_unloadResource(picorsrc_ResourceManager this, picorsrc_Resource * rsrc);
 
+/**
+ * writes the loaded 'resource' as in-place file 'fileName' (which must have
+ * the extension PICO_INPLACE_EXTENSION): the file header and the content
+ * as in the source file, then the sections that the knowledge bases offer
+ * (see picoknow_section_type_t) with the structures they have computed at
+ * load time or at voice creation, so that loading the in-place file maps
+ * these instead of recomputing them. Content and sections are aligned to
+ * PICOKNOW_IMAGE_ALIGN; the sections are in native byte order and can only
+ * be used by builds of the same platform, other builds ignore them.
+ */
+pico_status_t picorsrc_writeInplaceResource(picorsrc_ResourceManager this,
+        picorsrc_Resource resource, picoos_char * fileName);
+
+/**
+ * builds the lookahead automata of the FSTs of the loaded 'resource' (see
+ * picokfst_compileLookahead), so that picorsrc_writeInplaceResource stores
+ * them with the in-place file.
+ */
+pico_status_t picorsrc_compileFsts(picorsrc_ResourceManager this,
+        picorsrc_Resource resource);
+
 
 pico_status_t picorsrc_createDefaultResource(picorsrc_ResourceManager this /*,
         picorsrc_Resource * resource */);
@@ -144,6 +175,24 @@ pico_status_t picorsrc_releaseVoiceDefinition(picorsrc_ResourceManager this,
 pico_status_t picorsrc_addResourceToVoiceDefinition(picorsrc_ResourceManager this,
         picoos_char * voiceName, picoos_char * resourceName);
 
+/* sets which mul pdfs of the voice's resources are expanded by
+   picokpdf_expandPdfMUL when the voice is created (PICORSRC_PDF_EXPAND_*).
+   Expanded pdfs are shared by all voices using the resource and stay
+   expanded until the resource is unloaded */
+pico_status_t picorsrc_setVoicePdfExpansion(picorsrc_ResourceManager this,
+        picoos_char * voiceName, picoos_uint8 level);
+
+/* sets which processing units the engines created for the voice run
+   (PICORSRC_UNITS_*, see picoctrl) */
+pico_status_t picorsrc_setVoiceUnits(picorsrc_ResourceManager this,
+        picoos_char * voiceName, picoos_uint8 units);
+
+/* sets the maximal sizes in bytes of the working and dynamic memory
+   partitions of the text preprocessing of the engines created for the
+   voice (0: the compile-time default, see picopr) */
+pico_status_t picorsrc_setVoicePreprocMemLimit(picorsrc_ResourceManager this,
+        picoos_char * voiceName, picoos_uint32 workMemMax, picoos_uint32 dynMemMax);
+
 /* **************************************************************************
  *
  *          voices
@@ -165,6 +214,10 @@ typedef struct picorsrc_voice {
 
     picorsrc_Resource resourceArray[PICO_MAX_NUM_RSRC_PER_VOICE];
 
+    picoos_uint8 units; /* copied from the voice definition */
+
+    picoos_uint32 prWorkMemMax; /* copied from the voice definition */
+    picoos_uint32 prDynMemMax;
 
 } picorsrc_voice_t;
 
@@ -176,6 +229,9 @@ pico_status_t picorsrc_createVoice(picorsrc_ResourceManager this, const picoos_c
 /* dispose voice. the corresponding lock counts are decremented. */
 pico_status_t picorsrc_releaseVoice(picorsrc_ResourceManager this, picorsrc_Voice * voice);
 
+/* returns the resource providing knowledge base 'kbid' to the voice, NULL if none */
+picorsrc_Resource picorsrc_getVoiceKbResource(picorsrc_Voice voice, picoos_uint8 kbid);
+
 #ifdef __cplusplus
 }
 #endif
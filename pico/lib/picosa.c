@@ -272,17 +272,20 @@ static pico_status_t saInitialize(register picodata_ProcessingUnit this, picoos_
     sa->cbuf1Len = 0;
     sa->cbuf2Len = 0;
 
-    /* init headx, cbuf1, cbuf2 */
-    for (i = 0; i < PICOSA_MAXNR_HEADX; i++){
-        sa->headx[i].head.type = 0;
-        sa->headx[i].head.info1 = PICODATA_ITEMINFO1_NA;
-        sa->headx[i].head.info2 = PICODATA_ITEMINFO2_NA;
-        sa->headx[i].head.len = 0;
-        sa->headx[i].cind = 0;
-    }
-    for (i = 0; i < PICOSA_MAXSIZE_CBUF; i++) {
-        sa->cbuf1[i] = 0;
-        sa->cbuf2[i] = 0;
+    /* init headx, cbuf1, cbuf2; not needed between utterances because only
+       the entries below headxLen and cbuf1Len/cbuf2Len are ever read */
+    if (resetMode != PICO_RESET_UTTERANCE) {
+        for (i = 0; i < PICOSA_MAXNR_HEADX; i++){
+            sa->headx[i].head.type = 0;
+            sa->headx[i].head.info1 = PICODATA_ITEMINFO1_NA;
+            sa->headx[i].head.info2 = PICODATA_ITEMINFO2_NA;
+            sa->headx[i].head.len = 0;
+            sa->headx[i].cind = 0;
+        }
+        for (i = 0; i < PICOSA_MAXSIZE_CBUF; i++) {
+            sa->cbuf1[i] = 0;
+            sa->cbuf2[i] = 0;
+        }
     }
 
 
@@ -294,7 +297,7 @@ static pico_status_t saInitialize(register picodata_ProcessingUnit this, picoos_
     sa->phonWritePos = 0;
     sa->nextReadPos = 0;
 
-    if (resetMode == PICO_RESET_SOFT) {
+    if (resetMode != PICO_RESET_FULL) {
         /*following initializations needed only at startup or after a full reset*/
         return PICO_OK;
     }
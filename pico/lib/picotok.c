@@ -85,6 +85,7 @@ extern "C" {
 #define MARKUP_HANDLING_DISABLED  0
 #define MARKUP_HANDLING_ENABLED 1
 #define EOL '\n'
+#define TOK_NR_ASCII_CHARS 128
 
 
 typedef picoos_int8 pico_tokenSubType;
@@ -240,6 +241,11 @@ typedef struct tok_subobj
 
     picoos_int32 nrEOL;
 
+    /* token type and subtype of each single-byte (ASCII) character, looked up
+       once per voice so that tok_treatChar needs no graph table search for them */
+    pico_tokenType asciiType[TOK_NR_ASCII_CHARS];
+    pico_tokenSubType asciiSubType[TOK_NR_ASCII_CHARS];
+
     picoos_bool markupHandlingMode;       /* to be moved ??? */
     picoos_bool aborted;                  /* to be moved ??? */
 
@@ -273,6 +279,7 @@ static void tok_treatMarkup (picodata_ProcessingUnit this, tok_subobj_t * tok);
 static void tok_putToMarkup (picodata_ProcessingUnit this, tok_subobj_t * tok, picoos_uchar str[]);
 static void tok_treatSimpleToken (picodata_ProcessingUnit this, tok_subobj_t * tok);
 static MarkupId tok_markupTagId (picoos_uchar tagId[]);
+static void tok_charClass (tok_subobj_t * tok, picoos_uchar utf[], picoos_int32 utfpos, pico_tokenType * type, pico_tokenSubType * subtype);
 
 /* *****************************************************************************/
 
@@ -1297,13 +1304,39 @@ static void tok_treatMarkup (picodata_ProcessingUnit this, tok_subobj_t * tok)
 
 
 
-static void tok_treatChar (picodata_ProcessingUnit this, tok_subobj_t * tok, picoos_uchar ch, picoos_bool markupHandling)
+/* determines token type and subtype of the complete UTF8 character 'utf' of length 'utfpos' */
+static void tok_charClass (tok_subobj_t * tok, picoos_uchar utf[], picoos_int32 utfpos, pico_tokenType * type, pico_tokenSubType * subtype)
 {
-    picoos_int32 i, id;
+    picoos_int32 id;
     picoos_uint8 uval8;
+    picoos_bool dummy;
+
+    (*type) = PICODATA_ITEMINFO1_TOKTYPE_UNDEFINED;
+    (*subtype) = -1;
+    id = picoktab_graphOffset(tok->graphTab, utf);
+    if (id > 0) {
+        if (picoktab_getIntPropTokenType(tok->graphTab, id, &uval8)) {
+            (*type) = (pico_tokenType)uval8;
+            if ((*type) == PICODATA_ITEMINFO1_TOKTYPE_LETTERV) {
+                (*type) = PICODATA_ITEMINFO1_TOKTYPE_LETTER;
+            }
+        }
+        dummy = picoktab_getIntPropTokenSubType(tok->graphTab, id, subtype);
+    } else if (utf[utfpos-1] <= (picoos_uchar)' ') {
+        (*type) = PICODATA_ITEMINFO1_TOKTYPE_SPACE;
+        (*subtype) =  -1;
+    } else {
+        (*type) = PICODATA_ITEMINFO1_TOKTYPE_UNDEFINED;
+        (*subtype) =  -1;
+    }
+}
+
+
+static void tok_treatChar (picodata_ProcessingUnit this, tok_subobj_t * tok, picoos_uchar ch, picoos_bool markupHandling)
+{
+    picoos_int32 i;
     pico_tokenType type = PICODATA_ITEMINFO1_TOKTYPE_UNDEFINED;
     pico_tokenSubType subtype = -1;
-    picoos_bool dummy;
     utf8char0c utf2;
     picoos_int32 utf2pos;
 
@@ -1321,21 +1354,11 @@ static void tok_treatChar (picodata_ProcessingUnit this, tok_subobj_t * tok, pic
             break;
         case UTF_CHAR_COMPLETE:
             markupHandling = (markupHandling && (tok->markupHandlingMode == MARKUP_HANDLING_ENABLED));
-            id = picoktab_graphOffset(tok->graphTab, tok->utf);
-            if (id > 0) {
-                if (picoktab_getIntPropTokenType(tok->graphTab, id, &uval8)) {
-                    type = (pico_tokenType)uval8;
-                    if (type == PICODATA_ITEMINFO1_TOKTYPE_LETTERV) {
-                        type = PICODATA_ITEMINFO1_TOKTYPE_LETTER;
-                    }
-                }
-                dummy = picoktab_getIntPropTokenSubType(tok->graphTab, id, &subtype);
-            } else if (tok->utf[tok->utfpos-1] <= (picoos_uchar)' ') {
-                type = PICODATA_ITEMINFO1_TOKTYPE_SPACE;
-                subtype =  -1;
+            if (tok->utfpos == 1) {
+                type = tok->asciiType[tok->utf[0]];
+                subtype = tok->asciiSubType[tok->utf[0]];
             } else {
-                type = PICODATA_ITEMINFO1_TOKTYPE_UNDEFINED;
-                subtype =  -1;
+                tok_charClass(tok, tok->utf, tok->utfpos, &type, &subtype);
             }
             if ((tok->utf[tok->utfpos-1] > (picoos_uchar)' ')) {
                 tok->nrEOL = 0;
@@ -1403,6 +1426,8 @@ static pico_status_t tokReset(register picodata_ProcessingUnit this, picoos_int3
 {
     tok_subobj_t * tok;
     MarkupId mId;
+    picoos_int32 ch;
+    utf8char0c utf;
 
     if (NULL == this || NULL == this->subObj) {
         return PICO_ERR_OTHER;
@@ -1449,6 +1474,14 @@ static pico_status_t tokReset(register picodata_ProcessingUnit this, picoos_int3
 
     tok->graphTab = picoktab_getGraphs(this->voice->kbArray[PICOKNOW_KBID_TAB_GRAPHS]);
 
+    if (resetMode == PICO_RESET_FULL) {
+        utf[1] = 0;
+        for (ch = 1; ch < TOK_NR_ASCII_CHARS; ch++) {
+            utf[0] = (picoos_uchar) ch;
+            tok_charClass(tok, utf, 1, &tok->asciiType[ch], &tok->asciiSubType[ch]);
+        }
+    }
+
     tok->xsampa_parser = picokfst_getFST(this->voice->kbArray[PICOKNOW_KBID_FST_XSAMPA_PARSE]);
     PICODBG_TRACE(("got xsampa_parser @ %i",tok->xsampa_parser));
 
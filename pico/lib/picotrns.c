@@ -435,6 +435,8 @@ static void NoteSolution (picoos_uint32 * nrSol, picotrns_printSolutionFct print
 static void StartTransduction (struct picotrns_transductionState * transductionState)
 {
     (*transductionState).phase = 0;
+    (*transductionState).nrSol = 0;
+    (*transductionState).recPos = 0;
 }
 
 
@@ -557,6 +559,149 @@ static void TransductionStep (picokfst_FST fst, struct picotrns_transductionStat
 
 
 
+/* Gets the alternative at the current position (FST state 'startState', input
+   position 'inPos') that leads to an FST state from which a solution can still
+   be reached; 'altDesc[i]' holds the lookahead state ('searchState') and the
+   input class ('inPos') of input position i. Of several such alternatives, the
+   first is taken if 'firstSolOnly', the last otherwise. The alternatives are
+   the same and in the same order as in 'GetNextAlternative'. */
+
+static void GetLookaheadAlternative (picokfst_FST fst, const picotrns_altDesc_t altDesc[],
+                                     const picotrns_possym_t inSeq[], picoos_uint16 inSeqLen,
+                                     picoos_bool firstSolOnly, picokfst_state_t startState, picoos_int32 inPos,
+                                     picokfst_symid_t * outSym, picoos_int32 * outRefPos,
+                                     picokfst_state_t * endFSTState, picoos_int32 * nextInPos, picoos_bool * found)
+{
+    const picokfst_symid_t * trans;
+    picoos_int32 i, nrTrans, laState;
+
+    (*found) = 0;
+    (*outSym) = PICOKFST_SYMID_ILLEG;
+    (*outRefPos) = PICOTRNS_POS_INVALID;
+    (*endFSTState) = 0;
+    (*nextInPos) = inPos;
+    if (inPos < inSeqLen) {
+        laState = altDesc[inPos+1].searchState;
+        if (inSeq[inPos].sym == PICOKFST_SYMID_EPS) {
+            if (picokfst_kfstLookaheadContains(fst, laState, startState)) {
+                (*found) = 1;
+                (*outSym) = PICOKFST_SYMID_EPS;
+                (*outRefPos) = inSeq[inPos].pos;
+                (*endFSTState) = startState;
+                (*nextInPos) = inPos + 1;
+            }
+        } else {
+            trans = picokfst_kfstGetClassTrans(fst, startState, altDesc[inPos].inPos, & nrTrans);
+            for (i = 0; (i < nrTrans) && !(firstSolOnly && (*found)); i++) {
+                if (picokfst_kfstLookaheadContains(fst, laState, trans[2*i+1])) {
+                    (*found) = 1;
+                    (*outSym) = trans[2*i];
+                    (*outRefPos) = inSeq[inPos].pos;
+                    (*endFSTState) = trans[2*i+1];
+                    (*nextInPos) = inPos + 1;
+                }
+            }
+        }
+    }
+    if (!(firstSolOnly && (*found))) {
+        laState = altDesc[inPos].searchState;
+        trans = picokfst_kfstGetClassTrans(fst, startState, PICOKFST_LACLASS_EPS, & nrTrans);
+        for (i = 0; (i < nrTrans) && !(firstSolOnly && (*found)); i++) {
+            if (picokfst_kfstLookaheadContains(fst, laState, trans[2*i+1])) {
+                (*found) = 1;
+                (*outSym) = trans[2*i];
+                (*outRefPos) = PICOTRNS_POS_INSERT;
+                (*endFSTState) = trans[2*i+1];
+                (*nextInPos) = inPos;
+            }
+        }
+    }
+}
+
+
+/* Performs the whole transduction without backtracking, using the lookahead
+   automaton of 'fst': a right-to-left pass stores the lookahead state and the
+   input class of every input position in 'altDesc'; the left-to-right pass
+   then follows the alternatives chosen by 'GetLookaheadAlternative'. This is
+   the path of the solution that the backtracking search returns: the first
+   solution it finds or, if not 'firstSolOnly', the last one. Returns FALSE
+   (with undefined output) if the backtracking search could not find that
+   solution within its recursion depth 'maxAltDescLen', or if 'altDesc' is
+   too short to hold the lookahead states. */
+
+static picoos_bool LookaheadTransduction (picokfst_FST fst, picotrns_altDesc_t altDesc[], picoos_uint16 maxAltDescLen,
+                                          picoos_bool firstSolOnly, picotrns_printSolutionFct printSolution,
+                                          const picotrns_possym_t inSeq[], picoos_uint16 inSeqLen,
+                                          picotrns_possym_t outSeq[], picoos_uint16 * outSeqLen, picoos_uint16 maxOutSeqLen,
+                                          picoos_uint32 * nrSteps)
+{
+    picoos_int32 i, inPos, nextInPos;
+    picoos_uint32 pathLen;
+    picokfst_state_t state, endFSTState;
+    picokfst_symid_t outSym;
+    picoos_int32 outRefPos;
+    picoos_bool found;
+
+    if (inSeqLen >= maxAltDescLen) {
+        return FALSE;
+    }
+    altDesc[inSeqLen].searchState = 0;
+    for (i = inSeqLen; i > 0; i--) {
+        altDesc[i-1].inPos = picokfst_kfstGetInputClass(fst, inSeq[i-1].sym);
+        altDesc[i-1].searchState = picokfst_kfstLookaheadStep(fst, altDesc[i].searchState, altDesc[i-1].inPos);
+    }
+    (*nrSteps) = inSeqLen;
+
+    if ((inSeqLen > 0) && !picokfst_kfstLookaheadContains(fst, altDesc[0].searchState, 1)) {
+        PICODBG_WARN(("--- no transduction solution found, using input as output\n"));
+        i = 0;
+        while ((i < inSeqLen) && (i < maxOutSeqLen)) {
+            outSeq[i].sym = inSeq[i].sym;
+            outSeq[i].pos = inSeq[i].pos;
+            i++;
+        }
+        (*outSeqLen) = i;
+        return TRUE;
+    }
+
+    /* the empty input is a solution by itself; the path ends when a
+       solution is reached (first solution) or when no solution follows (last one) */
+    pathLen = 0;
+    state = 1;
+    inPos = 0;
+    found = (inSeqLen > 0) || !firstSolOnly;
+    while (found) {
+        GetLookaheadAlternative(fst, altDesc, inSeq, inSeqLen, firstSolOnly, state, inPos,
+                                & outSym, & outRefPos, & endFSTState, & nextInPos, & found);
+        if (found) {
+            if (pathLen >= maxAltDescLen) {
+                return FALSE;
+            }
+            if (pathLen < maxOutSeqLen) {
+                outSeq[pathLen].sym = outSym;
+                outSeq[pathLen].pos = outRefPos;
+            }
+            pathLen++;
+            (*nrSteps)++;
+            state = endFSTState;
+            inPos = nextInPos;
+            if (firstSolOnly && (inPos == inSeqLen) && picokfst_kfstIsAcceptingState(fst, state)) {
+                found = FALSE;
+            }
+        }
+    }
+    if (pathLen > maxOutSeqLen) {
+        PICODBG_WARN(("**** output symbol array too small to hold full solution\n"));
+        pathLen = maxOutSeqLen;
+    }
+    (*outSeqLen) = pathLen;
+    if (printSolution != NULL) {
+        printSolution(outSeq,(*outSeqLen));
+    }
+    return TRUE;
+}
+
+
 /* see description in header */
 pico_status_t picotrns_transduce (picokfst_FST fst, picoos_bool firstSolOnly,
                                          picotrns_printSolutionFct printSolution,
@@ -582,6 +727,11 @@ pico_status_t picotrns_transduce (picokfst_FST fst, picoos_bool firstSolOnly,
         PICODBG_INFO_MSG((")\n"));
     }
 #endif
+    if (picokfst_kfstHasLookahead(fst)
+        && LookaheadTransduction(fst,altDescBuf,maxAltDescLen,firstSolOnly,printSolution,
+                                 inSeq,inSeqLen,outSeq,outSeqLen,maxOutSeqLen,nrSteps)) {
+        return PICO_OK;
+    }
    StartTransduction(&transductionState);
     finished = 0;
     *nrSteps = 0;
@@ -129,6 +129,8 @@ typedef void picotrns_printSolutionFct(const picotrns_possym_t outSeq[], const p
    @note if 'outSeq' or 'altDesc' are too small to hold a solution,
    an error occurs and the input is simply transfered to the output
    (up to maximum possible length)
+   @note if 'fst' has a lookahead automaton (see picokfst_kfstHasLookahead),
+   the same solution is found without backtracking
  */
 extern pico_status_t picotrns_transduce (picokfst_FST fst, picoos_bool firstSolOnly,
                                          picotrns_printSolutionFct printSolution,
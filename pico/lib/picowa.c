@@ -98,7 +98,7 @@ static pico_status_t waInitialize(register picodata_ProcessingUnit this, picoos_
     wa->outBufSize = PICOWA_MAXITEMSIZE;
     wa->outLen = 0;
 
-    if (resetMode == PICO_RESET_SOFT) {
+    if (resetMode != PICO_RESET_FULL) {
         /*following initializations needed only at startup or after a full reset*/
         return PICO_OK;
     }
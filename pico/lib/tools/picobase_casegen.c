@@ -0,0 +1,124 @@
+/**
+ * @file picobase_casegen.c
+ *
+ * Generates the case mapping tables of picobase.c from picobase_case.txt.
+ * Not part of the library build. To regenerate, run from pico/lib:
+ *
+ *   cc -o casegen tools/picobase_casegen.c
+ *   ./casegen tools/picobase_case.txt > case.inc
+ *
+ * and replace the lines from "#define BASE_CASE_NUM_BLOCKS" up to the end
+ * of base_case_delta in picobase.c with case.inc.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define BLOCK_SHIFT 6
+#define BLOCK_SIZE  (1 << BLOCK_SHIFT)
+#define MAX_CP      0x110000
+#define MAX_SHARED  256             /* block numbers are picoos_uint8 */
+
+static long delta[2][MAX_CP];       /* 0: lowercase, 1: uppercase */
+static long shared[MAX_SHARED * BLOCK_SIZE];
+static int numShared;
+static int *blockIndex[2];
+
+/* returns the number of the shared block equal to 'block', adding it if new */
+static int shareBlock(const long *block)
+{
+    int i;
+
+    for (i = 0; i < numShared; i++) {
+        if (memcmp(shared + i * BLOCK_SIZE, block, BLOCK_SIZE * sizeof(long)) == 0) {
+            return i;
+        }
+    }
+    if (numShared == MAX_SHARED) {
+        return -1;
+    }
+    memcpy(shared + numShared * BLOCK_SIZE, block, BLOCK_SIZE * sizeof(long));
+    return numShared++;
+}
+
+static void printIndex(const char *name, const int *index, int numBlocks)
+{
+    int i;
+
+    printf("static const picoos_uint8 %s[BASE_CASE_NUM_BLOCKS] = {\n", name);
+    for (i = 0; i < numBlocks; i++) {
+        printf("%s%3d%s", (i % 16 == 0) ? "    " : " ", index[i],
+               (i == numBlocks - 1) ? "\n" : ((i % 16 == 15) ? ",\n" : ","));
+    }
+    printf("};\n\n");
+}
+
+int main(int argc, char *argv[])
+{
+    FILE *f;
+    char line[128];
+    unsigned long cp, lc, uc;
+    unsigned long limit = 0;
+    int numBlocks, m, b, i;
+
+    if (argc != 2 || (f = fopen(argv[1], "r")) == NULL) {
+        fprintf(stderr, "usage: %s picobase_case.txt\n", argv[0]);
+        return 2;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (line[0] == '#' || line[0] == '\n') {
+            continue;
+        }
+        if (sscanf(line, "%lx %lx %lx", &cp, &lc, &uc) != 3
+            || cp >= MAX_CP || lc >= MAX_CP || uc >= MAX_CP) {
+            fprintf(stderr, "bad line: %s", line);
+            return 1;
+        }
+        delta[0][cp] = (long)lc - (long)cp;
+        delta[1][cp] = (long)uc - (long)cp;
+        if (delta[0][cp] < -32768 || delta[0][cp] > 32767
+            || delta[1][cp] < -32768 || delta[1][cp] > 32767) {
+            fprintf(stderr, "delta out of range: %s", line);
+            return 1;
+        }
+        if (cp + 1 > limit) {
+            limit = cp + 1;
+        }
+    }
+    fclose(f);
+
+    /* the tables end with the last block that holds a mapping */
+    numBlocks = (int)((limit + BLOCK_SIZE - 1) >> BLOCK_SHIFT);
+    for (m = 0; m < 2; m++) {
+        blockIndex[m] = (int *)malloc(numBlocks * sizeof(int));
+        if (blockIndex[m] == NULL) {
+            return 1;
+        }
+        for (b = 0; b < numBlocks; b++) {
+            blockIndex[m][b] = shareBlock(delta[m] + b * BLOCK_SIZE);
+            if (blockIndex[m][b] < 0) {
+                fprintf(stderr, "more than %d distinct blocks\n", MAX_SHARED);
+                return 1;
+            }
+        }
+    }
+
+    printf("#define BASE_CASE_NUM_BLOCKS  %d\n", numBlocks);
+    printf("#define BASE_CASE_LIMIT       (BASE_CASE_NUM_BLOCKS * BASE_CASE_BLOCK_SIZE)\n\n");
+    printIndex("base_lowercase_block", blockIndex[0], numBlocks);
+    printIndex("base_uppercase_block", blockIndex[1], numBlocks);
+    printf("static const picoos_int16 base_case_delta[%d * BASE_CASE_BLOCK_SIZE] = {\n", numShared);
+    for (i = 0; i < numShared * BLOCK_SIZE; i++) {
+        if (i % BLOCK_SIZE == 0) {
+            printf("    /* %d */\n", i / BLOCK_SIZE);
+        }
+        printf("%s%5ld%s", (i % 16 == 0) ? "    " : " ", shared[i],
+               (i == numShared * BLOCK_SIZE - 1) ? "\n" : ((i % 16 == 15) ? ",\n" : ","));
+    }
+    printf("};\n");
+
+    free(blockIndex[0]);
+    free(blockIndex[1]);
+    return 0;
+}
@@ -65,6 +65,87 @@ static char * path_join(const char *dir, const char *filename)
 	return buf;
 }
 
+// Lingware file prefix that holds the header and the content length: a
+// foreign header (PICO_MAX_FOREIGN_HEADER_LEN), the SVOX marker and header
+// length, the header string (PICOOS_MAX_HEADER_STRING_LEN) and the length
+#define LW_HEADER_SCAN (64 + 12 + 640 + 4)
+
+// True unless the in-place file 'inp' was converted from a different .bin
+// than 'bin'. An .inp starts with the header (name, version, ...) and the
+// content length of its .bin; in the .bin that length is followed by the
+// content up to the end of the file, which locates the end of the header.
+static bool inp_matches_bin(const char *inp, const char *bin)
+{
+	unsigned char hb[LW_HEADER_SCAN], hi[LW_HEADER_SCAN];
+	unsigned long len;
+	long size;
+	size_t nb, ni, h;
+	FILE *f;
+
+	f = fopen(bin, "rb");
+	if (!f)
+		return true;
+	nb = fread(hb, 1, sizeof(hb), f);
+	size = fseek(f, 0, SEEK_END) == 0 ? ftell(f) : -1;
+	fclose(f);
+	f = fopen(inp, "rb");
+	if (!f)
+		return false;
+	ni = fread(hi, 1, sizeof(hi), f);
+	fclose(f);
+
+	for (h = 0; h + 4 <= nb && h + 4 <= ni; h++) {
+		len = hb[h] | (unsigned long) hb[h + 1] << 8
+			| (unsigned long) hb[h + 2] << 16 | (unsigned long) hb[h + 3] << 24;
+		if (size >= 0 && len == (unsigned long) size - h - 4)
+			return memcmp(hb, hi, h + 4) == 0;
+	}
+	return false;
+}
+
+// Stores 'd_name' in 'bin' or 'inp' if it is a .bin or an in-place file
+// (.inp) of lingware kind 'kind' ("_ta", ...)
+static void match_file(char **bin, char **inp, const char *kind, const char *langdir, const char *d_name)
+{
+	char bin_ext[16], inp_ext[16];
+
+	snprintf(bin_ext, sizeof(bin_ext), "%s.bin", kind);
+	snprintf(inp_ext, sizeof(inp_ext), "%s.inp", kind);
+	if (!*inp && ends_with(inp_ext, d_name, true)) {
+		*inp = path_join(langdir, d_name);
+	}
+	else if (!*bin && ends_with(bin_ext, d_name, true)) {
+		*bin = path_join(langdir, d_name);
+	}
+}
+
+static void match_files(Lang_Filenames *fns, Lang_Filenames *inps, const char *langdir, const char *d_name)
+{
+	match_file(&fns->fname_ta, &inps->fname_ta, "_ta", langdir, d_name);
+	match_file(&fns->fname_sg, &inps->fname_sg, "_sg", langdir, d_name);
+	match_file(&fns->fname_utpp, &inps->fname_utpp, "_utpp", langdir, d_name);
+}
+
+// Takes the .inp 'inp' instead of the .bin in 'slot' unless it was
+// converted from another .bin, e.g. an older version of it
+static void pick_file(char **slot, char *inp)
+{
+	if (inp && (!*slot || inp_matches_bin(inp, *slot))) {
+		free(*slot);
+		*slot = inp;
+	}
+	else {
+		free(inp);
+	}
+}
+
+static void pick_files(Lang_Filenames *fns, Lang_Filenames *inps)
+{
+	pick_file(&fns->fname_ta, inps->fname_ta);
+	pick_file(&fns->fname_sg, inps->fname_sg);
+	pick_file(&fns->fname_utpp, inps->fname_utpp);
+}
+
 #ifdef _WIN32
 
 void lang_files_find(Lang_Filenames *fns, const char *langdir, const char *lang)
@@ -73,11 +154,13 @@ void lang_files_find(Lang_Filenames *fns, const char *langdir, const char *lang)
 	TCHAR szDir[MAX_PATH];
 	HANDLE hFind = INVALID_HANDLE_VALUE;
 	DWORD dwError = 0;
+	Lang_Filenames inps;
 	assert(fns);
 	assert(lang);
 	assert(langdir);
 
 	memset(fns, 0, sizeof(*fns));
+	memset(&inps, 0, sizeof(inps));
 	
 	// Prepare string for use with FindFile functions.  First, copy the
 	// string to a buffer, then append '\*' to the directory name.
@@ -105,26 +188,15 @@ void lang_files_find(Lang_Filenames *fns, const char *langdir, const char *lang)
 		if (starts_with(".", d_name, false))
 			continue;
 
-		// Did we find all the files already??
-		if (fns->fname_ta && fns->fname_sg && fns->fname_utpp)
-			break;
-
 		if (!starts_with(lang, d_name, true))
 			continue;
 
-		if (!fns->fname_ta && ends_with("_ta.bin", d_name, true)) {
-			fns->fname_ta = path_join(langdir, d_name);
-		}
-		else if (!fns->fname_sg && ends_with("_sg.bin", d_name, true)) {
-			fns->fname_sg = path_join(langdir, d_name);
-		}
-		else if (!fns->fname_utpp && ends_with("_utpp.bin", d_name, true)) {
-			fns->fname_utpp = path_join(langdir, d_name);
-		}
+		match_files(fns, &inps, langdir, d_name);
 
 	} while (FindNextFile(hFind, &ffd) != 0);
 
 	FindClose(hFind);
+	pick_files(fns, &inps);
 }
 
 #else
@@ -132,11 +204,13 @@ void lang_files_find(Lang_Filenames *fns, const char *langdir, const char *lang)
 void lang_files_find(Lang_Filenames *fns, const char *langdir, const char *lang)
 {
 	struct dirent *pentry = NULL;
+	Lang_Filenames inps;
 	assert(fns);
 	assert(lang);
 	assert(langdir);
 
 	memset(fns, 0, sizeof(*fns));
+	memset(&inps, 0, sizeof(inps));
 	DIR *dir = opendir(langdir);
 	if (!dir)
 		return;
@@ -147,25 +221,14 @@ void lang_files_find(Lang_Filenames *fns, const char *langdir, const char *lang)
 		if (starts_with(".", d_name, false))
 			continue;
 
-		// Did we find all the files already??
-		if (fns->fname_ta && fns->fname_sg && fns->fname_utpp)
-			break;
-
 		if (!starts_with(lang, d_name, true))
 			continue;
 
-		if (!fns->fname_ta && ends_with("_ta.bin", d_name, true)) {
-			fns->fname_ta = path_join(langdir, d_name);
-		}
-		else if (!fns->fname_sg && ends_with("_sg.bin", d_name, true)) {
-			fns->fname_sg = path_join(langdir, d_name);
-		}
-		else if (!fns->fname_utpp && ends_with("_utpp.bin", d_name, true)) {
-			fns->fname_utpp = path_join(langdir, d_name);
-		}
+		match_files(fns, &inps, langdir, d_name);
 	}
 
 	closedir(dir);
+	pick_files(fns, &inps);
 }
 #endif
 
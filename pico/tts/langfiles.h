@@ -11,6 +11,10 @@ typedef struct sLang_Filenames {
 	char *fname_utpp;
 } Lang_Filenames;
 
+// Finds the lingware files of 'lang' in 'lang_dir'. In-place files (.inp,
+// see picoinp) are preferred over the .bin files they were converted from;
+// an .inp whose header or content length differs from that of the .bin
+// next to it is stale and the .bin is taken instead.
 void lang_files_find(Lang_Filenames *fns, const char *lang_dir, const char *lang);
 
 void lang_files_release(Lang_Filenames *fns);
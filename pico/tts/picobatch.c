@@ -0,0 +1,83 @@
+#include "tts_batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [options] manifest\n"
+		"Renders every utterance of a TSV or JSONL manifest.\n\n"
+		"Options:\n"
+		"  -l dir      lingware directory (default /usr/share/pico/lang)\n"
+		"  -j threads  number of worker threads (default: number of CPUs)\n"
+		"  -o dir      write one file per utterance to dir (default .)\n"
+		"  -w          write WAV instead of raw 16 kHz 16-bit mono PCM\n"
+		"  -a archive  write all PCM to a single archive plus archive.idx\n"
+		"  -v          report every finished utterance\n", prog);
+}
+
+int main(int argc, char *argv[])
+{
+	TTS_BatchOptions opts;
+	TTS_Batch *batch;
+	int opt, failures;
+	long cpus;
+
+	memset(&opts, 0, sizeof(opts));
+	opts.lang_dir = "/usr/share/pico/lang";
+	opts.out_dir = ".";
+	cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	opts.num_threads = cpus > 0 ? (int) cpus : 1;
+
+	while ((opt = getopt(argc, argv, "l:j:o:wa:vh")) != -1) {
+		switch (opt) {
+		case 'l':
+			opts.lang_dir = optarg;
+			break;
+		case 'j':
+			opts.num_threads = atoi(optarg);
+			break;
+		case 'o':
+			opts.out_dir = optarg;
+			break;
+		case 'w':
+			opts.wav = true;
+			break;
+		case 'a':
+			opts.archive_path = optarg;
+			break;
+		case 'v':
+			opts.verbose = true;
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 2;
+		}
+	}
+	if (optind != argc - 1) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	batch = TtsBatch_Load(argv[optind]);
+	if (!batch) {
+		fprintf(stderr, "Cannot read manifest %s\n", argv[optind]);
+		return 1;
+	}
+
+	fprintf(stderr, "%d utterances, %d threads\n", batch->num_items, opts.num_threads);
+	failures = TtsBatch_Run(batch, &opts);
+	TtsBatch_Free(batch);
+
+	if (failures < 0) {
+		fprintf(stderr, "Batch could not be started\n");
+		return 1;
+	}
+	if (failures > 0) {
+		fprintf(stderr, "%d utterances failed\n", failures);
+		return 1;
+	}
+	return 0;
+}
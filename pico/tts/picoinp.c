@@ -0,0 +1,166 @@
+#include "picoapi.h"
+#include "picoextapi.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+// Converts lingware files (*_ta.bin, *_sg.bin, ...) into in-place files
+// (*.inp) that pico_loadResource maps instead of reading and that carry the
+// structures otherwise computed at load time, as well as the lookahead
+// automata that let the phonological FSTs transduce without backtracking.
+
+#define PICOINP_MEM_SIZE	(64 * 1024 * 1024)
+#define PICOINP_MAX_FILES	8
+#define PICOINP_VOICE		"PicoInpVoice"
+
+static void usage(const char *prog)
+{
+	fprintf(stderr,
+		"Usage: %s [options] file.bin...\n"
+		"Writes an in-place lingware file (.inp) for every lingware file.\n\n"
+		"Options:\n"
+		"  -o dir      write the .inp files to dir (default: next to each input)\n"
+		"  -x level    also store expanded pdfs: none (default), lfz or all;\n"
+		"              needs the _ta and _sg files of one voice as input\n", prog);
+}
+
+static char *inp_name(const char *bin, const char *out_dir)
+{
+	const char *base, *dot;
+	size_t dir_len, stem_len;
+	char *name;
+
+	base = strrchr(bin, '/');
+	base = base ? base + 1 : bin;
+	dot = strrchr(base, '.');
+	if (!dot || strcmp(dot, ".bin") != 0)
+		return NULL;
+	stem_len = (size_t) (dot - base);
+	dir_len = out_dir ? strlen(out_dir) + 1 : (size_t) (base - bin);
+	name = (char *) malloc(dir_len + stem_len + sizeof(".inp"));
+	if (!name)
+		return NULL;
+	if (out_dir) {
+		strcpy(name, out_dir);
+		strcat(name, "/");
+	} else {
+		memcpy(name, bin, dir_len);
+		name[dir_len] = '\0';
+	}
+	strncat(name, base, stem_len);
+	strcat(name, ".inp");
+	return name;
+}
+
+static void report(pico_System sys, const char *what, pico_Status status)
+{
+	pico_Retstring msg;
+
+	pico_getSystemStatusMessage(sys, status, msg);
+	fprintf(stderr, "%s: %s (%d)\n", what, msg, (int) status);
+}
+
+int main(int argc, char *argv[])
+{
+	const char *out_dir = NULL;
+	int level = PICOEXT_PDF_EXPAND_NONE;
+	pico_Resource res[PICOINP_MAX_FILES];
+	pico_Retstring res_name;
+	pico_System sys = NULL;
+	pico_Engine eng = NULL;
+	pico_Status status;
+	void *mem;
+	char *name;
+	int opt, i, num, failures = 0;
+
+	while ((opt = getopt(argc, argv, "o:x:h")) != -1) {
+		switch (opt) {
+		case 'o':
+			out_dir = optarg;
+			break;
+		case 'x':
+			if (strcmp(optarg, "none") == 0)
+				level = PICOEXT_PDF_EXPAND_NONE;
+			else if (strcmp(optarg, "lfz") == 0)
+				level = PICOEXT_PDF_EXPAND_LFZ;
+			else if (strcmp(optarg, "all") == 0)
+				level = PICOEXT_PDF_EXPAND_ALL;
+			else {
+				usage(argv[0]);
+				return 2;
+			}
+			break;
+		default:
+			usage(argv[0]);
+			return opt == 'h' ? 0 : 2;
+		}
+	}
+	num = argc - optind;
+	if (num < 1 || num > PICOINP_MAX_FILES) {
+		usage(argv[0]);
+		return 2;
+	}
+
+	mem = malloc(PICOINP_MEM_SIZE);
+	if (!mem || pico_initialize(mem, PICOINP_MEM_SIZE, &sys) != PICO_OK) {
+		fprintf(stderr, "cannot initialize pico\n");
+		free(mem);
+		return 1;
+	}
+
+	for (i = 0; i < num; i++) {
+		status = pico_loadResource(sys, (const pico_Char *) argv[optind + i], &res[i]);
+		if (status != PICO_OK) {
+			report(sys, argv[optind + i], status);
+			num = i;
+			failures++;
+			break;
+		}
+	}
+
+	// pdfs are expanded when an engine is created for a voice
+	if (!failures && level != PICOEXT_PDF_EXPAND_NONE) {
+		status = pico_createVoiceDefinition(sys, (const pico_Char *) PICOINP_VOICE);
+		for (i = 0; status == PICO_OK && i < num; i++) {
+			status = pico_getResourceName(sys, res[i], res_name);
+			if (status == PICO_OK)
+				status = pico_addResourceToVoiceDefinition(sys, (const pico_Char *) PICOINP_VOICE, (const pico_Char *) res_name);
+		}
+		if (status == PICO_OK)
+			status = picoext_setVoicePdfExpansion(sys, (const pico_Char *) PICOINP_VOICE, (pico_Int16) level);
+		if (status == PICO_OK)
+			status = pico_newEngine(sys, (const pico_Char *) PICOINP_VOICE, &eng);
+		if (status != PICO_OK) {
+			report(sys, "cannot expand pdfs", status);
+			failures++;
+		}
+	}
+
+	for (i = 0; !failures && i < num; i++) {
+		name = inp_name(argv[optind + i], out_dir);
+		if (!name) {
+			fprintf(stderr, "%s: not a .bin file\n", argv[optind + i]);
+			failures++;
+			continue;
+		}
+		status = picoext_compileResourceFsts(sys, res[i]);
+		if (status == PICO_OK)
+			status = picoext_writeInplaceResource(sys, res[i], (const pico_Char *) name);
+		if (status != PICO_OK) {
+			report(sys, name, status);
+			failures++;
+		} else {
+			printf("%s -> %s\n", argv[optind + i], name);
+		}
+		free(name);
+	}
+
+	if (eng)
+		pico_disposeEngine(sys, &eng);
+	for (i = num - 1; i >= 0; i--)
+		pico_unloadResource(sys, &res[i]);
+	pico_terminate(&sys);
+	free(mem);
+	return failures ? 1 : 0;
+}
@@ -0,0 +1,777 @@
+#include "tts_batch.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <ctype.h>
+#include <pthread.h>
+
+#define MAX_LINE_SIZE           (64 * 1024)
+#define MAX_ENGINES_PER_WORKER  4
+#define DEF_PROSODY             100
+
+#define SAMPLE_RATE             16000
+#define BITS_PER_SAMPLE         16
+#define WAV_HEADER_SIZE         44
+
+/* Per-worker deque of item indices [top, bottom). The owner pops from the
+   bottom, thieves steal from the top. */
+typedef struct work_deque {
+	pthread_mutex_t lock;
+	int *           slots;
+	int             top;
+	int             bottom;
+} work_deque_t;
+
+/* Shared archive output */
+typedef struct batch_archive {
+	pthread_mutex_t lock;
+	FILE *          data;
+	FILE *          index;
+	uint64_t        offset;
+} batch_archive_t;
+
+typedef struct sort_entry {
+	const char * language;
+	int          index;
+} sort_entry_t;
+
+typedef struct cached_engine {
+	char *       language;
+	TTS_Engine * engine;
+	unsigned     last_used;
+} cached_engine_t;
+
+typedef struct batch_worker {
+	const TTS_Batch *        batch;
+	const TTS_BatchOptions * opts;
+	work_deque_t *           deques;
+	int                      num_workers;
+	int                      self;
+	batch_archive_t *        archive;
+	cached_engine_t          engines[MAX_ENGINES_PER_WORKER];
+	unsigned                 clock;
+	int                      failures;
+} batch_worker_t;
+
+/* Destination of one utterance's PCM: a file or a memory buffer */
+typedef struct pcm_sink {
+	FILE *    fp;
+	uint8_t * mem;
+	size_t    len;
+	size_t    cap;
+	uint32_t  bytes;
+	bool      failed;
+} pcm_sink_t;
+
+static bool parse_tsv_line(char *line, TTS_BatchItem *item);
+static bool parse_json_line(const char *line, TTS_BatchItem *item);
+static bool parse_prosody(const char *spec, TTS_BatchItem *item);
+static const char *json_skip_ws(const char *p);
+static const char *json_parse_string(const char *p, char **out);
+static bool json_parse_hex4(const char *p, uint32_t *cp);
+static void item_release(TTS_BatchItem *item);
+static int compare_by_language(const void *a, const void *b);
+static bool deque_pop(work_deque_t *dq, int *index);
+static bool deque_steal(work_deque_t *dq, int *index);
+static void *worker_main(void *arg);
+static TTS_Engine *worker_engine(batch_worker_t *w, const char *language);
+static bool render_item(batch_worker_t *w, const TTS_BatchItem *item);
+static bool sink_callback(void *user, uint32_t rate, uint32_t format, int channels, uint8_t *audio, uint32_t audio_bytes, bool final);
+static void write_wav_header(FILE *fp, uint32_t data_bytes);
+static char *output_path(const char *dir, const char *id, const char *ext);
+
+TTS_Batch *TtsBatch_Load(const char *manifest_path)
+{
+	TTS_Batch *batch = NULL;
+	FILE *fp = NULL;
+	char *line = NULL;
+	char *p;
+	int line_no = 0;
+	bool ok;
+	TTS_BatchItem item;
+
+	assert(manifest_path);
+
+	fp = fopen(manifest_path, "rb");
+	if (!fp) {
+		return NULL;
+	}
+	batch = (TTS_Batch *) calloc(1, sizeof(TTS_Batch));
+	line = (char *) malloc(MAX_LINE_SIZE);
+	if (!batch || !line) {
+		goto fail;
+	}
+
+	while (fgets(line, MAX_LINE_SIZE, fp)) {
+		line_no++;
+		line[strcspn(line, "\r\n")] = '\0';
+		for (p = line; isspace((unsigned char) *p); p++) {
+		}
+		if (*p == '\0' || *p == '#') {
+			continue;
+		}
+
+		memset(&item, 0, sizeof(item));
+		item.rate = item.pitch = item.volume = DEF_PROSODY;
+		ok = (*p == '{') ? parse_json_line(p, &item) : parse_tsv_line(line, &item);
+		if (!ok) {
+			fprintf(stderr, "%s:%d: malformed manifest line skipped\n", manifest_path, line_no);
+			item_release(&item);
+			continue;
+		}
+
+		if (batch->num_items == batch->capacity) {
+			int capacity = batch->capacity ? 2 * batch->capacity : 256;
+			TTS_BatchItem *items = (TTS_BatchItem *) realloc(batch->items, capacity * sizeof(TTS_BatchItem));
+			if (!items) {
+				item_release(&item);
+				goto fail;
+			}
+			batch->items = items;
+			batch->capacity = capacity;
+		}
+		batch->items[batch->num_items++] = item;
+	}
+
+	free(line);
+	fclose(fp);
+	return batch;
+
+fail:
+	free(line);
+	fclose(fp);
+	TtsBatch_Free(batch);
+	return NULL;
+}
+
+int TtsBatch_Run(const TTS_Batch *batch, const TTS_BatchOptions *opts)
+{
+	batch_archive_t archive;
+	batch_worker_t *workers = NULL;
+	work_deque_t *deques = NULL;
+	pthread_t *threads = NULL;
+	int *order = NULL;
+	sort_entry_t *sorted = NULL;
+	int num_workers, num_deques = 0, started = 0, failures = -1;
+	int i, k, per_worker;
+	char *index_path = NULL;
+
+	assert(batch);
+	assert(opts);
+
+	if (!opts->lang_dir || (!opts->out_dir && !opts->archive_path)) {
+		return -1;
+	}
+	num_workers = opts->num_threads > 0 ? opts->num_threads : 1;
+	if (num_workers > batch->num_items && batch->num_items > 0) {
+		num_workers = batch->num_items;
+	}
+
+	memset(&archive, 0, sizeof(archive));
+	pthread_mutex_init(&archive.lock, NULL);
+	if (opts->archive_path) {
+		index_path = (char *) malloc(strlen(opts->archive_path) + 5);
+		if (!index_path) {
+			goto cleanup;
+		}
+		sprintf(index_path, "%s.idx", opts->archive_path);
+		archive.data = fopen(opts->archive_path, "wb");
+		archive.index = fopen(index_path, "w");
+		if (!archive.data || !archive.index) {
+			fprintf(stderr, "Cannot create archive %s\n", opts->archive_path);
+			goto cleanup;
+		}
+	}
+
+	/* Hand out utterances grouped by language so that workers rarely need a
+	   second engine; stealing rebalances whatever is left at the end. */
+	order = (int *) malloc((batch->num_items + 1) * sizeof(int));
+	sorted = (sort_entry_t *) malloc((batch->num_items + 1) * sizeof(sort_entry_t));
+	deques = (work_deque_t *) calloc(num_workers, sizeof(work_deque_t));
+	workers = (batch_worker_t *) calloc(num_workers, sizeof(batch_worker_t));
+	threads = (pthread_t *) calloc(num_workers, sizeof(pthread_t));
+	if (!order || !sorted || !deques || !workers || !threads) {
+		goto cleanup;
+	}
+	for (i = 0; i < batch->num_items; i++) {
+		sorted[i].language = batch->items[i].language;
+		sorted[i].index = i;
+	}
+	qsort(sorted, batch->num_items, sizeof(sort_entry_t), compare_by_language);
+	for (i = 0; i < batch->num_items; i++) {
+		order[i] = sorted[i].index;
+	}
+
+	per_worker = (batch->num_items + num_workers - 1) / num_workers;
+	for (i = 0, k = 0; i < num_workers; i++) {
+		int n = batch->num_items - k < per_worker ? batch->num_items - k : per_worker;
+		pthread_mutex_init(&deques[i].lock, NULL);
+		deques[i].slots = order + k;
+		deques[i].top = 0;
+		deques[i].bottom = n;
+		k += n;
+		num_deques++;
+	}
+
+	for (i = 0; i < num_workers; i++) {
+		workers[i].batch = batch;
+		workers[i].opts = opts;
+		workers[i].deques = deques;
+		workers[i].num_workers = num_workers;
+		workers[i].self = i;
+		workers[i].archive = &archive;
+	}
+	for (started = 0; started < num_workers; started++) {
+		if (pthread_create(&threads[started], NULL, worker_main, &workers[started]) != 0) {
+			break;
+		}
+	}
+	if (started == 0) {
+		goto cleanup;
+	}
+
+	failures = 0;
+	for (i = 0; i < started; i++) {
+		pthread_join(threads[i], NULL);
+		failures += workers[i].failures;
+	}
+	/* If not all workers could be started, the others stole their work. */
+
+cleanup:
+	for (i = 0; i < num_deques; i++) {
+		pthread_mutex_destroy(&deques[i].lock);
+	}
+	if (archive.data) {
+		fclose(archive.data);
+	}
+	if (archive.index) {
+		fclose(archive.index);
+	}
+	pthread_mutex_destroy(&archive.lock);
+	free(index_path);
+	free(threads);
+	free(workers);
+	free(deques);
+	free(sorted);
+	free(order);
+	return failures;
+}
+
+void TtsBatch_Free(TTS_Batch *batch)
+{
+	int i;
+
+	if (!batch) {
+		return;
+	}
+	for (i = 0; i < batch->num_items; i++) {
+		item_release(&batch->items[i]);
+	}
+	free(batch->items);
+	free(batch);
+}
+
+static void item_release(TTS_BatchItem *item)
+{
+	free(item->id);
+	free(item->language);
+	free(item->text);
+	item->id = item->language = item->text = NULL;
+}
+
+static bool parse_tsv_line(char *line, TTS_BatchItem *item)
+{
+	char *fields[4] = { NULL, NULL, NULL, NULL };
+	char *p = line;
+	int n = 0;
+
+	while (n < 4) {
+		fields[n++] = p;
+		p = strchr(p, '\t');
+		if (!p) {
+			break;
+		}
+		*p++ = '\0';
+	}
+	if (n < 3 || !*fields[0] || !*fields[1]) {
+		return false;
+	}
+
+	item->id = strdup(fields[0]);
+	item->language = strdup(fields[1]);
+	item->text = strdup(fields[2]);
+	if (!item->id || !item->language || !item->text) {
+		return false;
+	}
+	return (n < 4) || parse_prosody(fields[3], item);
+}
+
+static bool parse_json_line(const char *line, TTS_BatchItem *item)
+{
+	const char *p = json_skip_ws(line);
+	char *key = NULL, *value = NULL;
+	bool ok = false;
+
+	if (*p++ != '{') {
+		return false;
+	}
+	p = json_skip_ws(p);
+	if (*p == '}') {
+		return false;
+	}
+
+	for (;;) {
+		p = json_parse_string(json_skip_ws(p), &key);
+		if (!p) {
+			goto done;
+		}
+		p = json_skip_ws(p);
+		if (*p++ != ':') {
+			goto done;
+		}
+		p = json_skip_ws(p);
+		if (*p == '"') {
+			p = json_parse_string(p, &value);
+			if (!p) {
+				goto done;
+			}
+		} else {
+			/* bare numbers/literals are kept verbatim */
+			const char *start = p;
+			while (*p && *p != ',' && *p != '}' && !isspace((unsigned char) *p)) {
+				p++;
+			}
+			value = strndup(start, p - start);
+		}
+
+		if (!strcmp(key, "id")) {
+			free(item->id);
+			item->id = value;
+			value = NULL;
+		} else if (!strcmp(key, "language")) {
+			free(item->language);
+			item->language = value;
+			value = NULL;
+		} else if (!strcmp(key, "text")) {
+			free(item->text);
+			item->text = value;
+			value = NULL;
+		} else if (!strcmp(key, "prosody")) {
+			if (!parse_prosody(value, item)) {
+				goto done;
+			}
+		}
+		free(key);
+		free(value);
+		key = value = NULL;
+
+		p = json_skip_ws(p);
+		if (*p == ',') {
+			p++;
+			continue;
+		}
+		if (*p == '}') {
+			break;
+		}
+		goto done;
+	}
+	ok = item->id && *item->id && item->language && *item->language && item->text;
+
+done:
+	free(key);
+	free(value);
+	return ok;
+}
+
+static bool parse_prosody(const char *spec, TTS_BatchItem *item)
+{
+	const char *p = spec;
+	char *end;
+	long val;
+
+	while (*p) {
+		int *target;
+		if (!strncmp(p, "rate=", 5)) {
+			target = &item->rate;
+			p += 5;
+		} else if (!strncmp(p, "pitch=", 6)) {
+			target = &item->pitch;
+			p += 6;
+		} else if (!strncmp(p, "volume=", 7)) {
+			target = &item->volume;
+			p += 7;
+		} else {
+			return false;
+		}
+		val = strtol(p, &end, 10);
+		if (end == p) {
+			return false;
+		}
+		*target = (int) val;
+		p = end;
+		if (*p == ',') {
+			p++;
+		} else if (*p) {
+			return false;
+		}
+	}
+	return true;
+}
+
+static const char *json_skip_ws(const char *p)
+{
+	while (isspace((unsigned char) *p)) {
+		p++;
+	}
+	return p;
+}
+
+static size_t put_utf8(char *out, uint32_t cp)
+{
+	if (cp < 0x80) {
+		out[0] = (char) cp;
+		return 1;
+	} else if (cp < 0x800) {
+		out[0] = (char) (0xC0 | (cp >> 6));
+		out[1] = (char) (0x80 | (cp & 0x3F));
+		return 2;
+	} else if (cp < 0x10000) {
+		out[0] = (char) (0xE0 | (cp >> 12));
+		out[1] = (char) (0x80 | ((cp >> 6) & 0x3F));
+		out[2] = (char) (0x80 | (cp & 0x3F));
+		return 3;
+	}
+	out[0] = (char) (0xF0 | (cp >> 18));
+	out[1] = (char) (0x80 | ((cp >> 12) & 0x3F));
+	out[2] = (char) (0x80 | ((cp >> 6) & 0x3F));
+	out[3] = (char) (0x80 | (cp & 0x3F));
+	return 4;
+}
+
+/* Parses a JSON string literal at 'p' into a malloc'ed UTF-8 string;
+   returns the position after the closing quote or NULL on error. */
+static const char *json_parse_string(const char *p, char **out)
+{
+	char *buf, *q;
+	uint32_t cp, lo;
+
+	*out = NULL;
+	if (*p++ != '"') {
+		return NULL;
+	}
+	/* escapes never expand, so the input length is an upper bound */
+	buf = q = (char *) malloc(strlen(p) + 1);
+	if (!buf) {
+		return NULL;
+	}
+
+	while (*p && *p != '"') {
+		if (*p != '\\') {
+			*q++ = *p++;
+			continue;
+		}
+		p++;
+		switch (*p) {
+		case '"':  *q++ = '"';  break;
+		case '\\': *q++ = '\\'; break;
+		case '/':  *q++ = '/';  break;
+		case 'b':  *q++ = '\b'; break;
+		case 'f':  *q++ = '\f'; break;
+		case 'n':  *q++ = '\n'; break;
+		case 'r':  *q++ = '\r'; break;
+		case 't':  *q++ = '\t'; break;
+		case 'u':
+			/* NUL would cut the value short; surrogates must come in pairs */
+			if (!json_parse_hex4(p + 1, &cp) || cp == 0 || (cp >= 0xDC00 && cp < 0xE000)) {
+				goto fail;
+			}
+			p += 4;
+			if (cp >= 0xD800 && cp < 0xDC00) {
+				if (p[1] != '\\' || p[2] != 'u' || !json_parse_hex4(p + 3, &lo) || lo < 0xDC00 || lo >= 0xE000) {
+					goto fail;
+				}
+				cp = 0x10000 + ((cp - 0xD800) << 10) + (lo - 0xDC00);
+				p += 6;
+			}
+			q += put_utf8(q, cp);
+			break;
+		default:
+			goto fail;
+		}
+		p++;
+	}
+	if (*p != '"') {
+		goto fail;
+	}
+	*q = '\0';
+	*out = buf;
+	return p + 1;
+
+fail:
+	free(buf);
+	return NULL;
+}
+
+/* Parses the four hex digits of a \u escape; stops at the first other
+   character, so it never reads past the end of the string. */
+static bool json_parse_hex4(const char *p, uint32_t *cp)
+{
+	int i;
+
+	*cp = 0;
+	for (i = 0; i < 4; i++) {
+		if (!isxdigit((unsigned char) p[i])) {
+			return false;
+		}
+		*cp = (*cp << 4) | (uint32_t) (isdigit((unsigned char) p[i]) ? p[i] - '0' : (tolower((unsigned char) p[i]) - 'a' + 10));
+	}
+	return true;
+}
+
+static int compare_by_language(const void *a, const void *b)
+{
+	const sort_entry_t *ea = (const sort_entry_t *) a;
+	const sort_entry_t *eb = (const sort_entry_t *) b;
+	int c = strcmp(ea->language, eb->language);
+	return c ? c : ea->index - eb->index;
+}
+
+static bool deque_pop(work_deque_t *dq, int *index)
+{
+	bool found = false;
+
+	pthread_mutex_lock(&dq->lock);
+	if (dq->bottom > dq->top) {
+		*index = dq->slots[--dq->bottom];
+		found = true;
+	}
+	pthread_mutex_unlock(&dq->lock);
+	return found;
+}
+
+static bool deque_steal(work_deque_t *dq, int *index)
+{
+	bool found = false;
+
+	pthread_mutex_lock(&dq->lock);
+	if (dq->bottom > dq->top) {
+		*index = dq->slots[dq->top++];
+		found = true;
+	}
+	pthread_mutex_unlock(&dq->lock);
+	return found;
+}
+
+static void *worker_main(void *arg)
+{
+	batch_worker_t *w = (batch_worker_t *) arg;
+	const TTS_BatchItem *item;
+	int index, i, victim;
+	bool found;
+
+	for (;;) {
+		found = deque_pop(&w->deques[w->self], &index);
+		for (i = 1; !found && i < w->num_workers; i++) {
+			victim = (w->self + i) % w->num_workers;
+			found = deque_steal(&w->deques[victim], &index);
+		}
+		if (!found) {
+			break;
+		}
+
+		item = &w->batch->items[index];
+		if (!render_item(w, item)) {
+			fprintf(stderr, "%s: synthesis failed\n", item->id);
+			w->failures++;
+		} else if (w->opts->verbose) {
+			fprintf(stderr, "%s: done (worker %d)\n", item->id, w->self);
+		}
+	}
+
+	for (i = 0; i < MAX_ENGINES_PER_WORKER; i++) {
+		TtsEngine_Destroy(w->engines[i].engine);
+		free(w->engines[i].language);
+	}
+	return NULL;
+}
+
+/* Returns the worker's engine for 'language', creating it on first use and
+   evicting the least recently used one if the cache is full. */
+static TTS_Engine *worker_engine(batch_worker_t *w, const char *language)
+{
+	cached_engine_t *slot = &w->engines[0];
+	int i;
+
+	w->clock++;
+	for (i = 0; i < MAX_ENGINES_PER_WORKER; i++) {
+		if (w->engines[i].engine && !strcmp(w->engines[i].language, language)) {
+			w->engines[i].last_used = w->clock;
+			return w->engines[i].engine;
+		}
+		if (!w->engines[i].engine || w->engines[i].last_used < slot->last_used) {
+			slot = &w->engines[i];
+		}
+	}
+
+	TtsEngine_Destroy(slot->engine);
+	free(slot->language);
+	slot->engine = TtsEngine_Create(w->opts->lang_dir, language, sink_callback);
+	slot->language = slot->engine ? strdup(language) : NULL;
+	slot->last_used = w->clock;
+	if (!slot->engine) {
+		fprintf(stderr, "Cannot create engine for language %s\n", language);
+	}
+	return slot->engine;
+}
+
+static bool render_item(batch_worker_t *w, const TTS_BatchItem *item)
+{
+	const TTS_BatchOptions *opts = w->opts;
+	batch_archive_t *archive = w->archive;
+	TTS_Engine *engine;
+	pcm_sink_t sink;
+	char *path = NULL;
+	bool ok;
+
+	engine = worker_engine(w, item->language);
+	if (!engine) {
+		return false;
+	}
+	TtsEngine_SetRate(engine, item->rate);
+	TtsEngine_SetPitch(engine, item->pitch);
+	TtsEngine_SetVolume(engine, item->volume);
+
+	memset(&sink, 0, sizeof(sink));
+	if (!opts->archive_path) {
+		path = output_path(opts->out_dir, item->id, opts->wav ? ".wav" : ".raw");
+		sink.fp = path ? fopen(path, "wb") : NULL;
+		if (!sink.fp) {
+			fprintf(stderr, "Cannot create %s\n", path ? path : item->id);
+			free(path);
+			return false;
+		}
+		if (opts->wav) {
+			write_wav_header(sink.fp, 0);
+		}
+	}
+
+	ok = TtsEngine_Speak(engine, item->text, &sink) && !sink.failed;
+
+	if (sink.fp) {
+		if (ok && opts->wav) {
+			fseek(sink.fp, 0, SEEK_SET);
+			write_wav_header(sink.fp, sink.bytes);
+		}
+		ok = (fclose(sink.fp) == 0) && ok;
+		if (!ok) {
+			remove(path);
+		}
+	} else if (ok) {
+		pthread_mutex_lock(&archive->lock);
+		if (sink.len && fwrite(sink.mem, 1, sink.len, archive->data) != sink.len) {
+			ok = false;
+		} else {
+			fprintf(archive->index, "%s\t%llu\t%lu\n", item->id,
+					(unsigned long long) archive->offset, (unsigned long) sink.len);
+			archive->offset += sink.len;
+		}
+		pthread_mutex_unlock(&archive->lock);
+	}
+
+	free(sink.mem);
+	free(path);
+	return ok;
+}
+
+static bool sink_callback(void *user, uint32_t rate, uint32_t format, int channels, uint8_t *audio, uint32_t audio_bytes, bool final)
+{
+	pcm_sink_t *sink = (pcm_sink_t *) user;
+
+	(void) rate;
+	(void) format;
+	(void) channels;
+	(void) final;
+
+	if (!audio_bytes) {
+		return true;
+	}
+	if (sink->fp) {
+		if (fwrite(audio, 1, audio_bytes, sink->fp) != audio_bytes) {
+			sink->failed = true;
+			return false;
+		}
+	} else {
+		if (sink->len + audio_bytes > sink->cap) {
+			size_t cap = sink->cap ? 2 * sink->cap : 256 * 1024;
+			uint8_t *mem;
+			while (cap < sink->len + audio_bytes) {
+				cap *= 2;
+			}
+			mem = (uint8_t *) realloc(sink->mem, cap);
+			if (!mem) {
+				sink->failed = true;
+				return false;
+			}
+			sink->mem = mem;
+			sink->cap = cap;
+		}
+		memcpy(sink->mem + sink->len, audio, audio_bytes);
+		sink->len += audio_bytes;
+	}
+	sink->bytes += audio_bytes;
+	return true;
+}
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+	p[0] = (uint8_t) v;
+	p[1] = (uint8_t) (v >> 8);
+	p[2] = (uint8_t) (v >> 16);
+	p[3] = (uint8_t) (v >> 24);
+}
+
+static void put_le16(uint8_t *p, uint16_t v)
+{
+	p[0] = (uint8_t) v;
+	p[1] = (uint8_t) (v >> 8);
+}
+
+static void write_wav_header(FILE *fp, uint32_t data_bytes)
+{
+	uint8_t hdr[WAV_HEADER_SIZE];
+	const uint16_t block_align = BITS_PER_SAMPLE / 8;
+
+	memcpy(hdr, "RIFF", 4);
+	put_le32(hdr + 4, WAV_HEADER_SIZE - 8 + data_bytes);
+	memcpy(hdr + 8, "WAVEfmt ", 8);
+	put_le32(hdr + 16, 16);
+	put_le16(hdr + 20, 1);		/* PCM */
+	put_le16(hdr + 22, 1);		/* mono */
+	put_le32(hdr + 24, SAMPLE_RATE);
+	put_le32(hdr + 28, SAMPLE_RATE * block_align);
+	put_le16(hdr + 32, block_align);
+	put_le16(hdr + 34, BITS_PER_SAMPLE);
+	memcpy(hdr + 36, "data", 4);
+	put_le32(hdr + 40, data_bytes);
+	fwrite(hdr, 1, sizeof(hdr), fp);
+}
+
+/* <dir>/<id><ext>, with path separators in the id replaced */
+static char *output_path(const char *dir, const char *id, const char *ext)
+{
+	size_t len = strlen(dir) + strlen(id) + strlen(ext) + 2;
+	char *path = (char *) malloc(len);
+	char *p;
+
+	if (!path) {
+		return NULL;
+	}
+	snprintf(path, len, "%s/", dir);
+	p = path + strlen(path);
+	for (; *id; id++) {
+		*p++ = (*id == '/' || *id == '\\') ? '_' : *id;
+	}
+	strcpy(p, ext);
+	return path;
+}
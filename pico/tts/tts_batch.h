@@ -0,0 +1,64 @@
+#ifndef TTS_BATCH_H
+#define TTS_BATCH_H
+
+#include "tts_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Offline batch rendering of many prompts (POSIX threads only).
+//
+// A manifest lists one utterance per line, either tab separated:
+//     id <TAB> language <TAB> text [<TAB> prosody]
+// or as JSON Lines:
+//     {"id": "...", "language": "...", "text": "...", "prosody": "..."}
+// where the optional prosody is "rate=N,pitch=N,volume=N" (any subset).
+// Lines that are empty or start with '#' are ignored.
+//
+// Utterances are spread over worker threads with work-stealing deques. Every
+// worker keeps its engines (and thus the loaded lingware) alive across
+// utterances, so each language is loaded once per worker, not per prompt.
+
+typedef struct sTTS_BatchItem {
+	char *id;
+	char *language;
+	char *text;
+	int   rate;
+	int   pitch;
+	int   volume;
+} TTS_BatchItem;
+
+typedef struct sTTS_Batch {
+	TTS_BatchItem *items;
+	int            num_items;
+	int            capacity;
+} TTS_Batch;
+
+typedef struct sTTS_BatchOptions {
+	const char *lang_dir;
+	int         num_threads;
+	// Either write one file per utterance to 'out_dir' ...
+	const char *out_dir;
+	bool        wav;		// RIFF/WAVE files instead of raw PCM
+	// ... or append all PCM to 'archive_path' and its index to
+	// 'archive_path'.idx (id <TAB> byte offset <TAB> byte length).
+	const char *archive_path;
+	bool        verbose;
+} TTS_BatchOptions;
+
+// Parse a manifest; returns NULL if it cannot be read. Malformed lines are
+// reported on stderr and skipped.
+TTS_Batch *TtsBatch_Load(const char *manifest_path);
+
+// Render all items; returns the number of utterances that failed, or -1 if
+// the batch could not be started.
+int TtsBatch_Run(const TTS_Batch *batch, const TTS_BatchOptions *opts);
+
+void TtsBatch_Free(TTS_Batch *batch);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
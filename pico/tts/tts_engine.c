@@ -5,8 +5,20 @@
 #include <string.h>
 #include <picoapi.h>
 #include <picodefs.h>
+#include <picoextapi.h>
+#include <picopal.h>
 #include <assert.h>
 
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <time.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <sys/eventfd.h>
+#endif
+
 #if 0 // enable for debugging
 #define PICO_DBG(...) fprintf(stderr, __VA_ARGS__)
 #else
@@ -29,55 +41,208 @@
 
 #define MAX_OUTBUF_SIZE     128
 #define SYNTH_BUFFER_SIZE   (128 * 1024)
+#define PCM_RATE            16000
+#define PCM_DEPTH           16
+#define PCM_CHANNELS        1
+#define PCM_BYTES_PER_MS    (PCM_RATE * 2 / 1000)
+
+#define MAX_VOICES          PICO_MAX_NUM_ENGINES
+
+/* markup for the rate, pitch and volume of the engine */
+#define PROPERTY_TAGS_OPEN  "<speed level='%4d'><pitch level='%4d'><volume level='%4d'>"
+#define PROPERTY_TAGS_CLOSE "</volume></pitch></speed>"
+#define PROPERTY_TAGS_SIZE  256
+
+/* template prompts: marks around a slot and the crossfade at its edges */
+#define TEMPLATE_MARK_SIZE  32
+#define TEMPLATE_XFADE      80
 
 static const char * PICO_VOICE_NAME                = "PicoVoice";
 
-struct sTTS_Engine {
-	tts_callback_t  synth_callback;
-	void *          pico_mem_pool;
-	pico_System     pico_sys;
+/* One language: its lingware and the Pico engine running on it. All voices of
+   a TTS_Engine live in the same Pico system. */
+typedef struct {
+	char *          language;
+	char            name[PICO_MAX_VOICE_NAME_SIZE];
 	pico_Resource   pico_ta;
 	pico_Resource   pico_sg;
 	pico_Resource   pico_utpp;
 	pico_Engine     pico_engine;
-	char *  current_language;
+} tts_voice_t;
+
+/* Timing of the current utterance, followed through item taps on the SPHO
+   and the PAM. The words the SPHO has output are queued in word_phones[head..
+   tail) as a phone count followed by the phone ids, until the PAM outputs
+   their phones; the PAM adds pause phones, which match no word. Events wait
+   in events[] until the audio they refer to is passed on. */
+typedef struct {
+	uint8_t *       word_phones;
+	size_t          wp_head;
+	size_t          wp_tail;
+	size_t          wp_size;
+	size_t          wp_stage;	/* position of the count of the word being queued */
+	int             word_matched;	/* phones of the head word output by the PAM */
+	int             word;		/* index of the head word */
+	uint32_t        sample;		/* samples of the phones output by the PAM */
+	tts_event_t *   events;
+	size_t          ev_head;
+	size_t          ev_tail;
+	size_t          ev_size;
+	size_t          delivered;	/* bytes of audio passed on */
+} tts_timing_t;
+
+/* A template prompt: the static text with its slots rendered once, and the
+   settings it was rendered with. Slot i is heard in pcm[cuts[2i]..cuts[2i+1]). */
+struct sTTS_Template {
+	char *          text;		/* the pattern, split into parts and names */
+	int             num_slots;
+	const char **   parts;		/* num_slots + 1 static parts */
+	const char **   names;		/* placeholders of the slots */
+	int16_t *       pcm;
+	size_t          samples;
+	size_t *        cuts;
+	char *          language;
+	int             rate;
+	int             pitch;
+	int             volume;
+};
+
+/* PCM synthesized for a template, with the positions of its marks */
+typedef struct {
+	int16_t *       pcm;
+	size_t          samples;
+	size_t          size;
+	size_t *        marks;		/* 'a<i>' at marks[2i], 'b<i>' at marks[2i+1] */
+	int             num_slots;
+} tts_capture_t;
+
+/* pull session states */
+enum {
+	PULL_NONE,
+	PULL_RUNNING,
+	PULL_DONE,
+	PULL_ERROR
+};
+
+struct sTTS_Engine {
+	tts_callback_t  synth_callback;
+	void *          pico_mem_pool;
+	pico_System     pico_sys;
+	tts_voice_t     voices[MAX_VOICES];
+	int             num_voices;
+	tts_voice_t *   voice;		/* the selected voice */
 	char * languages_path;
 	uint8_t *synthesis_buffer;
 	int     current_rate;
 	int     current_pitch;
 	int     current_volume;
-	bool    synthesis_abort_flag;
+	picopal_atomic_t synthesis_abort_flag;	/* set by TtsEngine_Stop, possibly from another thread */
+	/* chunk policy of TtsEngine_Speak in bytes; 0 fills the whole buffer */
+	size_t  chunk_first;
+	size_t  chunk_size;
+	/* chunk being filled by TtsEngine_Speak or a streaming session */
+	uint8_t *chunk_buf;
+	size_t  chunk_used;
+	size_t  chunk_limit;
+	size_t  chunk_total;	/* bytes passed on in the utterance */
+	/* streaming session state */
+	bool    session_open;
+	void *  session_user;
+	bool    session_tags;	/* property tags were opened */
+	uint64_t session_flush_us;
+	uint64_t session_pending_us;	/* time since which text waits for its sentence end */
+	bool     session_at_word;	/* the last append ended at a word */
+	/* pull API state; PCM is queued in synthesis_buffer[pull_head..pull_tail) */
+	int     pull_state;
+	char *  pull_text;
+	const char *pull_inp;
+	size_t  pull_remaining;
+	bool    pull_feed;
+	size_t  pull_head;
+	size_t  pull_tail;
+	int     event_fd;
+	bool    event_signalled;
+	/* timing events */
+	tts_event_callback_t timing_callback;
+	void *  timing_user;
+	tts_timing_t timing;
 };
 
 /* Local helper functions */
 static bool is_readable(const char *filename);
-static bool load_language(TTS_Engine *engine, const char *lang);
+static bool load_language(TTS_Engine *engine, tts_voice_t *voice, const char *lang);
+static void unload_language(TTS_Engine *engine, tts_voice_t *voice);
 static const char *add_properties(TTS_Engine *engine, const char *text);
 static int clamp(int val, int min_val, int max_val);
+static bool has_properties(TTS_Engine *engine);
+static void chunk_start(TTS_Engine *engine);
+static void chunk_next(TTS_Engine *engine);
+static void chunk_pass_rest(TTS_Engine *engine, void *userdata);
+static bool chunk_put(TTS_Engine *engine, void *userdata, const void *pcm, size_t bytes);
+static pico_Status synth_drain(TTS_Engine *engine, void *userdata);
+static bool session_feed(TTS_Engine *engine, const char *text, size_t len);
+static void session_end(TTS_Engine *engine, bool completed);
+static char *template_text(const TTS_Template *tpl, int slot, const char *value);
+static bool template_render(TTS_Engine *engine, TTS_Template *tpl);
+static bool template_crossfade(TTS_Engine *engine, void *userdata, const int16_t *from, const int16_t *to, size_t n);
+static bool synth_capture(TTS_Engine *engine, const char *text, tts_capture_t *cap);
+static void capture_event(void *user, const tts_event_t *event);
+static uint64_t now_us(void);
+static void pull_end(TTS_Engine *engine, int state);
+static void stop_clear(TTS_Engine *engine);
+static void event_signal(TTS_Engine *engine);
+static void event_clear(TTS_Engine *engine);
+static void timing_set_taps(TTS_Engine *engine, tts_voice_t *voice);
+static bool timing_reserve(void **buf, size_t *size, size_t need, size_t elem_size);
+static void timing_tap(void *user, pico_Int16 unit, const pico_Char *item, pico_Int16 size);
+static void timing_reset(TTS_Engine *engine);
+static void timing_deliver(TTS_Engine *engine, size_t bytes, bool final);
+static void timing_cut(TTS_Engine *engine, size_t bytes);
 
 TTS_Engine *TtsEngine_Create(const char *lang_dir, const char *language, tts_callback_t cb)
+{
+	return TtsEngine_CreateMulti(lang_dir, &language, 1, cb);
+}
+
+TTS_Engine *TtsEngine_CreateMulti(const char *lang_dir, const char *const *languages, int num_languages, tts_callback_t cb)
 {
 	TTS_Engine *engine = NULL;
-	
-	if (!cb || !language || !lang_dir || strlen(lang_dir) <= 0) {
+	size_t mem_size;
+	int i;
+
+	if (!languages || num_languages <= 0 || num_languages > MAX_VOICES || !lang_dir || strlen(lang_dir) <= 0) {
 		PICO_DBG("%s: Invalid parameter\n", __FUNCTION__);
 		return NULL;
 	}
+	for (i = 0; i < num_languages; i++) {
+		if (!languages[i]) {
+			PICO_DBG("%s: Invalid parameter\n", __FUNCTION__);
+			return NULL;
+		}
+	}
 
-	PICO_DBG("TtsEngine_Create: lang:%s dir:%s\n", language, lang_dir);
+	PICO_DBG("TtsEngine_Create: lang:%s (+%d) dir:%s\n", languages[0], num_languages - 1, lang_dir);
 	engine = (TTS_Engine *) calloc(1, sizeof(TTS_Engine));
 	engine->current_pitch = PICO_DEF_PITCH;
 	engine->current_rate = PICO_DEF_RATE;
 	engine->current_volume = PICO_DEF_VOL;
+	engine->pull_state = PULL_NONE;
+#ifdef __linux__
+	engine->event_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+#else
+	engine->event_fd = -1;
+#endif
 
-	engine->pico_mem_pool = calloc(PICO_MEM_SIZE , 1);
+	/* Every language needs room for its lingware and its engine. */
+	mem_size = (size_t) num_languages * PICO_MEM_SIZE;
+	engine->pico_mem_pool = calloc(mem_size, 1);
 	if (!engine->pico_mem_pool) {
 		PICO_DBG("Failed to allocate memory for Pico system\n");
 		TtsEngine_Destroy(engine);
 		return NULL;
 	}
 
-	if (pico_initialize(engine->pico_mem_pool, PICO_MEM_SIZE, &engine->pico_sys) != PICO_OK) {
+	if (pico_initialize(engine->pico_mem_pool, mem_size, &engine->pico_sys) != PICO_OK) {
 		PICO_DBG("pico_initialize failed\n");
 		TtsEngine_Destroy(engine);
 		return NULL;
@@ -92,15 +257,73 @@ TTS_Engine *TtsEngine_Create(const char *lang_dir, const char *language, tts_cal
 		return NULL;
 	}
 
-	if (!load_language(engine, language)) {
-		PICO_DBG("load_language %s failed\n", language);
-		TtsEngine_Destroy(engine);
-		return NULL;
+	for (i = 0; i < num_languages; i++) {
+		if (!load_language(engine, &engine->voices[i], languages[i])) {
+			PICO_DBG("load_language %s failed\n", languages[i]);
+			TtsEngine_Destroy(engine);
+			return NULL;
+		}
+		engine->num_voices++;
 	}
+	engine->voice = &engine->voices[0];
 
 	return engine;
 }
 
+bool TtsEngine_SetLanguage(TTS_Engine *engine, const char *language)
+{
+	tts_voice_t *voice;
+	char *old_language;
+	int i;
+
+	assert(engine);
+	assert(language);
+
+	if (!engine || !language) {
+		PICO_DBG("Invalid argument\n");
+		return false;
+	}
+	if (engine->pull_state == PULL_RUNNING || engine->session_open) {
+		PICO_DBG("Cannot switch language during synthesis\n");
+		return false;
+	}
+	/* a pending Stop has cancelled the engine being left */
+	stop_clear(engine);
+
+	/* Hot switch to an engine that is already instantiated. */
+	for (i = 0; i < engine->num_voices; i++) {
+		if (engine->voices[i].language && strcmp(engine->voices[i].language, language) == 0) {
+			engine->voice = &engine->voices[i];
+			return true;
+		}
+	}
+
+	/* Otherwise the selected voice is replaced, which means reloading lingware. */
+	voice = engine->voice;
+	PICO_DBG("%s is not preloaded, replacing %s\n", language, voice->language);
+	old_language = voice->language;
+	voice->language = NULL;
+	unload_language(engine, voice);
+	if (load_language(engine, voice, language)) {
+		free(old_language);
+		return true;
+	}
+
+	PICO_DBG("load_language %s failed, restoring %s\n", language, old_language);
+	unload_language(engine, voice);
+	if (!load_language(engine, voice, old_language)) {
+		unload_language(engine, voice);
+	}
+	free(old_language);
+	return false;
+}
+
+const char *TtsEngine_GetLanguage(const TTS_Engine *engine)
+{
+	assert(engine);
+	return engine->voice->language;
+}
+
 int TtsEngine_SetRate(TTS_Engine *engine, int rate)
 {
 	assert(engine);
@@ -143,34 +366,68 @@ int TtsEngine_GetPitch(const TTS_Engine *engine)
 void TtsEngine_Stop(TTS_Engine *engine)
 {
 	assert(engine);
-	engine->synthesis_abort_flag = true;
+	picopal_atomic_set(&engine->synthesis_abort_flag, 1);
+	/* Cut a long synthesis step short; the engine is reset when the flag is seen. */
+	if (engine->voice->pico_engine) {
+		picoext_cancelEngine(engine->voice->pico_engine);
+	}
+}
+
+void TtsEngine_SetEventCallback(TTS_Engine *engine, tts_event_callback_t cb, void *user)
+{
+	int i;
+
+	assert(engine);
+	engine->timing_callback = cb;
+	engine->timing_user = user;
+	for (i = 0; i < engine->num_voices; i++) {
+		timing_set_taps(engine, &engine->voices[i]);
+	}
+}
+
+void TtsEngine_SetChunking(TTS_Engine *engine, int min_ms, int max_ms)
+{
+	int max_chunk_ms = SYNTH_BUFFER_SIZE / 2 / PCM_BYTES_PER_MS;
+
+	assert(engine);
+	if (min_ms <= 0 && max_ms <= 0) {
+		engine->chunk_first = engine->chunk_size = 0;
+		return;
+	}
+	min_ms = clamp(min_ms, 1, max_chunk_ms);
+	max_ms = clamp(max_ms, min_ms, max_chunk_ms);
+	engine->chunk_first = (size_t) min_ms * PCM_BYTES_PER_MS;
+	engine->chunk_size = (size_t) max_ms * PCM_BYTES_PER_MS;
 }
 
 bool TtsEngine_Speak(TTS_Engine *engine, const char *text, void *userdata)
 {
-	uint8_t    *buffer = NULL;
-	bool        cont = true;
 	pico_Char * inp = NULL;
 	const char * local_text = NULL;
-	short       outbuf[MAX_OUTBUF_SIZE/2];
-	pico_Int16  bytes_sent, bytes_recv, text_remaining, out_data_type;
+	pico_Int16  bytes_sent, chunk;
+	size_t      text_remaining;
 	pico_Status ret;
 	bool success = false;
-	uint32_t rate = 16000;
-	uint32_t depth = 16;
-	int channels = 1;
-	size_t bufused = 0;
 
 	assert(engine);
 	assert(text);
 
-	if (!text || !engine) {
+	if (!text || !engine || !engine->synth_callback) {
 		PICO_DBG("Invalid argument\n");
 		return false;
 	}
+	if (!engine->voice->pico_engine) {
+		PICO_DBG("No language loaded\n");
+		return false;
+	}
+	if (engine->session_open || engine->pull_state == PULL_RUNNING) {
+		PICO_DBG("Synthesis in progress\n");
+		return false;
+	}
 
-	engine->synthesis_abort_flag = false;
-	buffer = engine->synthesis_buffer;
+	stop_clear(engine);
+	chunk_start(engine);
+	timing_reset(engine);
 
 	if (strlen(text) == 0) {
 		return true;
@@ -185,13 +442,14 @@ bool TtsEngine_Speak(TTS_Engine *engine, const char *text, void *userdata)
 
 	/* synthesis loop   */
 	while (text_remaining) {
-		if (engine->synthesis_abort_flag) {
-			ret = pico_resetEngine(engine->pico_engine, PICO_RESET_SOFT);
+		if (picopal_atomic_get(&engine->synthesis_abort_flag)) {
+			ret = pico_resetEngine(engine->voice->pico_engine, PICO_RESET_UTTERANCE);
 			break;
 		}
 
-		/* Feed the text into the engine.   */
-		ret = pico_putTextUtf8(engine->pico_engine, inp, text_remaining, &bytes_sent);
+		/* Feed the text into the engine, at most PICO_INT16_MAX bytes at a time. */
+		chunk = (pico_Int16) (text_remaining > PICO_INT16_MAX ? PICO_INT16_MAX : text_remaining);
+		ret = pico_putTextUtf8(engine->voice->pico_engine, inp, chunk, &bytes_sent);
 		if (ret != PICO_OK) {
 			PICO_DBG("Error synthesizing string '%s': [%d]\n", text, ret);
 			goto cleanup;
@@ -199,89 +457,532 @@ bool TtsEngine_Speak(TTS_Engine *engine, const char *text, void *userdata)
 
 		text_remaining -= bytes_sent;
 		inp += bytes_sent;
-		do {
-			if (engine->synthesis_abort_flag) {
-				ret = pico_resetEngine(engine->pico_engine, PICO_RESET_SOFT);
-				break;
-			}
-			/* Retrieve the samples and add them to the buffer. */
-			ret = pico_getData(engine->pico_engine, (void *) outbuf, MAX_OUTBUF_SIZE, &bytes_recv,
-							   &out_data_type);
-			if (bytes_recv) {
-				if ((bufused + bytes_recv) <= SYNTH_BUFFER_SIZE) {
-					memcpy(buffer+bufused, outbuf, bytes_recv);
-					bufused += bytes_recv;
-				} else {
-					/* The buffer filled; pass this on to the callback function.    */
-					cont = engine->synth_callback(userdata, rate, depth, channels, buffer, bufused, false);
-					if (!cont) {
-						PICO_DBG("Halt requested by caller. Halting.\n");
-						engine->synthesis_abort_flag = true;
-						ret = pico_resetEngine(engine->pico_engine, PICO_RESET_SOFT);
-						break;
-					}
-					bufused = 0;
-					memcpy(buffer, (int8_t *) outbuf, bytes_recv);
-					bufused += bytes_recv;
-				}
-			}
-		} while (PICO_STEP_BUSY == ret);
+		ret = synth_drain(engine, userdata);
 
-		if (!engine->synthesis_abort_flag) {
+		if (!picopal_atomic_get(&engine->synthesis_abort_flag)) {
 			/* Pass any remaining samples. */
-			engine->synth_callback(userdata, rate, depth, channels, buffer, bufused, false);
-			bufused = 0;
+			chunk_pass_rest(engine, userdata);
 		}
 
 		if (ret != PICO_STEP_IDLE) {
 
 			PICO_DBG("Error occurred during synthesis [%d]\n", ret);
 			PICO_DBG("Synth loop: sending TTS_SYNTH_DONE after error\n");
-			bufused = 0;
-			engine->synth_callback(userdata, rate, depth, channels, buffer, bufused, true);
-			pico_resetEngine(engine->pico_engine, PICO_RESET_SOFT);
+			engine->chunk_used = 0;
+			engine->synth_callback(userdata, PCM_RATE, PCM_DEPTH, PCM_CHANNELS, engine->chunk_buf, engine->chunk_used, true);
+			pico_resetEngine(engine->voice->pico_engine, PICO_RESET_SOFT);
 			goto cleanup;
 		}
 	}
 
 	/* Synthesis is done; notify the caller */
 	PICO_DBG("Synth loop: sending TTS_SYNTH_DONE after all done, or was asked to stop\n");
-	engine->synth_callback(userdata, rate, depth, channels, buffer, bufused, true);
+	if (!picopal_atomic_get(&engine->synthesis_abort_flag)) {
+		timing_deliver(engine, engine->chunk_used, true);
+	}
+	engine->synth_callback(userdata, PCM_RATE, PCM_DEPTH, PCM_CHANNELS, engine->chunk_buf, engine->chunk_used, true);
 
 	success = true;
 
 cleanup:
-	engine->synthesis_abort_flag = false;
+	timing_reset(engine);
 	if (local_text != text) {
 		free((void*) local_text);
 	}
 	return success;
 }
 
-void TtsEngine_Destroy(TTS_Engine *engine)
+bool TtsEngine_Open(TTS_Engine *engine, uint32_t flush_ms, void *userdata)
 {
-	if (!engine) {
+	char tags[PROPERTY_TAGS_SIZE];
+
+	assert(engine);
+
+	if (!engine || !engine->synth_callback) {
+		PICO_DBG("Invalid argument\n");
+		return false;
+	}
+	if (!engine->voice->pico_engine) {
+		PICO_DBG("No language loaded\n");
+		return false;
+	}
+	if (engine->session_open || engine->pull_state == PULL_RUNNING) {
+		PICO_DBG("Synthesis in progress\n");
+		return false;
+	}
+
+	stop_clear(engine);
+	chunk_start(engine);
+	timing_reset(engine);
+	engine->session_open = true;
+	engine->session_user = userdata;
+	engine->session_flush_us = (uint64_t) flush_ms * 1000;
+	engine->session_pending_us = 0;
+	engine->session_at_word = false;
+
+	/* The property tags enclose the whole session. */
+	engine->session_tags = has_properties(engine);
+	if (engine->session_tags) {
+#ifdef _WIN32
+		_snprintf_s(tags, sizeof(tags), _TRUNCATE, PROPERTY_TAGS_OPEN,
+				 engine->current_rate, engine->current_pitch, engine->current_volume);
+#else
+		snprintf(tags, sizeof(tags), PROPERTY_TAGS_OPEN,
+			engine->current_rate, engine->current_pitch, engine->current_volume);
+#endif
+		return session_feed(engine, tags, strlen(tags));
+	}
+	return true;
+}
+
+bool TtsEngine_Append(TTS_Engine *engine, const char *text)
+{
+	size_t len, audio_bytes;
+	unsigned char last;
+
+	assert(engine);
+	assert(text);
+
+	if (!engine || !text || !engine->session_open) {
+		PICO_DBG("Invalid argument\n");
+		return false;
+	}
+	len = strlen(text);
+	if (len == 0) {
+		return true;
+	}
+
+	audio_bytes = engine->chunk_total;
+	if (!session_feed(engine, text, len)) {
+		return false;
+	}
+	if (!engine->session_flush_us) {
+		return true;
+	}
+
+	/* Text waits for the end of its sentence at most the flush timeout
+	   after the previous sentence; then it is spoken as a phrase as soon
+	   as it ends at a word. */
+	if (engine->chunk_total != audio_bytes || !engine->session_pending_us) {
+		engine->session_pending_us = now_us();
+	}
+	last = (unsigned char) text[len - 1];
+	engine->session_at_word = last <= ' ' || strchr(",;:", last);
+	return TtsEngine_Poll(engine);
+}
+
+bool TtsEngine_Poll(TTS_Engine *engine)
+{
+	assert(engine);
+
+	if (!engine || !engine->session_open) {
+		PICO_DBG("Invalid argument\n");
+		return false;
+	}
+	if (engine->session_flush_us && engine->session_pending_us && engine->session_at_word
+			&& now_us() - engine->session_pending_us >= engine->session_flush_us) {
+		return TtsEngine_Flush(engine);
+	}
+	return true;
+}
+
+bool TtsEngine_Flush(TTS_Engine *engine)
+{
+	assert(engine);
+
+	if (!engine || !engine->session_open) {
+		PICO_DBG("Invalid argument\n");
+		return false;
+	}
+	engine->session_pending_us = 0;
+	/* A NUL character makes Pico speak its pending text as a sentence. */
+	return session_feed(engine, "", 1);
+}
+
+bool TtsEngine_Finish(TTS_Engine *engine)
+{
+	assert(engine);
+
+	if (!engine || !engine->session_open) {
+		PICO_DBG("Invalid argument\n");
+		return false;
+	}
+	if (engine->session_tags && !session_feed(engine, PROPERTY_TAGS_CLOSE, strlen(PROPERTY_TAGS_CLOSE))) {
+		return false;
+	}
+	if (!session_feed(engine, "", 1)) {
+		return false;
+	}
+	session_end(engine, true);
+	return true;
+}
+
+TTS_Template *TtsEngine_CreateTemplate(TTS_Engine *engine, const char *pattern)
+{
+	TTS_Template *tpl;
+	char *p;
+	int i;
+
+	assert(engine);
+	assert(pattern);
+
+	if (!engine || !pattern) {
+		PICO_DBG("Invalid argument\n");
+		return NULL;
+	}
+	if (engine->session_open || engine->pull_state == PULL_RUNNING) {
+		PICO_DBG("Synthesis in progress\n");
+		return NULL;
+	}
+	stop_clear(engine);
+	tpl = (TTS_Template *) calloc(1, sizeof(TTS_Template));
+	if (!tpl) {
+		return NULL;
+	}
+	tpl->text = strdup(pattern);
+	for (p = tpl->text; p && (p = strchr(p, '{')); p++) {
+		tpl->num_slots++;
+	}
+	tpl->parts = (const char **) calloc(tpl->num_slots + 1, sizeof(char *));
+	tpl->names = (const char **) calloc(tpl->num_slots + 1, sizeof(char *));
+	tpl->cuts = (size_t *) calloc(2 * tpl->num_slots + 1, sizeof(size_t));
+	if (!tpl->text || !tpl->parts || !tpl->names || !tpl->cuts) {
+		TtsEngine_DestroyTemplate(tpl);
+		return NULL;
+	}
+
+	/* Split "part{name}part..." in place. */
+	p = tpl->text;
+	tpl->parts[0] = p;
+	for (i = 0; i < tpl->num_slots; i++) {
+		p = strchr(p, '{');
+		*p++ = '\0';
+		tpl->names[i] = p;
+		p = strchr(p, '}');
+		if (!p || p == tpl->names[i]) {
+			PICO_DBG("Template slot without a name or '}'\n");
+			TtsEngine_DestroyTemplate(tpl);
+			return NULL;
+		}
+		*p++ = '\0';
+		if (strchr(tpl->names[i], '<')) {
+			PICO_DBG("Markup in the name of template slot %d\n", i);
+			TtsEngine_DestroyTemplate(tpl);
+			return NULL;
+		}
+		tpl->parts[i + 1] = p;
+	}
+
+	if (!template_render(engine, tpl)) {
+		TtsEngine_DestroyTemplate(tpl);
+		return NULL;
+	}
+	return tpl;
+}
+
+int TtsEngine_GetTemplateSlots(const TTS_Template *tpl)
+{
+	assert(tpl);
+	return tpl->num_slots;
+}
+
+bool TtsEngine_SpeakTemplate(TTS_Engine *engine, TTS_Template *tpl, const char *const *values, void *userdata)
+{
+	tts_capture_t cap;
+	size_t slot_marks[2];
+	size_t pos = 0;		/* next sample of the static rendering to pass on */
+	size_t end, n;
+	const char *text;
+	char *slot_text;
+	bool ok = true;
+	int i;
+
+	assert(engine);
+	assert(tpl);
+
+	if (!engine || !tpl || (!values && tpl->num_slots > 0) || !engine->synth_callback) {
+		PICO_DBG("Invalid argument\n");
+		return false;
+	}
+	/* The values go between the marks of their slot, so they must not
+	   open markup of their own. */
+	for (i = 0; i < tpl->num_slots; i++) {
+		if (values[i] && strchr(values[i], '<')) {
+			PICO_DBG("Markup in the value of template slot %d\n", i);
+			return false;
+		}
+	}
+	if (engine->session_open || engine->pull_state == PULL_RUNNING) {
+		PICO_DBG("Synthesis in progress\n");
+		return false;
+	}
+	stop_clear(engine);
+	/* The static text follows the voice and its settings. */
+	if ((!tpl->language || !engine->voice->language || strcmp(tpl->language, engine->voice->language) != 0
+			|| tpl->rate != engine->current_rate || tpl->pitch != engine->current_pitch
+			|| tpl->volume != engine->current_volume) && !template_render(engine, tpl)) {
+		return false;
+	}
+
+	chunk_start(engine);
+	timing_reset(engine);
+	memset(&cap, 0, sizeof(cap));
+	cap.marks = slot_marks;
+	cap.num_slots = 1;
+
+	for (i = 0; ok && i < tpl->num_slots; i++) {
+		/* the cached audio up to the slot */
+		ok = chunk_put(engine, userdata, tpl->pcm + pos, (tpl->cuts[2 * i] - pos) * sizeof(int16_t));
+		pos = tpl->cuts[2 * i];
+
+		/* The slot is synthesized between the neighbouring words of the
+		   template, which give it the prosody of its place in the phrase. */
+		slot_text = ok ? template_text(tpl, i, values[i] ? values[i] : "") : NULL;
+		text = slot_text ? add_properties(engine, slot_text) : NULL;
+		cap.samples = 0;
+		slot_marks[0] = slot_marks[1] = (size_t) -1;
+		ok = text && synth_capture(engine, text, &cap)
+				&& slot_marks[0] <= slot_marks[1] && slot_marks[1] <= cap.samples;
+		if (text != slot_text) {
+			free((void *) text);
+		}
+		free(slot_text);
+		if (!ok) {
+			break;
+		}
+
+		/* Crossfade into the slot and back into the static text after it. */
+		n = slot_marks[1] - slot_marks[0];
+		if (n > tpl->samples - pos) {
+			n = tpl->samples - pos;
+		}
+		if (n > TEMPLATE_XFADE) {
+			n = TEMPLATE_XFADE;
+		}
+		ok = template_crossfade(engine, userdata, tpl->pcm + pos, cap.pcm + slot_marks[0], n)
+				&& chunk_put(engine, userdata, cap.pcm + slot_marks[0] + n,
+						(slot_marks[1] - slot_marks[0] - n) * sizeof(int16_t));
+		pos = tpl->cuts[2 * i + 1];
+		end = (i + 1 < tpl->num_slots) ? tpl->cuts[2 * i + 2] : tpl->samples;
+		n = cap.samples - slot_marks[1];
+		if (n > end - pos) {
+			n = end - pos;
+		}
+		if (n > TEMPLATE_XFADE) {
+			n = TEMPLATE_XFADE;
+		}
+		ok = ok && template_crossfade(engine, userdata, cap.pcm + slot_marks[1], tpl->pcm + pos, n);
+		pos += n;
+	}
+	ok = ok && chunk_put(engine, userdata, tpl->pcm + pos, (tpl->samples - pos) * sizeof(int16_t));
+	free(cap.pcm);
+
+	if (!ok) {
+		pico_resetEngine(engine->voice->pico_engine, PICO_RESET_UTTERANCE);
+		engine->chunk_used = 0;
+	}
+	engine->synth_callback(userdata, PCM_RATE, PCM_DEPTH, PCM_CHANNELS, engine->chunk_buf, engine->chunk_used, true);
+	timing_reset(engine);
+	return ok;
+}
+
+void TtsEngine_DestroyTemplate(TTS_Template *tpl)
+{
+	if (!tpl) {
 		return;
 	}
+	free(tpl->text);
+	free((void *) tpl->parts);
+	free((void *) tpl->names);
+	free(tpl->pcm);
+	free(tpl->cuts);
+	free(tpl->language);
+	free(tpl);
+}
 
-	if (engine->pico_engine) {
-		pico_disposeEngine(engine->pico_sys, &engine->pico_engine);
-		pico_releaseVoiceDefinition(engine->pico_sys, (pico_Char *) PICO_VOICE_NAME);
+bool TtsEngine_Begin(TTS_Engine *engine, const char *text)
+{
+	const char *local_text;
+
+	assert(engine);
+	assert(text);
+
+	if (!engine || !text) {
+		PICO_DBG("Invalid argument\n");
+		return false;
+	}
+	if (!engine->voice->pico_engine) {
+		PICO_DBG("No language loaded\n");
+		return false;
+	}
+	if (engine->session_open) {
+		PICO_DBG("A streaming session is open\n");
+		return false;
 	}
 
-	if (engine->pico_utpp) {
-		pico_unloadResource(engine->pico_sys, &engine->pico_utpp);
-		engine->pico_utpp = NULL;
+	if (engine->pull_state == PULL_RUNNING) {
+		pico_resetEngine(engine->voice->pico_engine, PICO_RESET_UTTERANCE);
 	}
+	pull_end(engine, PULL_NONE);
+	stop_clear(engine);
+	engine->pull_head = 0;
+	engine->pull_tail = 0;
+	event_clear(engine);
+	timing_reset(engine);
+
+	/* Keep a private copy: the caller's string may go away before synthesis ends. */
+	local_text = add_properties(engine, text);
+	engine->pull_text = (local_text != text) ? (char *) local_text : strdup(text);
+	if (!engine->pull_text) {
+		return false;
+	}
+
+	engine->pull_inp = engine->pull_text;
+	engine->pull_remaining = strlen(engine->pull_text) + 1;
+	engine->pull_feed = true;
+	engine->pull_state = PULL_RUNNING;
+	return true;
+}
+
+tts_pump_status_t TtsEngine_Pump(TTS_Engine *engine, uint32_t budget_us)
+{
+	pico_Int16  bytes_sent, bytes_recv, out_data_type, chunk;
+	pico_Status ret;
+	uint64_t    deadline;
+	bool        had_pcm;
+
+	assert(engine);
 
-	if (engine->pico_ta) {
-		pico_unloadResource(engine->pico_sys, &engine->pico_ta);
-		engine->pico_ta = NULL;
+	switch (engine->pull_state) {
+	case PULL_RUNNING:
+		break;
+	case PULL_DONE:
+		return TTS_PUMP_DONE;
+	case PULL_ERROR:
+		return TTS_PUMP_ERROR;
+	default:
+		return TTS_PUMP_IDLE;
 	}
 
-	if (engine->pico_sg) {
-		pico_unloadResource(engine->pico_sys, &engine->pico_sg);
-		engine->pico_sg = NULL;
+	had_pcm = engine->pull_tail > engine->pull_head;
+	deadline = budget_us ? now_us() + budget_us : 0;
+
+	for (;;) {
+		if (picopal_atomic_get(&engine->synthesis_abort_flag)) {
+			pico_resetEngine(engine->voice->pico_engine, PICO_RESET_UTTERANCE);
+			timing_cut(engine, engine->pull_tail - engine->pull_head);
+			pull_end(engine, PULL_DONE);
+			return TTS_PUMP_DONE;
+		}
+
+		if (engine->pull_feed) {
+			if (!engine->pull_remaining) {
+				pull_end(engine, PULL_DONE);
+				return TTS_PUMP_DONE;
+			}
+			/* Feed the next piece of text into the engine. */
+			chunk = (pico_Int16) (engine->pull_remaining > PICO_INT16_MAX ? PICO_INT16_MAX : engine->pull_remaining);
+			ret = pico_putTextUtf8(engine->voice->pico_engine, (const pico_Char *) engine->pull_inp, chunk, &bytes_sent);
+			if (ret != PICO_OK) {
+				PICO_DBG("Error synthesizing string: [%d]\n", ret);
+				pull_end(engine, PULL_ERROR);
+				return TTS_PUMP_ERROR;
+			}
+			engine->pull_inp += bytes_sent;
+			engine->pull_remaining -= bytes_sent;
+			engine->pull_feed = false;
+		}
+
+		/* Make room for the next chunk, compacting the queue if needed. */
+		if (engine->pull_tail + MAX_OUTBUF_SIZE > SYNTH_BUFFER_SIZE) {
+			if (engine->pull_head == 0) {
+				return TTS_PUMP_FULL;
+			}
+			memmove(engine->synthesis_buffer, engine->synthesis_buffer + engine->pull_head,
+					engine->pull_tail - engine->pull_head);
+			engine->pull_tail -= engine->pull_head;
+			engine->pull_head = 0;
+		}
+
+		ret = pico_getData(engine->voice->pico_engine, (void *) (engine->synthesis_buffer + engine->pull_tail),
+						   MAX_OUTBUF_SIZE, &bytes_recv, &out_data_type);
+		if (bytes_recv > 0) {
+			engine->pull_tail += bytes_recv;
+			if (!had_pcm) {
+				had_pcm = true;
+				event_signal(engine);
+			}
+		}
+
+		if (ret == PICO_STEP_IDLE) {
+			engine->pull_feed = true;
+		} else if (ret != PICO_STEP_BUSY) {
+			PICO_DBG("Error occurred during synthesis [%d]\n", ret);
+			pico_resetEngine(engine->voice->pico_engine, PICO_RESET_SOFT);
+			pull_end(engine, PULL_ERROR);
+			return TTS_PUMP_ERROR;
+		}
+
+		if (deadline && now_us() >= deadline) {
+			return TTS_PUMP_BUSY;
+		}
+	}
+}
+
+uint32_t TtsEngine_Read(TTS_Engine *engine, uint8_t *audio, uint32_t max_bytes)
+{
+	size_t avail;
+
+	assert(engine);
+	assert(audio || !max_bytes);
+
+	avail = engine->pull_tail - engine->pull_head;
+	if (avail > max_bytes) {
+		avail = max_bytes;
+	}
+	memcpy(audio, engine->synthesis_buffer + engine->pull_head, avail);
+	engine->pull_head += avail;
+	timing_deliver(engine, avail, engine->pull_state == PULL_DONE && engine->pull_head == engine->pull_tail);
+
+	if (engine->pull_head == engine->pull_tail) {
+		engine->pull_head = 0;
+		engine->pull_tail = 0;
+		if (engine->pull_state == PULL_RUNNING) {
+			event_clear(engine);
+		}
+	}
+	return (uint32_t) avail;
+}
+
+uint32_t TtsEngine_Available(const TTS_Engine *engine)
+{
+	assert(engine);
+	return (uint32_t) (engine->pull_tail - engine->pull_head);
+}
+
+int TtsEngine_GetEventFd(const TTS_Engine *engine)
+{
+	assert(engine);
+	return engine->event_fd;
+}
+
+void TtsEngine_Destroy(TTS_Engine *engine)
+{
+	int i;
+
+	if (!engine) {
+		return;
+	}
+
+	pull_end(engine, PULL_NONE);
+#ifndef _WIN32
+	if (engine->event_fd >= 0) {
+		close(engine->event_fd);
+	}
+#endif
+
+	for (i = 0; i < MAX_VOICES; i++) {
+		unload_language(engine, &engine->voices[i]);
 	}
 
 	if (engine->pico_sys) {
@@ -289,14 +990,16 @@ void TtsEngine_Destroy(TTS_Engine *engine)
 		engine->pico_sys = NULL;
 	}
 
+	timing_reset(engine);
+	free(engine->timing.word_phones);
+	free(engine->timing.events);
 	free(engine->pico_mem_pool);
-	free(engine->current_language);
 	free(engine->languages_path);
 	free(engine->synthesis_buffer);
 	free(engine);
 }
 
-static bool load_language(TTS_Engine *engine, const char *lang)
+static bool load_language(TTS_Engine *engine, tts_voice_t *voice, const char *lang)
 {
 	pico_Status ret;
 	bool success = false;
@@ -306,6 +1009,8 @@ static bool load_language(TTS_Engine *engine, const char *lang)
 	const pico_Char *fname_utpp = (const pico_Char *) "dummy.bin";
 	Lang_Filenames lf;
 
+	/* Every voice needs its own definition within the shared Pico system. */
+	snprintf(voice->name, sizeof(voice->name), "%s%d", PICO_VOICE_NAME, (int) (voice - engine->voices));
 	lang_files_find(&lf, engine->languages_path, lang);
 
 	if (!is_readable(lf.fname_ta)) {
@@ -319,14 +1024,14 @@ static bool load_language(TTS_Engine *engine, const char *lang)
 	}
 
 	/* Load the text analysis Lingware resource file.   */
-	ret = pico_loadResource(engine->pico_sys, (const pico_Char *) lf.fname_ta, &engine->pico_ta);
+	ret = pico_loadResource(engine->pico_sys, (const pico_Char *) lf.fname_ta, &voice->pico_ta);
 	if (PICO_OK != ret) {
 		PICO_DBG("Failed to load textana resource for %s [%d]\n", lang, ret);
 		goto cleanup;
 	}
 
 	/* Load the signal generation Lingware resource file.   */
-	ret = pico_loadResource(engine->pico_sys, (const pico_Char *) lf.fname_sg, &engine->pico_sg);
+	ret = pico_loadResource(engine->pico_sys, (const pico_Char *) lf.fname_sg, &voice->pico_sg);
 	if (PICO_OK != ret) {
 		PICO_DBG("Failed to load siggen resource for %s [%d]\n", lang, ret);
 		goto cleanup;
@@ -336,27 +1041,27 @@ static bool load_language(TTS_Engine *engine, const char *lang)
 	   and is currently not used. Loading is only attempted for future compatibility.
 	   If this file is not present the loading will still succeed.                      */
 	if (lf.fname_utpp) fname_utpp = (const pico_Char *) lf.fname_utpp;
-	ret = pico_loadResource(engine->pico_sys, fname_utpp, &engine->pico_utpp);
+	ret = pico_loadResource(engine->pico_sys, fname_utpp, &voice->pico_utpp);
 	if ((PICO_OK != ret) && (ret != PICO_EXC_CANT_OPEN_FILE)) {
 		PICO_DBG("Failed to load utpp resource for %s [%d]\n", lang, ret);
 		goto cleanup;
 	}
 
-	free(engine->current_language);
-	engine->current_language = strdup(lang);
+	free(voice->language);
+	voice->language = strdup(lang);
 
 	/* Get the text analysis resource name. */
-	ret = pico_getResourceName(engine->pico_sys, engine->pico_ta, (char *) resource_name_ta);
+	ret = pico_getResourceName(engine->pico_sys, voice->pico_ta, (char *) resource_name_ta);
 	if (PICO_OK != ret) {
 		PICO_DBG("Failed to get textana resource name for %s [%d]\n", lang, ret);
 		goto cleanup;
 	}
 
 	/* Get the signal generation resource name. */
-	ret = pico_getResourceName(engine->pico_sys, engine->pico_sg, (char *) resource_name_sg);
-	if ((PICO_OK == ret) && (engine->pico_utpp != NULL)) {
+	ret = pico_getResourceName(engine->pico_sys, voice->pico_sg, (char *) resource_name_sg);
+	if ((PICO_OK == ret) && (voice->pico_utpp != NULL)) {
 		/* Get utpp resource name - optional: see note above.   */
-		ret = pico_getResourceName(engine->pico_sys, engine->pico_utpp, (char *) resource_name_utpp);
+		ret = pico_getResourceName(engine->pico_sys, voice->pico_utpp, (char *) resource_name_utpp);
 		if (PICO_OK != ret)  {
 			goto cleanup;
 		}
@@ -368,24 +1073,24 @@ static bool load_language(TTS_Engine *engine, const char *lang)
 	}
 
 	/* Create a voice definition.   */
-	ret = pico_createVoiceDefinition(engine->pico_sys, (const pico_Char *) PICO_VOICE_NAME);
+	ret = pico_createVoiceDefinition(engine->pico_sys, (const pico_Char *) voice->name);
 	if (PICO_OK != ret) {
 		PICO_DBG("Failed to create voice for %s [%d]\n", lang, ret);
 		goto cleanup;
 	}
 
 	/* Add the text analysis resource to the voice. */
-	ret = pico_addResourceToVoiceDefinition(engine->pico_sys, (const pico_Char *) PICO_VOICE_NAME, resource_name_ta);
+	ret = pico_addResourceToVoiceDefinition(engine->pico_sys, (const pico_Char *) voice->name, resource_name_ta);
 	if (PICO_OK != ret) {
 		PICO_DBG("Failed to add textana resource to voice for %s [%d]\n", lang, ret);
 		goto cleanup;
 	}
 
 	/* Add the signal generation resource to the voice. */
-	ret = pico_addResourceToVoiceDefinition(engine->pico_sys, (const pico_Char *) PICO_VOICE_NAME, resource_name_sg);
-	if ((PICO_OK == ret) && (engine->pico_utpp != NULL)) {
+	ret = pico_addResourceToVoiceDefinition(engine->pico_sys, (const pico_Char *) voice->name, resource_name_sg);
+	if ((PICO_OK == ret) && (voice->pico_utpp != NULL)) {
 		/* Add utpp resource to voice - optional: see note above.   */
-		ret = pico_addResourceToVoiceDefinition(engine->pico_sys, (const pico_Char *) PICO_VOICE_NAME, resource_name_utpp);
+		ret = pico_addResourceToVoiceDefinition(engine->pico_sys, (const pico_Char *) voice->name, resource_name_utpp);
 		if (PICO_OK != ret) {
 			PICO_DBG("Failed to add utpp resource to voice for %s [%d]\n", lang, ret);
 			goto cleanup;
@@ -397,12 +1102,14 @@ static bool load_language(TTS_Engine *engine, const char *lang)
 		goto cleanup;
 	}
 
-	ret = pico_newEngine(engine->pico_sys, (const pico_Char *) PICO_VOICE_NAME, &engine->pico_engine);
+	ret = pico_newEngine(engine->pico_sys, (const pico_Char *) voice->name, &voice->pico_engine);
 	if (PICO_OK != ret) {
 		PICO_DBG("Failed to create engine for %s [%d]\n", lang, ret);
 		goto cleanup;
 	}
 
+	timing_set_taps(engine, voice);
+
 	success = true;
 	PICO_DBG("%s loaded successfully\n", lang);
 
@@ -411,6 +1118,37 @@ cleanup:
 	return success;
 }
 
+static void unload_language(TTS_Engine *engine, tts_voice_t *voice)
+{
+	if (voice->pico_engine) {
+		pico_disposeEngine(engine->pico_sys, &voice->pico_engine);
+		voice->pico_engine = NULL;
+	}
+
+	if (voice->name[0]) {
+		pico_releaseVoiceDefinition(engine->pico_sys, (pico_Char *) voice->name);
+		voice->name[0] = '\0';
+	}
+
+	if (voice->pico_utpp) {
+		pico_unloadResource(engine->pico_sys, &voice->pico_utpp);
+		voice->pico_utpp = NULL;
+	}
+
+	if (voice->pico_ta) {
+		pico_unloadResource(engine->pico_sys, &voice->pico_ta);
+		voice->pico_ta = NULL;
+	}
+
+	if (voice->pico_sg) {
+		pico_unloadResource(engine->pico_sys, &voice->pico_sg);
+		voice->pico_sg = NULL;
+	}
+
+	free(voice->language);
+	voice->language = NULL;
+}
+
 static bool is_readable(const char *filename)
 {
 	FILE *fp = NULL;
@@ -425,31 +1163,623 @@ static bool is_readable(const char *filename)
 	return true;
 }
 
+static bool has_properties(TTS_Engine *engine)
+{
+	return engine->current_pitch != PICO_DEF_PITCH
+		|| engine->current_rate != PICO_DEF_RATE
+		|| engine->current_volume != PICO_DEF_VOL;
+}
+
 static const char *add_properties(TTS_Engine *engine, const char *text)
 {
-	const size_t max_tags_len = 256;
 	size_t new_len;
-	bool set_pitch = (engine->current_pitch != PICO_DEF_PITCH);
-	bool set_rate = (engine->current_rate != PICO_DEF_RATE);
-	bool set_volume = (engine->current_volume != PICO_DEF_VOL);
 	char *new_text = NULL;
-	if (!set_pitch && !set_rate && !set_volume)
+	if (!has_properties(engine))
 		return text;
 
-	new_len = strlen(text) + max_tags_len;
+	new_len = strlen(text) + PROPERTY_TAGS_SIZE;
 	new_text = (char*) malloc(new_len);
 #ifdef _WIN32
 	_snprintf_s(new_text, new_len, _TRUNCATE,
-			 "<speed level='%4d'><pitch level='%4d'><volume level='%4d'>%s</volume></pitch></speed>",
+			 PROPERTY_TAGS_OPEN "%s" PROPERTY_TAGS_CLOSE,
 			 engine->current_rate, engine->current_pitch, engine->current_volume, text);
 #else
 	snprintf(new_text, new_len,
-		"<speed level='%4d'><pitch level='%4d'><volume level='%4d'>%s</volume></pitch></speed>",
+		PROPERTY_TAGS_OPEN "%s" PROPERTY_TAGS_CLOSE,
 		engine->current_rate, engine->current_pitch, engine->current_volume, text);
 #endif
 	return new_text;
 }
 
+static uint64_t now_us(void)
+{
+#ifdef _WIN32
+	LARGE_INTEGER freq, count;
+	QueryPerformanceFrequency(&freq);
+	QueryPerformanceCounter(&count);
+	return (uint64_t) (count.QuadPart * 1000000 / freq.QuadPart);
+#else
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+#endif
+}
+
+static void pull_end(TTS_Engine *engine, int state)
+{
+	free(engine->pull_text);
+	engine->pull_text = NULL;
+	engine->pull_inp = NULL;
+	engine->pull_remaining = 0;
+	engine->pull_state = state;
+	if (state != PULL_NONE) {
+		/* Wake up the poller so it can observe the end of the session. */
+		event_signal(engine);
+	}
+}
+
+/* Consumes a TtsEngine_Stop that came too late to abort the previous
+   utterance, or while the engine was idle. The flag is cleared before the
+   reset ends the cancellation of the Pico engine, so that a Stop coming in
+   meanwhile still aborts the next utterance. */
+static void stop_clear(TTS_Engine *engine)
+{
+	if (picopal_atomic_get(&engine->synthesis_abort_flag)) {
+		picopal_atomic_set(&engine->synthesis_abort_flag, 0);
+		pico_resetEngine(engine->voice->pico_engine, PICO_RESET_UTTERANCE);
+	}
+}
+
+static void event_signal(TTS_Engine *engine)
+{
+#ifdef __linux__
+	uint64_t one = 1;
+	if (engine->event_fd >= 0 && !engine->event_signalled) {
+		if (write(engine->event_fd, &one, sizeof(one)) == sizeof(one)) {
+			engine->event_signalled = true;
+		}
+	}
+#else
+	(void) engine;
+#endif
+}
+
+static void event_clear(TTS_Engine *engine)
+{
+#ifdef __linux__
+	uint64_t count;
+	if (engine->event_fd >= 0 && engine->event_signalled) {
+		if (read(engine->event_fd, &count, sizeof(count)) == sizeof(count)) {
+			engine->event_signalled = false;
+		}
+	}
+#else
+	(void) engine;
+#endif
+}
+
+static void timing_set_taps(TTS_Engine *engine, tts_voice_t *voice)
+{
+	picoext_ItemTapCallback tap = engine->timing_callback ? timing_tap : NULL;
+
+	if (voice->pico_engine) {
+		picoext_setItemTap(voice->pico_engine, PICOEXT_UNIT_SPHO, tap, engine);
+		picoext_setItemTap(voice->pico_engine, PICOEXT_UNIT_PAM, tap, engine);
+	}
+}
+
+static bool timing_reserve(void **buf, size_t *size, size_t need, size_t elem_size)
+{
+	size_t new_size;
+	void *new_buf;
+
+	if (need <= *size) {
+		return true;
+	}
+	new_size = *size ? *size : 64;
+	while (new_size < need) {
+		new_size *= 2;
+	}
+	new_buf = realloc(*buf, new_size * elem_size);
+	if (!new_buf) {
+		return false;
+	}
+	*buf = new_buf;
+	*size = new_size;
+	return true;
+}
+
+static void timing_add_event(TTS_Engine *engine, tts_event_type_t type, uint32_t duration, int phone,
+		const pico_Char *mark, int mark_len)
+{
+	tts_timing_t *t = &engine->timing;
+	tts_event_t *ev;
+	char *name = NULL;
+
+	if (t->ev_tail == t->ev_size && t->ev_head > 0) {
+		memmove(t->events, t->events + t->ev_head, (t->ev_tail - t->ev_head) * sizeof(tts_event_t));
+		t->ev_tail -= t->ev_head;
+		t->ev_head = 0;
+	}
+	if (!timing_reserve((void **) &t->events, &t->ev_size, t->ev_tail + 1, sizeof(tts_event_t))) {
+		return;
+	}
+	if (mark) {
+		name = (char *) malloc(mark_len + 1);
+		if (!name) {
+			return;
+		}
+		memcpy(name, mark, mark_len);
+		name[mark_len] = '\0';
+	}
+	ev = &t->events[t->ev_tail++];
+	ev->type = type;
+	ev->sample = t->sample;
+	ev->duration = duration;
+	ev->word = t->word;
+	ev->phone = phone;
+	ev->mark = name;
+}
+
+static void timing_pam_phone(TTS_Engine *engine, int phone, uint32_t samples)
+{
+	tts_timing_t *t = &engine->timing;
+	uint8_t *word = (t->wp_head < t->wp_stage) ? t->word_phones + t->wp_head : NULL;
+
+	/* a phone that is not the next one of the head word is a pause */
+	if (word && t->word_matched < word[0] && word[1 + t->word_matched] == phone) {
+		if (t->word_matched == 0) {
+			timing_add_event(engine, TTS_EVENT_WORD_START, 0, -1, NULL, 0);
+		}
+		t->word_matched++;
+	} else {
+		word = NULL;
+	}
+	timing_add_event(engine, TTS_EVENT_PHONE, samples, phone, NULL, 0);
+	t->sample += samples;
+	if (word && t->word_matched == word[0]) {
+		timing_add_event(engine, TTS_EVENT_WORD_END, 0, -1, NULL, 0);
+		t->wp_head += 1 + word[0];
+		t->word_matched = 0;
+		t->word++;
+	}
+}
+
+static void timing_spho_syllable(TTS_Engine *engine, const pico_Char *phones, int len)
+{
+	tts_timing_t *t = &engine->timing;
+
+	/* start queueing a word, making room at the front first */
+	if (t->wp_stage == t->wp_tail) {
+		if (t->wp_head > 0) {
+			memmove(t->word_phones, t->word_phones + t->wp_head, t->wp_tail - t->wp_head);
+			t->wp_stage -= t->wp_head;
+			t->wp_tail -= t->wp_head;
+			t->wp_head = 0;
+		}
+		if (!timing_reserve((void **) &t->word_phones, &t->wp_size, t->wp_tail + 1, 1)) {
+			return;
+		}
+		t->word_phones[t->wp_tail++] = 0;
+	}
+	if (len > 255 - t->word_phones[t->wp_stage]
+			|| !timing_reserve((void **) &t->word_phones, &t->wp_size, t->wp_tail + len, 1)) {
+		return;
+	}
+	memcpy(t->word_phones + t->wp_tail, phones, len);
+	t->wp_tail += len;
+	t->word_phones[t->wp_stage] += len;
+}
+
+static void timing_tap(void *user, pico_Int16 unit, const pico_Char *item, pico_Int16 size)
+{
+	TTS_Engine *engine = (TTS_Engine *) user;
+	int len = item[3];
+	pico_Int32 samples;
+
+	if (unit == PICOEXT_UNIT_SPHO) {
+		if (item[0] == PICOEXT_ITEM_SYLLPHON) {
+			timing_spho_syllable(engine, item + PICOEXT_ITEM_HEADSIZE, len);
+		} else if (item[0] == PICOEXT_ITEM_BOUND) {
+			/* the queued word is complete */
+			engine->timing.wp_stage = engine->timing.wp_tail;
+		}
+	} else if (item[0] == PICOEXT_ITEM_PHONE) {
+		if (picoext_getPhoneItemSamples(item, size, &samples) == PICO_OK) {
+			timing_pam_phone(engine, item[1], (uint32_t) samples);
+		}
+	} else if (item[0] == PICOEXT_ITEM_CMD && item[1] == PICOEXT_ITEM_CMD_MARKER) {
+		timing_add_event(engine, TTS_EVENT_MARK, 0, -1, item + PICOEXT_ITEM_HEADSIZE, len);
+	}
+}
+
+static void timing_reset(TTS_Engine *engine)
+{
+	tts_timing_t *t = &engine->timing;
+
+	for (; t->ev_head < t->ev_tail; t->ev_head++) {
+		free((void *) t->events[t->ev_head].mark);
+	}
+	t->ev_head = t->ev_tail = 0;
+	t->wp_head = t->wp_tail = t->wp_stage = 0;
+	t->word_matched = 0;
+	t->word = 0;
+	t->sample = 0;
+	t->delivered = 0;
+}
+
+/* Passes on the events that refer to the audio up to the end of the next
+   'bytes' bytes, or all of them at the end of the utterance. */
+static void timing_deliver(TTS_Engine *engine, size_t bytes, bool final)
+{
+	tts_timing_t *t = &engine->timing;
+	tts_event_t *ev;
+
+	t->delivered += bytes;
+	while (t->ev_head < t->ev_tail) {
+		ev = &t->events[t->ev_head];
+		if (!final && ev->sample >= t->delivered / 2) {
+			break;
+		}
+		if (engine->timing_callback) {
+			engine->timing_callback(engine->timing_user, ev);
+		}
+		free((void *) ev->mark);
+		t->ev_head++;
+	}
+	if (t->ev_head == t->ev_tail) {
+		t->ev_head = t->ev_tail = 0;
+	}
+}
+
+/* Drops the events after the end of the next 'bytes' bytes of audio, which
+   is all there will be of a stopped utterance. */
+static void timing_cut(TTS_Engine *engine, size_t bytes)
+{
+	tts_timing_t *t = &engine->timing;
+	uint32_t end = (uint32_t) ((t->delivered + bytes) / 2);
+	tts_event_t *ev;
+
+	while (t->ev_tail > t->ev_head) {
+		ev = &t->events[t->ev_tail - 1];
+		if (ev->sample < end || (ev->sample == end && ev->type == TTS_EVENT_WORD_END)) {
+			break;
+		}
+		free((void *) ev->mark);
+		t->ev_tail--;
+	}
+}
+
+static void chunk_start(TTS_Engine *engine)
+{
+	engine->chunk_buf = engine->synthesis_buffer;
+	engine->chunk_used = 0;
+	engine->chunk_limit = engine->chunk_first ? engine->chunk_first : SYNTH_BUFFER_SIZE;
+	engine->chunk_total = 0;
+}
+
+/* With a chunk policy, chunks alternate between the two halves of the
+   synthesis buffer, so that the audio of a chunk stays valid while the next
+   one is being synthesized. */
+static void chunk_next(TTS_Engine *engine)
+{
+	engine->chunk_total += engine->chunk_used;
+	engine->chunk_used = 0;
+	if (!engine->chunk_size) {
+		return;
+	}
+	engine->chunk_limit = engine->chunk_size;
+	if (engine->chunk_buf == engine->synthesis_buffer) {
+		engine->chunk_buf = engine->synthesis_buffer + SYNTH_BUFFER_SIZE / 2;
+	} else {
+		engine->chunk_buf = engine->synthesis_buffer;
+	}
+}
+
+static void chunk_pass_rest(TTS_Engine *engine, void *userdata)
+{
+	timing_deliver(engine, engine->chunk_used, false);
+	engine->synth_callback(userdata, PCM_RATE, PCM_DEPTH, PCM_CHANNELS, engine->chunk_buf, engine->chunk_used, false);
+	if (engine->chunk_used > 0) {
+		chunk_next(engine);
+	}
+}
+
+/* Adds samples to the chunk, passing it on to the callback function when it
+   is full. Returns false if the callback asked to stop. */
+static bool chunk_put(TTS_Engine *engine, void *userdata, const void *pcm, size_t bytes)
+{
+	const uint8_t *inp = (const uint8_t *) pcm;
+	size_t copied;
+
+	while (bytes > 0) {
+		copied = engine->chunk_limit - engine->chunk_used;
+		if (bytes < copied) {
+			copied = bytes;
+		}
+		memcpy(engine->chunk_buf + engine->chunk_used, inp, copied);
+		engine->chunk_used += copied;
+		inp += copied;
+		bytes -= copied;
+		if (engine->chunk_used == engine->chunk_limit) {
+			timing_deliver(engine, engine->chunk_used, false);
+			if (!engine->synth_callback(userdata, PCM_RATE, PCM_DEPTH, PCM_CHANNELS,
+					engine->chunk_buf, engine->chunk_used, false)) {
+				return false;
+			}
+			chunk_next(engine);
+		}
+	}
+	return true;
+}
+
+/* Retrieves the samples of the text fed so far and passes them on in chunks,
+   keeping the last, incomplete chunk. Returns the status of the last
+   pico_getData, or of the reset if the synthesis was stopped. */
+static pico_Status synth_drain(TTS_Engine *engine, void *userdata)
+{
+	short       outbuf[MAX_OUTBUF_SIZE/2];
+	pico_Int16  bytes_recv, out_data_type;
+	pico_Status ret;
+
+	do {
+		if (picopal_atomic_get(&engine->synthesis_abort_flag)) {
+			ret = pico_resetEngine(engine->voice->pico_engine, PICO_RESET_UTTERANCE);
+			break;
+		}
+		/* Retrieve the samples and add them to the buffer. */
+		ret = pico_getData(engine->voice->pico_engine, (void *) outbuf, MAX_OUTBUF_SIZE, &bytes_recv,
+						   &out_data_type);
+		if (bytes_recv > 0 && !chunk_put(engine, userdata, outbuf, (size_t) bytes_recv)) {
+			PICO_DBG("Halt requested by caller. Halting.\n");
+			picopal_atomic_set(&engine->synthesis_abort_flag, 1);
+			ret = pico_resetEngine(engine->voice->pico_engine, PICO_RESET_UTTERANCE);
+			break;
+		}
+	} while (PICO_STEP_BUSY == ret);
+
+	return ret;
+}
+
+/* Feeds 'len' bytes of text of the streaming session into the engine and
+   passes on the audio of the sentences they complete. A failure or a stop
+   ends the session. */
+static bool session_feed(TTS_Engine *engine, const char *text, size_t len)
+{
+	pico_Int16  bytes_sent, chunk;
+	pico_Status ret;
+
+	while (len > 0) {
+		if (picopal_atomic_get(&engine->synthesis_abort_flag)) {
+			pico_resetEngine(engine->voice->pico_engine, PICO_RESET_UTTERANCE);
+			session_end(engine, false);
+			return false;
+		}
+		chunk = (pico_Int16) (len > PICO_INT16_MAX ? PICO_INT16_MAX : len);
+		ret = pico_putTextUtf8(engine->voice->pico_engine, (const pico_Char *) text, chunk, &bytes_sent);
+		if (ret != PICO_OK) {
+			PICO_DBG("Error synthesizing string: [%d]\n", ret);
+			session_end(engine, false);
+			return false;
+		}
+		text += bytes_sent;
+		len -= bytes_sent;
+
+		ret = synth_drain(engine, engine->session_user);
+		if (ret != PICO_STEP_IDLE) {
+			if (!picopal_atomic_get(&engine->synthesis_abort_flag)) {
+				PICO_DBG("Error occurred during synthesis [%d]\n", ret);
+				pico_resetEngine(engine->voice->pico_engine, PICO_RESET_SOFT);
+			}
+			session_end(engine, false);
+			return false;
+		}
+		/* Pass on the end of a sentence right away. */
+		if (engine->chunk_used > 0) {
+			chunk_pass_rest(engine, engine->session_user);
+		}
+	}
+	return true;
+}
+
+static void session_end(TTS_Engine *engine, bool completed)
+{
+	if (completed) {
+		timing_deliver(engine, engine->chunk_used, true);
+	} else {
+		engine->chunk_used = 0;
+	}
+	engine->synth_callback(engine->session_user, PCM_RATE, PCM_DEPTH, PCM_CHANNELS,
+			engine->chunk_buf, engine->chunk_used, true);
+	engine->session_open = false;
+	engine->session_user = NULL;
+	timing_reset(engine);
+}
+
+/* Builds the text synthesized for 'slot' holding 'value': the last word of
+   the static part before it and the first word after it, or the whole
+   template with the slot names as placeholders for slot -1. */
+static char *template_text(const TTS_Template *tpl, int slot, const char *value)
+{
+	const char *left, *right, *right_end;
+	char *text;
+	size_t len;
+	int i;
+
+	if (slot < 0) {
+		len = strlen(tpl->parts[0]) + 1;
+		for (i = 0; i < tpl->num_slots; i++) {
+			len += strlen(tpl->names[i]) + strlen(tpl->parts[i + 1]) + 2 * TEMPLATE_MARK_SIZE;
+		}
+		text = (char *) malloc(len);
+		if (!text) {
+			return NULL;
+		}
+		strcpy(text, tpl->parts[0]);
+		for (i = 0; i < tpl->num_slots; i++) {
+			len = strlen(text);
+			sprintf(text + len, "<mark name='a%d'/>%s<mark name='b%d'/>%s", i, tpl->names[i], i, tpl->parts[i + 1]);
+		}
+		return text;
+	}
+
+	/* the last word before the slot, with the spaces after it */
+	left = tpl->parts[slot] + strlen(tpl->parts[slot]);
+	while (left > tpl->parts[slot] && (unsigned char) left[-1] <= ' ') {
+		left--;
+	}
+	while (left > tpl->parts[slot] && (unsigned char) left[-1] > ' ') {
+		left--;
+	}
+	/* the first word after the slot, with the spaces before it */
+	right = tpl->parts[slot + 1];
+	right_end = right;
+	while (*right_end && (unsigned char) *right_end <= ' ') {
+		right_end++;
+	}
+	while (*right_end && (unsigned char) *right_end > ' ') {
+		right_end++;
+	}
+
+	len = strlen(left) + strlen(value) + (size_t) (right_end - right) + 2 * TEMPLATE_MARK_SIZE;
+	text = (char *) malloc(len);
+	if (text) {
+		sprintf(text, "%s<mark name='a0'/>%s<mark name='b0'/>%.*s", left, value, (int) (right_end - right), right);
+	}
+	return text;
+}
+
+/* Renders the static text of 'tpl' with the current voice and settings. */
+static bool template_render(TTS_Engine *engine, TTS_Template *tpl)
+{
+	tts_capture_t cap;
+	char *text;
+	const char *local_text;
+	bool ok;
+	int i;
+
+	if (!engine->voice->pico_engine || !engine->voice->language) {
+		PICO_DBG("No language loaded\n");
+		return false;
+	}
+	text = template_text(tpl, -1, NULL);
+	if (!text) {
+		return false;
+	}
+	local_text = add_properties(engine, text);
+
+	memset(&cap, 0, sizeof(cap));
+	cap.marks = tpl->cuts;
+	cap.num_slots = tpl->num_slots;
+	for (i = 0; i < 2 * tpl->num_slots; i++) {
+		tpl->cuts[i] = (size_t) -1;
+	}
+	ok = synth_capture(engine, local_text, &cap);
+	for (i = 0; ok && i < 2 * tpl->num_slots; i++) {
+		ok = tpl->cuts[i] <= cap.samples && (i == 0 || tpl->cuts[i - 1] <= tpl->cuts[i]);
+	}
+	if (local_text != text) {
+		free((void *) local_text);
+	}
+	free(text);
+	if (!ok) {
+		PICO_DBG("Rendering the template failed\n");
+		free(cap.pcm);
+		return false;
+	}
+
+	free(tpl->pcm);
+	tpl->pcm = cap.pcm;
+	tpl->samples = cap.samples;
+	free(tpl->language);
+	tpl->language = strdup(engine->voice->language);
+	tpl->rate = engine->current_rate;
+	tpl->pitch = engine->current_pitch;
+	tpl->volume = engine->current_volume;
+	return true;
+}
+
+/* Passes on 'n' samples fading from 'from' to 'to'. */
+static bool template_crossfade(TTS_Engine *engine, void *userdata, const int16_t *from, const int16_t *to, size_t n)
+{
+	int16_t mix[TEMPLATE_XFADE];
+	size_t i;
+
+	for (i = 0; i < n; i++) {
+		mix[i] = (int16_t) (((int32_t) from[i] * (int32_t) (n - i) + (int32_t) to[i] * (int32_t) i) / (int32_t) n);
+	}
+	return chunk_put(engine, userdata, mix, n * sizeof(int16_t));
+}
+
+/* Synthesizes 'text' into the PCM of 'cap' instead of passing it on, and
+   notes the positions of its marks. Timing events are not reported. */
+static bool synth_capture(TTS_Engine *engine, const char *text, tts_capture_t *cap)
+{
+	tts_event_callback_t timing_callback = engine->timing_callback;
+	void *      timing_user = engine->timing_user;
+	const char *inp = text;
+	size_t      remaining = strlen(text) + 1;
+	pico_Int16  bytes_sent, bytes_recv, out_data_type, chunk;
+	pico_Status ret;
+	bool        ok = true;
+
+	engine->timing_callback = capture_event;
+	engine->timing_user = cap;
+	timing_set_taps(engine, engine->voice);
+	timing_reset(engine);
+
+	while (ok && remaining > 0) {
+		chunk = (pico_Int16) (remaining > PICO_INT16_MAX ? PICO_INT16_MAX : remaining);
+		ret = pico_putTextUtf8(engine->voice->pico_engine, (const pico_Char *) inp, chunk, &bytes_sent);
+		if (ret != PICO_OK) {
+			PICO_DBG("Error synthesizing string: [%d]\n", ret);
+			ok = false;
+			break;
+		}
+		inp += bytes_sent;
+		remaining -= bytes_sent;
+		do {
+			if (picopal_atomic_get(&engine->synthesis_abort_flag)
+					|| !timing_reserve((void **) &cap->pcm, &cap->size, cap->samples + MAX_OUTBUF_SIZE / 2, sizeof(int16_t))) {
+				ok = false;
+				break;
+			}
+			ret = pico_getData(engine->voice->pico_engine, (void *) (cap->pcm + cap->samples), MAX_OUTBUF_SIZE,
+							   &bytes_recv, &out_data_type);
+			cap->samples += bytes_recv / sizeof(int16_t);
+		} while (ret == PICO_STEP_BUSY);
+		if (ok && ret != PICO_STEP_IDLE) {
+			PICO_DBG("Error occurred during synthesis [%d]\n", ret);
+			ok = false;
+		}
+	}
+
+	if (ok) {
+		timing_deliver(engine, 0, true);
+	} else {
+		pico_resetEngine(engine->voice->pico_engine, PICO_RESET_UTTERANCE);
+	}
+	timing_reset(engine);
+	engine->timing_callback = timing_callback;
+	engine->timing_user = timing_user;
+	timing_set_taps(engine, engine->voice);
+	return ok;
+}
+
+static void capture_event(void *user, const tts_event_t *event)
+{
+	tts_capture_t *cap = (tts_capture_t *) user;
+	int slot;
+
+	if (event->type != TTS_EVENT_MARK || (event->mark[0] != 'a' && event->mark[0] != 'b')) {
+		return;
+	}
+	slot = atoi(event->mark + 1);
+	if (slot >= 0 && slot < cap->num_slots) {
+		cap->marks[2 * slot + (event->mark[0] == 'b')] = event->sample;
+	}
+}
+
 static int clamp(int val, int min_val, int max_val)
 {
 	if (val < min_val) {
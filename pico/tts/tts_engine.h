@@ -24,13 +24,56 @@ extern "C" {
 struct sTTS_Engine;
 typedef struct sTTS_Engine TTS_Engine;
 
+struct sTTS_Template;
+typedef struct sTTS_Template TTS_Template;
+
 // Callback used to return audio chunks as they are being synthesized.
 // Return false to stop the synthesis or true to continue.
 typedef bool (*tts_callback_t)(void *user, uint32_t rate, uint32_t format, int channels, uint8_t *audio, uint32_t audio_bytes, bool final);
 
-// Create TextToSpeech engine handle
+// Result of TtsEngine_Pump
+typedef enum {
+	TTS_PUMP_ERROR = -1,	// synthesis failed; the pull session is over
+	TTS_PUMP_IDLE = 0,	// no pull session in progress
+	TTS_PUMP_BUSY,		// more work to do; call TtsEngine_Pump again
+	TTS_PUMP_FULL,		// PCM buffer is full; call TtsEngine_Read before pumping again
+	TTS_PUMP_DONE		// synthesis finished; remaining PCM can be read
+} tts_pump_status_t;
+
+// Timing events, see TtsEngine_SetEventCallback
+typedef enum {
+	TTS_EVENT_WORD_START,	// first sample of a word
+	TTS_EVENT_WORD_END,	// sample after the last one of a word
+	TTS_EVENT_PHONE,	// first sample of a phone (including pauses)
+	TTS_EVENT_MARK		// position of a <mark name='...'/> in the text
+} tts_event_type_t;
+
+typedef struct {
+	tts_event_type_t type;
+	uint32_t sample;	// offset in 16 kHz samples from the start of the utterance
+	uint32_t duration;	// TTS_EVENT_PHONE: length in samples
+	int word;		// TTS_EVENT_WORD_*: index of the spoken word in the utterance
+	int phone;		// TTS_EVENT_PHONE: phone id of the voice
+	const char *mark;	// TTS_EVENT_MARK: name of the mark, valid during the callback
+} tts_event_t;
+
+typedef void (*tts_event_callback_t)(void *user, const tts_event_t *event);
+
+// Create TextToSpeech engine handle. 'cb' may be NULL if the engine is only
+// used through the pull API (TtsEngine_Begin/Pump/Read).
 TTS_Engine *TtsEngine_Create(const char *lang_dir, const char *language, tts_callback_t cb);
 
+// Create an engine with Pico engines for up to 8 languages instantiated up
+// front on one shared Pico system; 'languages[0]' is selected.
+TTS_Engine *TtsEngine_CreateMulti(const char *lang_dir, const char *const *languages, int num_languages, tts_callback_t cb);
+
+// Select the language of the following utterances. Switching to a language
+// the engine was created with is immediate; any other language replaces the
+// selected one, which reloads lingware. Fails while a pull session runs.
+bool TtsEngine_SetLanguage(TTS_Engine *engine, const char *language);
+
+const char *TtsEngine_GetLanguage(const TTS_Engine *engine);
+
 int TtsEngine_SetRate(TTS_Engine *engine, int rate);
 
 int TtsEngine_GetRate(const TTS_Engine *engine);
@@ -43,10 +86,93 @@ int TtsEngine_SetVolume(TTS_Engine *engine, int vol);
 
 int TtsEngine_GetVolume(const TTS_Engine *engine);
 
+// Abort the current TtsEngine_Speak or pull session. May be called from
+// another thread: it also cancels the synthesis step in progress, so that
+// no more audio is produced even in the middle of a long sentence.
 void TtsEngine_Stop(TTS_Engine *engine);
 
+// Report the timing of words, phones and marks of the following utterances
+// to 'cb' (NULL to stop). The timing is taken from the synthesis itself.
+// Events come in order and are delivered just before the audio they refer
+// to: by TtsEngine_Speak before the audio callback of the chunk holding
+// their sample, by TtsEngine_Read before it returns that audio. Events at
+// the very end of the utterance come with the final chunk or the last read.
+void TtsEngine_SetEventCallback(TTS_Engine *engine, tts_event_callback_t cb, void *user);
+
+// Set how TtsEngine_Speak cuts the audio into callbacks: the first chunk is
+// passed on as soon as 'min_ms' of audio exist and the following ones every
+// 'max_ms' (at most 2048 ms), besides the remainder at the end of the text.
+// The audio of a chunk then stays valid until the callback of the next chunk
+// returns. Both 0 (the default) fill the whole 4 s buffer before a callback.
+void TtsEngine_SetChunking(TTS_Engine *engine, int min_ms, int max_ms);
+
 bool TtsEngine_Speak(TTS_Engine *engine, const char *text, void *userdata);
 
+// Streaming session: speaks text that arrives piece by piece, e.g. token by
+// token from a text generator. TtsEngine_Open starts the session with the
+// current rate, pitch and volume; each TtsEngine_Append feeds its text and
+// passes the audio of the sentences it completes to the audio callback with
+// 'userdata' before it returns. TtsEngine_Finish speaks the rest and sends
+// the final callback. With a 'flush_ms' other than 0, text that has waited
+// that long since the previous sentence for its sentence end is spoken as
+// a phrase when an append ends at a word (after a space or ,;:), much as
+// TtsEngine_Flush does. The timeout is checked by TtsEngine_Append and
+// TtsEngine_Poll only, so a caller whose text may stall must call
+// TtsEngine_Poll while idle, e.g. every 'flush_ms'. A failure or
+// TtsEngine_Stop ends the session with a final callback and makes the call
+// return false. Speak, the pull API and language switches are refused while
+// a session is open.
+bool TtsEngine_Open(TTS_Engine *engine, uint32_t flush_ms, void *userdata);
+
+bool TtsEngine_Append(TTS_Engine *engine, const char *text);
+
+// Speak the text waiting for its sentence end as a phrase if the flush
+// timeout of the session has passed and the last append ended at a word.
+bool TtsEngine_Poll(TTS_Engine *engine);
+
+// Speak the text appended so far as a sentence of its own.
+bool TtsEngine_Flush(TTS_Engine *engine);
+
+bool TtsEngine_Finish(TTS_Engine *engine);
+
+// Template prompts: text such as "Your train to {city} leaves at {time}."
+// whose static parts are synthesized once, by TtsEngine_CreateTemplate with
+// the slot names as placeholders, and cached. TtsEngine_SpeakTemplate then
+// synthesizes only the values of the slots (one per slot, in order), each
+// together with the words next to it so that it takes the prosody of its
+// place, and splices them into the cached audio with a short crossfade.
+// The static audio is synthesized again when the language, rate, pitch or
+// volume has changed. Timing events are not reported for templates.
+// Slot names and values are plain text: since the engine has no escapes for
+// its markup, a name or value containing '<' is refused.
+TTS_Template *TtsEngine_CreateTemplate(TTS_Engine *engine, const char *pattern);
+
+int TtsEngine_GetTemplateSlots(const TTS_Template *tpl);
+
+bool TtsEngine_SpeakTemplate(TTS_Engine *engine, TTS_Template *tpl, const char *const *values, void *userdata);
+
+void TtsEngine_DestroyTemplate(TTS_Template *tpl);
+
+// Pull API: a non-blocking alternative to TtsEngine_Speak for event loops.
+// TtsEngine_Begin queues 'text' and returns immediately. Each call to
+// TtsEngine_Pump then performs synthesis steps for at most 'budget_us'
+// microseconds (0 = until the PCM buffer is full or synthesis is done) and
+// TtsEngine_Read drains the synthesized 16 kHz 16-bit mono PCM.
+// TtsEngine_Stop aborts a pull session as well. TtsEngine_Speak, streaming
+// sessions and templates are refused until the pull session is done or stopped.
+bool TtsEngine_Begin(TTS_Engine *engine, const char *text);
+
+tts_pump_status_t TtsEngine_Pump(TTS_Engine *engine, uint32_t budget_us);
+
+uint32_t TtsEngine_Read(TTS_Engine *engine, uint8_t *audio, uint32_t max_bytes);
+
+uint32_t TtsEngine_Available(const TTS_Engine *engine);
+
+// Returns a non-blocking eventfd that is readable while PCM is buffered or
+// the pull session has finished, or -1 where eventfd is not available.
+// The descriptor is owned by the engine; do not read from or close it.
+int TtsEngine_GetEventFd(const TTS_Engine *engine);
+
 void TtsEngine_Destroy(TTS_Engine *engine);
 
 #ifdef __cplusplus
@@ -0,0 +1,319 @@
+#include "tts_sched.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <assert.h>
+#include <pthread.h>
+#include <time.h>
+
+#if 0 // enable for debugging
+#define SCHED_DBG(...) fprintf(stderr, __VA_ARGS__)
+#else
+#define SCHED_DBG(...)
+#endif
+
+struct sTTS_SchedJob {
+	TTS_Scheduler * sched;
+	TTS_Engine *    engine;
+	pthread_mutex_t lock;		/* serializes access to the engine */
+	/* fields below are guarded by sched->lock */
+	tts_pump_status_t status;
+	uint32_t        buffered;	/* PCM bytes queued in the engine */
+	uint64_t        seq;		/* submission order, breaks ties */
+	uint64_t        cpu_us;
+	uint32_t        slice_us;	/* budget per slice, 0 = the scheduler's */
+	uint64_t        reads;		/* bumped by every read that freed space */
+	bool            running;
+	TTS_SchedJob *  next;
+};
+
+struct sTTS_Scheduler {
+	pthread_mutex_t lock;
+	pthread_cond_t  wake;		/* a job became runnable, or shutdown */
+	pthread_cond_t  idle;		/* a job finished its slice */
+	pthread_t *     workers;
+	int             num_workers;
+	uint32_t        slice_us;
+	bool            shutdown;
+	uint64_t        next_seq;
+	TTS_SchedJob *  jobs;
+};
+
+static uint64_t now_us(void);
+static void *worker_main(void *arg);
+static TTS_SchedJob *pick_job(TTS_Scheduler *sched);
+
+TTS_Scheduler *TtsScheduler_Create(int num_workers, uint32_t slice_us)
+{
+	TTS_Scheduler *sched = NULL;
+	int i;
+
+	if (num_workers <= 0 || slice_us == 0) {
+		SCHED_DBG("%s: Invalid parameter\n", __FUNCTION__);
+		return NULL;
+	}
+
+	sched = (TTS_Scheduler *) calloc(1, sizeof(TTS_Scheduler));
+	if (!sched) {
+		return NULL;
+	}
+	sched->slice_us = slice_us;
+	sched->workers = (pthread_t *) calloc(num_workers, sizeof(pthread_t));
+	if (!sched->workers) {
+		free(sched);
+		return NULL;
+	}
+	pthread_mutex_init(&sched->lock, NULL);
+	pthread_cond_init(&sched->wake, NULL);
+	pthread_cond_init(&sched->idle, NULL);
+
+	for (i = 0; i < num_workers; i++) {
+		if (pthread_create(&sched->workers[i], NULL, worker_main, sched) != 0) {
+			SCHED_DBG("Failed to start worker %d\n", i);
+			break;
+		}
+		sched->num_workers++;
+	}
+
+	if (sched->num_workers == 0) {
+		TtsScheduler_Destroy(sched);
+		return NULL;
+	}
+	return sched;
+}
+
+TTS_SchedJob *TtsScheduler_Submit(TTS_Scheduler *sched, TTS_Engine *engine, const char *text)
+{
+	TTS_SchedJob *job = NULL;
+
+	assert(sched);
+	assert(engine);
+	assert(text);
+
+	/* Allocate first: a failure after TtsEngine_Begin would leave the
+	   engine in a pull session nobody ends. */
+	job = (TTS_SchedJob *) calloc(1, sizeof(TTS_SchedJob));
+	if (!job) {
+		return NULL;
+	}
+	if (!TtsEngine_Begin(engine, text)) {
+		free(job);
+		return NULL;
+	}
+	job->sched = sched;
+	job->engine = engine;
+	job->status = TTS_PUMP_BUSY;
+	pthread_mutex_init(&job->lock, NULL);
+
+	pthread_mutex_lock(&sched->lock);
+	job->seq = sched->next_seq++;
+	job->next = sched->jobs;
+	sched->jobs = job;
+	pthread_cond_signal(&sched->wake);
+	pthread_mutex_unlock(&sched->lock);
+	return job;
+}
+
+uint32_t TtsScheduler_Read(TTS_SchedJob *job, uint8_t *audio, uint32_t max_bytes)
+{
+	TTS_Scheduler *sched;
+	uint32_t got, left;
+
+	assert(job);
+	sched = job->sched;
+
+	pthread_mutex_lock(&job->lock);
+	got = TtsEngine_Read(job->engine, audio, max_bytes);
+	left = TtsEngine_Available(job->engine);
+	pthread_mutex_unlock(&job->lock);
+
+	pthread_mutex_lock(&sched->lock);
+	job->buffered = left;
+	if (got) {
+		job->reads++;
+	}
+	if (got && job->status == TTS_PUMP_FULL) {
+		/* There is room again; let the job run. */
+		job->status = TTS_PUMP_BUSY;
+		pthread_cond_signal(&sched->wake);
+	}
+	pthread_mutex_unlock(&sched->lock);
+	return got;
+}
+
+tts_pump_status_t TtsScheduler_GetStatus(TTS_SchedJob *job)
+{
+	tts_pump_status_t status;
+
+	assert(job);
+	pthread_mutex_lock(&job->sched->lock);
+	status = job->status;
+	pthread_mutex_unlock(&job->sched->lock);
+	return status;
+}
+
+void TtsScheduler_SetSlice(TTS_SchedJob *job, uint32_t slice_us)
+{
+	assert(job);
+	pthread_mutex_lock(&job->sched->lock);
+	job->slice_us = slice_us;
+	pthread_mutex_unlock(&job->sched->lock);
+}
+
+uint64_t TtsScheduler_GetCpuTime(TTS_SchedJob *job)
+{
+	uint64_t cpu_us;
+
+	assert(job);
+	pthread_mutex_lock(&job->sched->lock);
+	cpu_us = job->cpu_us;
+	pthread_mutex_unlock(&job->sched->lock);
+	return cpu_us;
+}
+
+void TtsScheduler_Cancel(TTS_SchedJob *job)
+{
+	TTS_Scheduler *sched;
+
+	assert(job);
+	sched = job->sched;
+
+	/* Not under job->lock, which a worker holds for a whole slice: Stop only
+	   sets the abort tokens and so cuts that slice short. */
+	TtsEngine_Stop(job->engine);
+
+	/* The abort is carried out by the next slice, even if the buffer is full. */
+	pthread_mutex_lock(&sched->lock);
+	if (job->status == TTS_PUMP_FULL) {
+		job->status = TTS_PUMP_BUSY;
+	}
+	pthread_cond_signal(&sched->wake);
+	pthread_mutex_unlock(&sched->lock);
+}
+
+void TtsScheduler_Release(TTS_SchedJob *job)
+{
+	TTS_Scheduler *sched;
+	TTS_SchedJob **pp;
+
+	if (!job) {
+		return;
+	}
+	sched = job->sched;
+
+	pthread_mutex_lock(&sched->lock);
+	/* Unlink first so no worker picks the job again, then wait for its current slice. */
+	for (pp = &sched->jobs; *pp; pp = &(*pp)->next) {
+		if (*pp == job) {
+			*pp = job->next;
+			break;
+		}
+	}
+	while (job->running) {
+		pthread_cond_wait(&sched->idle, &sched->lock);
+	}
+	pthread_mutex_unlock(&sched->lock);
+
+	if (job->status == TTS_PUMP_BUSY || job->status == TTS_PUMP_FULL) {
+		TtsEngine_Stop(job->engine);
+		TtsEngine_Pump(job->engine, 0);
+	}
+
+	pthread_mutex_destroy(&job->lock);
+	free(job);
+}
+
+void TtsScheduler_Destroy(TTS_Scheduler *sched)
+{
+	int i;
+
+	if (!sched) {
+		return;
+	}
+
+	pthread_mutex_lock(&sched->lock);
+	assert(!sched->jobs);
+	sched->shutdown = true;
+	pthread_cond_broadcast(&sched->wake);
+	pthread_mutex_unlock(&sched->lock);
+
+	for (i = 0; i < sched->num_workers; i++) {
+		pthread_join(sched->workers[i], NULL);
+	}
+
+	pthread_cond_destroy(&sched->idle);
+	pthread_cond_destroy(&sched->wake);
+	pthread_mutex_destroy(&sched->lock);
+	free(sched->workers);
+	free(sched);
+}
+
+static uint64_t now_us(void)
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t) ts.tv_sec * 1000000 + (uint64_t) ts.tv_nsec / 1000;
+}
+
+/* Earliest deadline first: the job with the least audio queued runs dry first.
+   Must be called with sched->lock held. */
+static TTS_SchedJob *pick_job(TTS_Scheduler *sched)
+{
+	TTS_SchedJob *job, *best = NULL;
+
+	for (job = sched->jobs; job; job = job->next) {
+		if (job->running || job->status != TTS_PUMP_BUSY) {
+			continue;
+		}
+		if (!best || job->buffered < best->buffered ||
+			(job->buffered == best->buffered && job->seq < best->seq)) {
+			best = job;
+		}
+	}
+	return best;
+}
+
+static void *worker_main(void *arg)
+{
+	TTS_Scheduler *sched = (TTS_Scheduler *) arg;
+	TTS_SchedJob *job;
+	tts_pump_status_t status;
+	uint32_t buffered;
+	uint64_t start, elapsed, reads;
+	uint32_t slice_us;
+
+	pthread_mutex_lock(&sched->lock);
+	while (!sched->shutdown) {
+		job = pick_job(sched);
+		if (!job) {
+			pthread_cond_wait(&sched->wake, &sched->lock);
+			continue;
+		}
+		job->running = true;
+		reads = job->reads;
+		slice_us = job->slice_us ? job->slice_us : sched->slice_us;
+		pthread_mutex_unlock(&sched->lock);
+
+		start = now_us();
+		pthread_mutex_lock(&job->lock);
+		status = TtsEngine_Pump(job->engine, slice_us);
+		buffered = TtsEngine_Available(job->engine);
+		pthread_mutex_unlock(&job->lock);
+		elapsed = now_us() - start;
+
+		pthread_mutex_lock(&sched->lock);
+		job->running = false;
+		job->cpu_us += elapsed;
+		if (job->reads == reads) {
+			job->buffered = buffered;
+			job->status = status;
+		} else {
+			/* The reader drained PCM meanwhile: its view of the buffer is newer. */
+			job->status = (status == TTS_PUMP_FULL) ? TTS_PUMP_BUSY : status;
+		}
+		SCHED_DBG("job %llu: status %d, %u bytes buffered\n", (unsigned long long) job->seq, status, buffered);
+		pthread_cond_broadcast(&sched->idle);
+	}
+	pthread_mutex_unlock(&sched->lock);
+	return NULL;
+}
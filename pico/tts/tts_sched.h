@@ -0,0 +1,60 @@
+#ifndef TTS_SCHED_H
+#define TTS_SCHED_H
+
+#include "tts_engine.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// Cooperative scheduler that time-slices many TTS engines over a small pool of
+// worker threads (POSIX threads only). Each submitted job runs on its own
+// engine through the pull API; workers repeatedly pick the runnable job with
+// the least buffered audio - i.e. the one closest to an audio underrun - and
+// pump it for one slice. Long documents therefore cannot starve short prompts,
+// and streams that already have plenty of audio queued yield to those that
+// are about to run dry.
+
+struct sTTS_Scheduler;
+typedef struct sTTS_Scheduler TTS_Scheduler;
+
+struct sTTS_SchedJob;
+typedef struct sTTS_SchedJob TTS_SchedJob;
+
+// Create a scheduler with 'num_workers' threads, each running jobs for at most
+// 'slice_us' microseconds at a time unless a job has a slice of its own.
+TTS_Scheduler *TtsScheduler_Create(int num_workers, uint32_t slice_us);
+
+// Start synthesizing 'text' on 'engine'. The engine must not be used by the
+// caller until the job is released.
+TTS_SchedJob *TtsScheduler_Submit(TTS_Scheduler *sched, TTS_Engine *engine, const char *text);
+
+// Non-blocking read of synthesized PCM; the job is throttled while its
+// engine's buffer is full, so consumers must keep reading.
+uint32_t TtsScheduler_Read(TTS_SchedJob *job, uint8_t *audio, uint32_t max_bytes);
+
+// TTS_PUMP_BUSY or TTS_PUMP_FULL while running, TTS_PUMP_DONE or
+// TTS_PUMP_ERROR once finished (buffered PCM may still be read).
+tts_pump_status_t TtsScheduler_GetStatus(TTS_SchedJob *job);
+
+// Give this job its own CPU budget of 'slice_us' microseconds per slice, e.g.
+// a short one for an interactive prompt so that it yields often or a long one
+// for a batch document; 0 restores the scheduler's slice.
+void TtsScheduler_SetSlice(TTS_SchedJob *job, uint32_t slice_us);
+
+// Microseconds of worker time spent on this job so far.
+uint64_t TtsScheduler_GetCpuTime(TTS_SchedJob *job);
+
+void TtsScheduler_Cancel(TTS_SchedJob *job);
+
+// Stop the job if still running and hand the engine back to the caller.
+void TtsScheduler_Release(TTS_SchedJob *job);
+
+// Joins the workers; all jobs must have been released.
+void TtsScheduler_Destroy(TTS_Scheduler *sched);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,239 @@
+#ifndef TTS_STREAM_HPP
+#define TTS_STREAM_HPP
+
+// Header-only C++20 coroutine front-end for streaming synthesis.
+//
+// pico::synthesize() turns pico_putTextUtf8/pico_getData into an async
+// generator of PCM chunks (16 kHz, 16-bit mono). Each resumption performs only
+// the synthesis steps needed to fill one chunk and then hands control back, so
+// many streams can be interleaved on a single event-loop thread:
+//
+//     pico::SynthesisStream stream = pico::synthesize(engine, "Hello world.");
+//     while (auto pcm = co_await stream.next()) {
+//         co_await write_audio(*pcm);
+//     }
+//
+// Frameworks whose coroutine types restrict what may be awaited (for example
+// asio::awaitable) can drive the same stream synchronously with try_next()
+// and yield to their executor between chunks.
+//
+// A span returned by next()/try_next() stays valid until the stream is
+// resumed again. cancel() - or destroying an unfinished stream - flushes the
+// engine with pico_resetEngine(PICO_RESET_SOFT). The engine must not be used
+// by anybody else while a stream on it is alive.
+
+#include <picoapi.h>
+#include <picodefs.h>
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace pico {
+
+using PcmSpan = std::span<const int16_t>;
+
+class SynthesisStream {
+public:
+	struct promise_type;
+	using handle_type = std::coroutine_handle<promise_type>;
+
+	// Resumes whoever asked for the next chunk: the awaiting coroutine, or the
+	// caller of try_next() when driven synchronously.
+	struct yield_awaiter {
+		promise_type *promise = nullptr;
+
+		bool await_ready() const noexcept { return false; }
+		std::coroutine_handle<> await_suspend(handle_type h) noexcept
+		{
+			promise = &h.promise();
+			std::coroutine_handle<> consumer = std::exchange(promise->consumer, nullptr);
+			return consumer ? consumer : std::noop_coroutine();
+		}
+		// Returns false if the stream was cancelled while suspended.
+		bool await_resume() const noexcept { return !promise->cancelled; }
+	};
+
+	// Gives the generator body access to its own promise without suspending.
+	struct get_promise {
+		promise_type *promise = nullptr;
+
+		bool await_ready() const noexcept { return false; }
+		bool await_suspend(handle_type h) noexcept
+		{
+			promise = &h.promise();
+			return false;
+		}
+		promise_type &await_resume() const noexcept { return *promise; }
+	};
+
+	struct promise_type {
+		PcmSpan current;
+		std::coroutine_handle<> consumer;
+		bool cancelled = false;
+		pico_Status status = PICO_OK;
+
+		SynthesisStream get_return_object() { return SynthesisStream(handle_type::from_promise(*this)); }
+		std::suspend_always initial_suspend() const noexcept { return {}; }
+		yield_awaiter final_suspend() const noexcept { return {}; }
+		yield_awaiter yield_value(PcmSpan pcm) noexcept
+		{
+			current = pcm;
+			return {};
+		}
+		void return_void() noexcept { current = {}; }
+		void unhandled_exception() { throw; }
+	};
+
+	struct next_awaiter {
+		handle_type gen;
+
+		bool await_ready() const noexcept { return !gen || gen.done(); }
+		std::coroutine_handle<> await_suspend(std::coroutine_handle<> consumer) noexcept
+		{
+			gen.promise().consumer = consumer;
+			return gen;
+		}
+		std::optional<PcmSpan> await_resume() const noexcept
+		{
+			if (!gen || gen.done()) {
+				return std::nullopt;
+			}
+			return gen.promise().current;
+		}
+	};
+
+	SynthesisStream() = default;
+	SynthesisStream(SynthesisStream &&other) noexcept : gen_(std::exchange(other.gen_, nullptr)) {}
+	SynthesisStream &operator=(SynthesisStream &&other) noexcept
+	{
+		if (this != &other) {
+			destroy();
+			gen_ = std::exchange(other.gen_, nullptr);
+		}
+		return *this;
+	}
+	SynthesisStream(const SynthesisStream &) = delete;
+	SynthesisStream &operator=(const SynthesisStream &) = delete;
+	~SynthesisStream() { destroy(); }
+
+	// co_await stream.next() yields the next PCM chunk, or std::nullopt once
+	// synthesis is finished, cancelled or failed (see status()).
+	next_awaiter next() noexcept { return next_awaiter{gen_}; }
+
+	// Synchronous variant of next() for callers that cannot co_await it.
+	std::optional<PcmSpan> try_next()
+	{
+		if (!gen_ || gen_.done()) {
+			return std::nullopt;
+		}
+		gen_.resume();
+		return next_awaiter{gen_}.await_resume();
+	}
+
+	// Stops synthesis; the next call to next()/try_next() returns std::nullopt.
+	void cancel() noexcept
+	{
+		if (gen_) {
+			gen_.promise().cancelled = true;
+		}
+	}
+
+	bool done() const noexcept { return !gen_ || gen_.done(); }
+
+	// PICO_OK, or the pico status code that ended the stream early.
+	pico_Status status() const noexcept { return gen_ ? gen_.promise().status : PICO_OK; }
+
+private:
+	explicit SynthesisStream(handle_type gen) : gen_(gen) {}
+
+	void destroy() noexcept
+	{
+		if (gen_) {
+			gen_.destroy();
+			gen_ = nullptr;
+		}
+	}
+
+	handle_type gen_;
+};
+
+namespace detail {
+
+// Flushes the engine unless synthesis ran to completion.
+struct SoftResetGuard {
+	pico_Engine engine;
+	bool armed = true;
+
+	~SoftResetGuard()
+	{
+		if (armed) {
+			pico_resetEngine(engine, PICO_RESET_SOFT);
+		}
+	}
+};
+
+} // namespace detail
+
+// Synthesizes 'text' on 'engine', yielding chunks of 'chunk_samples' samples
+// (the last chunk may be shorter). 'text' is copied into the coroutine frame.
+inline SynthesisStream synthesize(pico_Engine engine, std::string text, std::size_t chunk_samples = 1600)
+{
+	SynthesisStream::promise_type &promise = co_await SynthesisStream::get_promise{};
+	detail::SoftResetGuard guard{engine};
+	std::vector<int16_t> pcm;
+	int16_t outbuf[64];
+	const pico_Char *inp = reinterpret_cast<const pico_Char *>(text.c_str());
+	std::size_t remaining = text.size() + 1;
+	pico_Int16 bytes_sent, bytes_recv, out_data_type;
+	pico_Status ret;
+
+	if (chunk_samples == 0) {
+		chunk_samples = 1;
+	}
+	pcm.reserve(chunk_samples + sizeof(outbuf) / sizeof(outbuf[0]));
+
+	while (remaining) {
+		if (promise.cancelled) {
+			co_return;
+		}
+		ret = pico_putTextUtf8(engine, inp,
+				(pico_Int16) (remaining > PICO_INT16_MAX ? PICO_INT16_MAX : remaining), &bytes_sent);
+		if (ret != PICO_OK) {
+			promise.status = ret;
+			co_return;
+		}
+		inp += bytes_sent;
+		remaining -= bytes_sent;
+
+		do {
+			ret = pico_getData(engine, outbuf, (pico_Int16) sizeof(outbuf), &bytes_recv, &out_data_type);
+			pcm.insert(pcm.end(), outbuf, outbuf + bytes_recv / sizeof(outbuf[0]));
+			if (pcm.size() >= chunk_samples) {
+				if (!(co_yield PcmSpan(pcm))) {
+					co_return;
+				}
+				pcm.clear();
+			}
+		} while (ret == PICO_STEP_BUSY);
+
+		if (ret != PICO_STEP_IDLE) {
+			promise.status = ret;
+			co_return;
+		}
+	}
+
+	guard.armed = false;
+	if (!pcm.empty()) {
+		co_yield PcmSpan(pcm);
+	}
+}
+
+} // namespace pico
+
+#endif